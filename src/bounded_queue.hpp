@@ -0,0 +1,102 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// thread-safe FIFO with a fixed capacity, used to pass work between pipeline stages
+// producers block while the queue is full and consumers block while it's empty
+// close() wakes everyone up, after which push() fails and pop() drains the remaining items
+template<typename T>
+class BoundedQueue
+{
+private:
+    const size_t capacity;
+
+    std::deque<T> items;
+    bool isClosed{ false };
+
+    mutable std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+
+public:
+    BoundedQueue(size_t capacity)
+        : capacity(capacity)
+    {}
+
+    bool push(T&& item)
+    {
+        std::unique_lock lock(mutex);
+        notFull.wait(lock, [this] { return isClosed || items.size() < capacity; });
+
+        if (isClosed)
+        {
+            return false;
+        }
+
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // returns false once the queue is closed and empty
+    bool pop(T& outItem)
+    {
+        std::unique_lock lock(mutex);
+        notEmpty.wait(lock, [this] { return isClosed || !items.empty(); });
+
+        if (items.empty())
+        {
+            return false;
+        }
+
+        outItem = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    bool tryPop(T& outItem)
+    {
+        std::lock_guard lock(mutex);
+
+        if (items.empty())
+        {
+            return false;
+        }
+
+        outItem = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard lock(mutex);
+        isClosed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    void reopen()
+    {
+        std::lock_guard lock(mutex);
+        items.clear();
+        isClosed = false;
+    }
+
+    bool isFull() const
+    {
+        std::lock_guard lock(mutex);
+        return items.size() >= capacity;
+    }
+
+    // closed with nothing left to pop
+    bool isDrained() const
+    {
+        std::lock_guard lock(mutex);
+        return isClosed && items.empty();
+    }
+};
@@ -94,10 +94,25 @@ namespace ColorUtils
 	// SRGB/LINEAR CONVERSION
 	// ==================================================================
 
-	// TODO: use more accurate approximation?
+	// exact piecewise IEC 61966-2-1 curves, negative values follow the linear segment
+	// device code uses the hardware exp2/log2 based pow, whose error is far below what any 8-bit or half float output can show
+	__host__ __device__ inline float _srgbPow(float x, float y)
+	{
+#ifdef __CUDA_ARCH__
+		return __powf(x, y);
+#else
+		return powf(x, y);
+#endif
+	}
+
+	__host__ __device__ inline float linearToSrgb(float linearVal)
+	{
+		return linearVal <= 0.0031308f ? linearVal * 12.92f : 1.055f * _srgbPow(linearVal, 1.f / 2.4f) - 0.055f;
+	}
+
 	__host__ __device__ inline glm::vec3 linearToSrgb(glm::vec3 linearCol)
 	{
-		return glm::pow(linearCol, glm::vec3(0.454545454545454545454545f));
+		return glm::vec3(linearToSrgb(linearCol.r), linearToSrgb(linearCol.g), linearToSrgb(linearCol.b));
 	}
 
 	__host__ __device__ inline glm::vec4 linearToSrgb(glm::vec4 linearCol)
@@ -105,9 +120,14 @@ namespace ColorUtils
 		return glm::vec4(linearToSrgb(glm::vec3(linearCol)), linearCol.a);
 	}
 
+	__host__ __device__ inline float srgbToLinear(float srgbVal)
+	{
+		return srgbVal <= 0.04045f ? srgbVal * (1.f / 12.92f) : _srgbPow((srgbVal + 0.055f) * (1.f / 1.055f), 2.4f);
+	}
+
 	__host__ __device__ inline glm::vec3 srgbToLinear(glm::vec3 srgbCol)
 	{
-		return glm::pow(srgbCol, glm::vec3(2.2f));
+		return glm::vec3(srgbToLinear(srgbCol.r), srgbToLinear(srgbCol.g), srgbToLinear(srgbCol.b));
 	}
 
 	__host__ __device__ inline glm::vec4 srgbToLinear(glm::vec4 srgbCol)
@@ -207,7 +227,8 @@ namespace ColorUtils
 		// sRGB IEC 61966-2-1 2.2 Exponent Reference EOTF Display
 		// NOTE: We're linearizing the output here. Comment/adjust when
 		// *not* using a sRGB render target
-		val = srgbToLinear(val);
+		// (kept as a pure 2.2 power rather than the piecewise srgbToLinear(), AgX's curve is tuned for it)
+		val = glm::pow(val, glm::vec3(2.2f));
 
 		return val;
 	}
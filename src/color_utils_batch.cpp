@@ -0,0 +1,322 @@
+#include "color_utils_batch.hpp"
+
+#include "thread_utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define COLOR_BATCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define COLOR_BATCH_TARGET_AVX2
+#else
+#define COLOR_BATCH_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#else
+#define COLOR_BATCH_X86 0
+#endif
+
+// pow(x, y) = exp2(y * log2(x)), with both halves as polynomials fitted to minimize relative error
+// log2: exponent from the float bits plus log2(m) = t * P(t) for mantissa m = 1 + t, |error| <= 1.4e-6
+// exp2: 2^floor(y) from the float bits times 2^f = 1 + f * Q(f) for f = fract(y), relative error <= 8.5e-8
+// together that's ln(2) * |y| * 1.4e-6 + 8.5e-8 relative plus rounding, measured at most 3.6e-6 for sRGB's 2.4
+// well under the 1.5e-5 step of 16-bit images, and pow(1, y) is exactly 1 since both polynomials are exact at 0
+namespace
+{
+    constexpr float log2Coeffs[] = {
+        1.44269326f, -0.721162735f, 0.477705938f, -0.339247799f, 0.215588576f, -0.0960662841f, 0.0204903568f
+    };
+
+    constexpr float exp2Coeffs[] = {
+        0.693151363f, 0.240164154f, 0.0558004471f, 0.00901668762f, 0.00186718286f
+    };
+
+    // keeps 2^floor(y) a normal float, results past either end are 0 or huge anyway
+    constexpr float minExp2 = -126.f;
+    constexpr float maxExp2 = 127.99f;
+
+    // same piecewise curve as ColorUtils::srgbToLinear()
+    constexpr float srgbLinearCutoff = 0.04045f;
+    constexpr float srgbLinearScale = 1.f / 12.92f;
+    constexpr float srgbOffset = 0.055f;
+    constexpr float srgbScale = 1.f / 1.055f;
+    constexpr float srgbGamma = 2.4f;
+
+    // ==================================================================
+    // SCALAR
+    // ==================================================================
+
+    float powFast(float x, float exponent)
+    {
+        if (!(x > 0.f))
+        {
+            return 0.f;
+        }
+
+        uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        const float e = (float)((int)((bits >> 23) & 0xff) - 127);
+        bits = (bits & 0x7fffff) | 0x3f800000;
+        float m;
+        std::memcpy(&m, &bits, sizeof(m));
+        const float t = m - 1.f;
+
+        float p = log2Coeffs[6];
+        for (int i = 5; i >= 0; --i)
+        {
+            p = p * t + log2Coeffs[i];
+        }
+
+        const float y = std::clamp(exponent * (e + t * p), minExp2, maxExp2);
+        const float yFloor = std::floor(y);
+        const float f = y - yFloor;
+
+        float q = exp2Coeffs[4];
+        for (int i = 3; i >= 0; --i)
+        {
+            q = q * f + exp2Coeffs[i];
+        }
+
+        uint32_t scaleBits = (uint32_t)((int)yFloor + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &scaleBits, sizeof(scale));
+        return (1.f + f * q) * scale;
+    }
+
+    float srgbToLinearFast(float x)
+    {
+        return x <= srgbLinearCutoff ? x * srgbLinearScale : powFast((x + srgbOffset) * srgbScale, srgbGamma);
+    }
+
+    void srgbToLinearScalar(float* values, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            values[i] = srgbToLinearFast(values[i]);
+        }
+    }
+
+#if COLOR_BATCH_X86
+    // ==================================================================
+    // SSE2 (4 WIDE)
+    // ==================================================================
+
+    inline __m128 powSse2(__m128 x, __m128 exponent)
+    {
+        const __m128 isPositive = _mm_cmpgt_ps(x, _mm_setzero_ps());
+
+        const __m128i bits = _mm_castps_si128(x);
+        const __m128i e = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xff)), _mm_set1_epi32(127));
+        const __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x7fffff)), _mm_set1_epi32(0x3f800000)));
+        const __m128 t = _mm_sub_ps(m, _mm_set1_ps(1.f));
+
+        __m128 p = _mm_set1_ps(log2Coeffs[6]);
+        for (int i = 5; i >= 0; --i)
+        {
+            p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(log2Coeffs[i]));
+        }
+
+        __m128 y = _mm_mul_ps(exponent, _mm_add_ps(_mm_cvtepi32_ps(e), _mm_mul_ps(t, p)));
+        y = _mm_min_ps(_mm_max_ps(y, _mm_set1_ps(minExp2)), _mm_set1_ps(maxExp2));
+
+        // SSE2 has no floor, truncate and step down where that rounded negative values up
+        __m128i yInt = _mm_cvttps_epi32(y);
+        const __m128 roundedUp = _mm_cmpgt_ps(_mm_cvtepi32_ps(yInt), y);
+        yInt = _mm_add_epi32(yInt, _mm_castps_si128(roundedUp)); // mask is -1 where set
+        const __m128 f = _mm_sub_ps(y, _mm_cvtepi32_ps(yInt));
+
+        __m128 q = _mm_set1_ps(exp2Coeffs[4]);
+        for (int i = 3; i >= 0; --i)
+        {
+            q = _mm_add_ps(_mm_mul_ps(q, f), _mm_set1_ps(exp2Coeffs[i]));
+        }
+
+        const __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(yInt, _mm_set1_epi32(127)), 23));
+        const __m128 result = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(1.f), _mm_mul_ps(f, q)), scale);
+        return _mm_and_ps(result, isPositive);
+    }
+
+    inline __m128 srgbToLinearSse2(__m128 x)
+    {
+        const __m128 isLinear = _mm_cmple_ps(x, _mm_set1_ps(srgbLinearCutoff));
+        const __m128 linear = _mm_mul_ps(x, _mm_set1_ps(srgbLinearScale));
+        const __m128 curve = powSse2(_mm_mul_ps(_mm_add_ps(x, _mm_set1_ps(srgbOffset)), _mm_set1_ps(srgbScale)), _mm_set1_ps(srgbGamma));
+        return _mm_or_ps(_mm_and_ps(isLinear, linear), _mm_andnot_ps(isLinear, curve));
+    }
+
+    void srgbToLinearSse2(float* values, size_t count)
+    {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_ps(values + i, srgbToLinearSse2(_mm_loadu_ps(values + i)));
+        }
+
+        // the tail goes through the same path so a value's result doesn't depend on where it lands in the array
+        if (i < count)
+        {
+            alignas(16) float tail[4]{};
+            std::copy(values + i, values + count, tail);
+            _mm_store_ps(tail, srgbToLinearSse2(_mm_load_ps(tail)));
+            std::copy(tail, tail + (count - i), values + i);
+        }
+    }
+
+    // ==================================================================
+    // AVX2 (8 WIDE)
+    // ==================================================================
+
+    COLOR_BATCH_TARGET_AVX2 inline __m256 powAvx2(__m256 x, __m256 exponent)
+    {
+        const __m256 isPositive = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GT_OQ);
+
+        const __m256i bits = _mm256_castps_si256(x);
+        const __m256i e = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(0xff)), _mm256_set1_epi32(127));
+        const __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x7fffff)), _mm256_set1_epi32(0x3f800000)));
+        const __m256 t = _mm256_sub_ps(m, _mm256_set1_ps(1.f));
+
+        __m256 p = _mm256_set1_ps(log2Coeffs[6]);
+        for (int i = 5; i >= 0; --i)
+        {
+            p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(log2Coeffs[i]));
+        }
+
+        __m256 y = _mm256_mul_ps(exponent, _mm256_fmadd_ps(t, p, _mm256_cvtepi32_ps(e)));
+        y = _mm256_min_ps(_mm256_max_ps(y, _mm256_set1_ps(minExp2)), _mm256_set1_ps(maxExp2));
+
+        const __m256 yFloor = _mm256_floor_ps(y);
+        const __m256 f = _mm256_sub_ps(y, yFloor);
+
+        __m256 q = _mm256_set1_ps(exp2Coeffs[4]);
+        for (int i = 3; i >= 0; --i)
+        {
+            q = _mm256_fmadd_ps(q, f, _mm256_set1_ps(exp2Coeffs[i]));
+        }
+
+        const __m256 scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(yFloor), _mm256_set1_epi32(127)), 23));
+        const __m256 result = _mm256_mul_ps(_mm256_fmadd_ps(f, q, _mm256_set1_ps(1.f)), scale);
+        return _mm256_and_ps(result, isPositive);
+    }
+
+    COLOR_BATCH_TARGET_AVX2 inline __m256 srgbToLinearAvx2(__m256 x)
+    {
+        const __m256 isLinear = _mm256_cmp_ps(x, _mm256_set1_ps(srgbLinearCutoff), _CMP_LE_OQ);
+        const __m256 linear = _mm256_mul_ps(x, _mm256_set1_ps(srgbLinearScale));
+        const __m256 curve = powAvx2(_mm256_mul_ps(_mm256_add_ps(x, _mm256_set1_ps(srgbOffset)), _mm256_set1_ps(srgbScale)), _mm256_set1_ps(srgbGamma));
+        return _mm256_blendv_ps(curve, linear, isLinear);
+    }
+
+    COLOR_BATCH_TARGET_AVX2 void srgbToLinearAvx2(float* values, size_t count)
+    {
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            _mm256_storeu_ps(values + i, srgbToLinearAvx2(_mm256_loadu_ps(values + i)));
+        }
+
+        if (i < count)
+        {
+            alignas(32) float tail[8]{};
+            std::copy(values + i, values + count, tail);
+            _mm256_store_ps(tail, srgbToLinearAvx2(_mm256_load_ps(tail)));
+            std::copy(tail, tail + (count - i), values + i);
+        }
+    }
+
+    bool isAvx2Supported()
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+        const bool hasFma = (info[2] & (1 << 12)) != 0;
+        const bool hasOsxsave = (info[2] & (1 << 27)) != 0;
+        const bool hasAvx = (info[2] & (1 << 28)) != 0;
+        if (!hasFma || !hasOsxsave || !hasAvx || (_xgetbv(0) & 0x6) != 0x6) // OS has to save the ymm registers
+        {
+            return false;
+        }
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    }
+#endif
+
+    using BatchFunc = void (*)(float*, size_t);
+
+    BatchFunc chooseSrgbToLinearFunc()
+    {
+#if COLOR_BATCH_X86
+        return isAvx2Supported() ? static_cast<BatchFunc>(srgbToLinearAvx2) : static_cast<BatchFunc>(srgbToLinearSse2);
+#else
+        return srgbToLinearScalar;
+#endif
+    }
+
+    void srgbToLinearBatch(float* values, size_t count)
+    {
+        static const BatchFunc srgbToLinearFunc = chooseSrgbToLinearFunc();
+        srgbToLinearFunc(values, count);
+    }
+}
+
+namespace ColorUtils::Batch
+{
+    void srgbToLinear(float* values, size_t count)
+    {
+        srgbToLinearBatch(values, count);
+    }
+
+    void srgbToLinear(float* pixels, size_t numPixels, int numChannels, uint32_t channelMask)
+    {
+        const uint32_t allChannels = (1u << numChannels) - 1;
+        channelMask &= allChannels;
+        if (channelMask == 0)
+        {
+            return;
+        }
+
+        // converting everything and putting the skipped channels back keeps the whole row in one vectorized call
+        ThreadUtils::ScratchArena& scratchArena = ThreadUtils::getScratchArena();
+        ThreadUtils::ScratchArena::Scope scratchScope(scratchArena);
+        float* skippedValues = scratchArena.allocate<float>(numPixels * numChannels);
+
+        const bool hasSkippedChannels = channelMask != allChannels;
+        if (hasSkippedChannels)
+        {
+            float* skippedValue = skippedValues;
+            for (size_t pixelIdx = 0; pixelIdx < numPixels; ++pixelIdx)
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    if (!(channelMask & (1u << channel)))
+                    {
+                        *skippedValue++ = pixels[pixelIdx * numChannels + channel];
+                    }
+                }
+            }
+        }
+
+        srgbToLinearBatch(pixels, numPixels * numChannels);
+
+        if (hasSkippedChannels)
+        {
+            const float* skippedValue = skippedValues;
+            for (size_t pixelIdx = 0; pixelIdx < numPixels; ++pixelIdx)
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    if (!(channelMask & (1u << channel)))
+                    {
+                        pixels[pixelIdx * numChannels + channel] = *skippedValue++;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// host versions of color_utils.hpp functions for loops over whole images, e.g. converting decoded files
+// vectorized with AVX2 or SSE2, whichever the CPU supports is picked the first time one of them is called
+namespace ColorUtils::Batch
+{
+    // in place, the exact piecewise curve but with a polynomial pow, at most 3.6e-6 relative error
+    void srgbToLinear(float* values, size_t count);
+
+    // interleaved pixels, only channels with their bit set in channelMask are converted (e.g. to skip alpha)
+    void srgbToLinear(float* pixels, size_t numPixels, int numChannels, uint32_t channelMask);
+}
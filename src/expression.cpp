@@ -0,0 +1,510 @@
+#include "expression.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace Expression
+{
+    namespace
+    {
+        struct AstNode
+        {
+            Opcode opcode;
+            float constant{ 0.f };
+            Variable variable{ Variable::A };
+            int children[3]{ -1, -1, -1 };
+            int numChildren{ 0 };
+        };
+
+        struct Function
+        {
+            Opcode opcode;
+            int numArguments;
+        };
+
+        const std::unordered_map<std::string, Function> functions = {
+            { "abs", { Opcode::ABS, 1 } },
+            { "floor", { Opcode::FLOOR, 1 } },
+            { "ceil", { Opcode::CEIL, 1 } },
+            { "fract", { Opcode::FRACT, 1 } },
+            { "sqrt", { Opcode::SQRT, 1 } },
+            { "exp", { Opcode::EXP, 1 } },
+            { "log", { Opcode::LOG, 1 } },
+            { "sin", { Opcode::SIN, 1 } },
+            { "cos", { Opcode::COS, 1 } },
+            { "tan", { Opcode::TAN, 1 } },
+            { "pow", { Opcode::POWER, 2 } },
+            { "min", { Opcode::MIN, 2 } },
+            { "max", { Opcode::MAX, 2 } },
+            { "step", { Opcode::STEP, 2 } },
+            { "clamp", { Opcode::CLAMP, 3 } },
+            { "mix", { Opcode::MIX, 3 } },
+            { "smoothstep", { Opcode::SMOOTHSTEP, 3 } }
+        };
+
+        const std::unordered_map<std::string, float> constants = {
+            { "pi", glm::pi<float>() },
+            { "e", glm::e<float>() }
+        };
+
+        const std::unordered_map<std::string, Variable> positionVariables = {
+            { "x", Variable::X },
+            { "y", Variable::Y },
+            { "u", Variable::U },
+            { "v", Variable::V }
+        };
+
+        // recursive descent, lowest precedence first: comparisons, + -, * /, unary -, ^ (right associative), then operands
+        // errors are thrown as std::runtime_error with a message for the UI
+        class Parser
+        {
+        private:
+            static constexpr int maxDepth = 64; // every level of nesting recurses, so this keeps silly input off the stack
+
+            const std::string& source;
+            size_t pos{ 0 };
+            int depth{ 0 };
+
+        public:
+            std::vector<AstNode> nodes;
+
+            Parser(const std::string& source)
+                : source(source)
+            {}
+
+            int parse()
+            {
+                const int root = parseComparison();
+                skipWhitespace();
+                if (pos < source.size())
+                {
+                    fail("unexpected '" + std::string(1, source[pos]) + "'");
+                }
+                return root;
+            }
+
+        private:
+            [[noreturn]] void fail(const std::string& message) const
+            {
+                throw std::runtime_error(message + " at " + std::to_string(pos + 1));
+            }
+
+            void skipWhitespace()
+            {
+                while (pos < source.size() && std::isspace((unsigned char)source[pos]))
+                {
+                    ++pos;
+                }
+            }
+
+            bool consume(const char* token)
+            {
+                skipWhitespace();
+                const size_t length = strlen(token);
+                if (source.compare(pos, length, token) == 0)
+                {
+                    pos += length;
+                    return true;
+                }
+                return false;
+            }
+
+            void expect(const char* token)
+            {
+                if (!consume(token))
+                {
+                    fail(std::string("expected '") + token + "'");
+                }
+            }
+
+            int addNode(Opcode opcode, std::initializer_list<int> children)
+            {
+                AstNode node{ opcode };
+                for (int child : children)
+                {
+                    node.children[node.numChildren++] = child;
+                }
+                nodes.push_back(node);
+                return (int)nodes.size() - 1;
+            }
+
+            int addConstant(float constant)
+            {
+                AstNode node{ Opcode::CONSTANT };
+                node.constant = constant;
+                nodes.push_back(node);
+                return (int)nodes.size() - 1;
+            }
+
+            int addVariable(Variable variable)
+            {
+                AstNode node{ Opcode::VARIABLE };
+                node.variable = variable;
+                nodes.push_back(node);
+                return (int)nodes.size() - 1;
+            }
+
+            int parseComparison()
+            {
+                int lhs = parseAdditive();
+                while (true)
+                {
+                    // two character operators first so "<=" isn't read as "<"
+                    Opcode opcode;
+                    if (consume("<="))
+                    {
+                        opcode = Opcode::LESS_EQUAL;
+                    }
+                    else if (consume(">="))
+                    {
+                        opcode = Opcode::GREATER_EQUAL;
+                    }
+                    else if (consume("<"))
+                    {
+                        opcode = Opcode::LESS;
+                    }
+                    else if (consume(">"))
+                    {
+                        opcode = Opcode::GREATER;
+                    }
+                    else
+                    {
+                        return lhs;
+                    }
+
+                    lhs = addNode(opcode, { lhs, parseAdditive() });
+                }
+            }
+
+            int parseAdditive()
+            {
+                int lhs = parseMultiplicative();
+                while (true)
+                {
+                    if (consume("+"))
+                    {
+                        lhs = addNode(Opcode::ADD, { lhs, parseMultiplicative() });
+                    }
+                    else if (consume("-"))
+                    {
+                        lhs = addNode(Opcode::SUBTRACT, { lhs, parseMultiplicative() });
+                    }
+                    else
+                    {
+                        return lhs;
+                    }
+                }
+            }
+
+            int parseMultiplicative()
+            {
+                int lhs = parseUnary();
+                while (true)
+                {
+                    if (consume("*"))
+                    {
+                        lhs = addNode(Opcode::MULTIPLY, { lhs, parseUnary() });
+                    }
+                    else if (consume("/"))
+                    {
+                        lhs = addNode(Opcode::DIVIDE, { lhs, parseUnary() });
+                    }
+                    else
+                    {
+                        return lhs;
+                    }
+                }
+            }
+
+            int parseUnary()
+            {
+                if (++depth > maxDepth)
+                {
+                    fail("formula is nested too deeply");
+                }
+
+                int result;
+                if (consume("-"))
+                {
+                    result = addNode(Opcode::NEGATE, { parseUnary() });
+                }
+                else if (consume("+"))
+                {
+                    result = parseUnary();
+                }
+                else
+                {
+                    result = parsePower();
+                }
+
+                --depth;
+                return result;
+            }
+
+            int parsePower()
+            {
+                const int base = parseOperand();
+                if (consume("^"))
+                {
+                    return addNode(Opcode::POWER, { base, parseUnary() }); // so 2^-1 works and a^b^c is a^(b^c)
+                }
+                return base;
+            }
+
+            int parseOperand()
+            {
+                skipWhitespace();
+                if (pos >= source.size())
+                {
+                    fail("unexpected end of formula");
+                }
+
+                const char c = source[pos];
+                if (consume("("))
+                {
+                    const int inner = parseComparison();
+                    expect(")");
+                    return inner;
+                }
+
+                if (std::isdigit((unsigned char)c) || c == '.')
+                {
+                    const char* begin = source.c_str() + pos;
+                    char* end;
+                    const float value = strtof(begin, &end);
+                    if (end == begin)
+                    {
+                        fail("invalid number");
+                    }
+                    pos += end - begin;
+                    return addConstant(value);
+                }
+
+                if (std::isalpha((unsigned char)c) || c == '_')
+                {
+                    const size_t start = pos;
+                    while (pos < source.size() && (std::isalnum((unsigned char)source[pos]) || source[pos] == '_'))
+                    {
+                        ++pos;
+                    }
+                    return parseIdentifier(source.substr(start, pos - start), start);
+                }
+
+                fail("unexpected '" + std::string(1, c) + "'");
+            }
+
+            int parseIdentifier(const std::string& name, size_t start)
+            {
+                if (const auto function = functions.find(name); function != functions.end())
+                {
+                    expect("(");
+                    int arguments[3];
+                    for (int argumentIdx = 0; argumentIdx < function->second.numArguments; ++argumentIdx)
+                    {
+                        if (argumentIdx > 0)
+                        {
+                            expect(",");
+                        }
+                        arguments[argumentIdx] = parseComparison();
+                    }
+                    if (!consume(")"))
+                    {
+                        fail("'" + name + "' takes " + std::to_string(function->second.numArguments) + " argument(s)");
+                    }
+
+                    AstNode node{ function->second.opcode };
+                    node.numChildren = function->second.numArguments;
+                    std::copy(arguments, arguments + node.numChildren, node.children);
+                    nodes.push_back(node);
+                    return (int)nodes.size() - 1;
+                }
+
+                if (const auto constant = constants.find(name); constant != constants.end())
+                {
+                    return addConstant(constant->second);
+                }
+
+                if (const auto variable = positionVariables.find(name); variable != positionVariables.end())
+                {
+                    return addVariable(variable->second);
+                }
+
+                if (name == "a" || name == "b" || name == "c")
+                {
+                    const int inputIdx = name[0] - 'a';
+                    int channel = 0; // luminance
+                    if (consume("."))
+                    {
+                        skipWhitespace();
+                        static const std::string channelNames = "rgba";
+                        const size_t channelIdx = pos < source.size() ? channelNames.find(source[pos]) : std::string::npos;
+                        if (channelIdx == std::string::npos || (pos + 1 < source.size() && std::isalnum((unsigned char)source[pos + 1])))
+                        {
+                            fail("expected one of r, g, b, a after '" + name + ".'");
+                        }
+                        ++pos;
+                        channel = (int)channelIdx + 1;
+                    }
+                    return addVariable((Variable)(inputIdx * numVariablesPerInput + channel));
+                }
+
+                pos = start;
+                fail("unknown name '" + name + "'");
+            }
+        };
+
+        bool isConstant(const AstNode& node)
+        {
+            return node.opcode == Opcode::CONSTANT;
+        }
+
+        // folds operations whose operands are all constants, bottom up since children always come before their parents
+        void foldConstants(std::vector<AstNode>& nodes)
+        {
+            for (AstNode& node : nodes)
+            {
+                if (node.numChildren == 0)
+                {
+                    continue;
+                }
+
+                float operands[3]{};
+                bool areOperandsConstant = true;
+                for (int childIdx = 0; childIdx < node.numChildren; ++childIdx)
+                {
+                    const AstNode& child = nodes[node.children[childIdx]];
+                    areOperandsConstant &= isConstant(child);
+                    operands[childIdx] = child.constant;
+                }
+
+                if (areOperandsConstant)
+                {
+                    node.constant = apply(node.opcode, operands[0], operands[1], operands[2]);
+                    node.opcode = Opcode::CONSTANT;
+                    node.numChildren = 0;
+                }
+            }
+        }
+
+        // a node's result goes in register dst and its children use the registers above it, like a stack
+        // children needing more registers go first, so a node needs at most one more register than its hungriest child
+        class CodeGenerator
+        {
+        private:
+            const std::vector<AstNode>& nodes;
+            std::vector<int> registerNeeds;
+            Program& program;
+
+        public:
+            CodeGenerator(const std::vector<AstNode>& nodes, Program& program)
+                : nodes(nodes), registerNeeds(nodes.size()), program(program)
+            {
+                for (int nodeIdx = 0; nodeIdx < nodes.size(); ++nodeIdx)
+                {
+                    const AstNode& node = nodes[nodeIdx];
+                    int childNeeds[3];
+                    for (int childIdx = 0; childIdx < node.numChildren; ++childIdx)
+                    {
+                        childNeeds[childIdx] = registerNeeds[node.children[childIdx]];
+                    }
+                    std::sort(childNeeds, childNeeds + node.numChildren, std::greater<int>());
+
+                    int need = 1;
+                    for (int orderIdx = 0; orderIdx < node.numChildren; ++orderIdx)
+                    {
+                        need = std::max(need, childNeeds[orderIdx] + orderIdx);
+                    }
+                    registerNeeds[nodeIdx] = need;
+                }
+            }
+
+            int getRegisterNeed(int nodeIdx) const
+            {
+                return registerNeeds[nodeIdx];
+            }
+
+            void generate(int nodeIdx, int dst)
+            {
+                const AstNode& node = nodes[nodeIdx];
+
+                Instruction instruction{ node.opcode, (uint8_t)dst, { 0, 0, 0 }, 0.f };
+                if (node.opcode == Opcode::CONSTANT)
+                {
+                    instruction.constant = node.constant;
+                }
+                else if (node.opcode == Opcode::VARIABLE)
+                {
+                    instruction.src[0] = (uint8_t)node.variable;
+                    const int variableIdx = (int)node.variable;
+                    if (variableIdx < numInputs * numVariablesPerInput)
+                    {
+                        program.inputMask |= 1u << (variableIdx / numVariablesPerInput);
+                        const int channel = variableIdx % numVariablesPerInput;
+                        program.inputChannels[variableIdx / numVariablesPerInput] |= channel == 0 ? Channels::RGB : (uint8_t)(Channels::R << (channel - 1));
+                    }
+                    else
+                    {
+                        program.readsPosition = true;
+                    }
+                }
+                else
+                {
+                    // operands are evaluated in order of need, but each still lands in its own register above dst
+                    int order[3] = { 0, 1, 2 };
+                    std::sort(order, order + node.numChildren, [&](int lhs, int rhs)
+                    {
+                        return registerNeeds[node.children[lhs]] > registerNeeds[node.children[rhs]];
+                    });
+
+                    for (int orderIdx = 0; orderIdx < node.numChildren; ++orderIdx)
+                    {
+                        const int childIdx = order[orderIdx];
+                        generate(node.children[childIdx], dst + orderIdx);
+                        instruction.src[childIdx] = (uint8_t)(dst + orderIdx);
+                    }
+                }
+
+                if (program.numInstructions >= maxInstructions)
+                {
+                    throw std::runtime_error("formula is too long");
+                }
+                program.instructions[program.numInstructions++] = instruction;
+            }
+        };
+    }
+
+    bool compile(const std::string& source, Program& program, std::string& error)
+    {
+        program = Program();
+
+        try
+        {
+            Parser parser(source);
+            const int root = parser.parse();
+            foldConstants(parser.nodes);
+
+            CodeGenerator generator(parser.nodes, program);
+            if (generator.getRegisterNeed(root) > maxRegisters)
+            {
+                throw std::runtime_error("formula is nested too deeply");
+            }
+            generator.generate(root, 0);
+        }
+        catch (const std::runtime_error& e)
+        {
+            program = Program();
+            error = e.what();
+            return false;
+        }
+
+        error.clear();
+        return true;
+    }
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include "cuda_includes.hpp"
+
+#include "color_utils.hpp"
+#include "texture.hpp"
+
+#include <cstdint>
+#include <string>
+
+// per pixel formulas, parsed and compiled on the host into a short register program that kernels interpret
+// every thread of a launch runs the same instruction at the same time, so the interpreter's switch never diverges
+namespace Expression
+{
+    static constexpr int maxInstructions = 64;
+    static constexpr int maxRegisters = 16;
+    static constexpr int numInputs = 3; // a, b, c
+
+    enum class Opcode : uint8_t
+    {
+        CONSTANT, VARIABLE,
+        NEGATE, ABS, FLOOR, CEIL, FRACT, SQRT, EXP, LOG, SIN, COS, TAN,
+        ADD, SUBTRACT, MULTIPLY, DIVIDE, POWER, MIN, MAX, LESS, GREATER, LESS_EQUAL, GREATER_EQUAL, STEP,
+        CLAMP, MIX, SMOOTHSTEP
+    };
+
+    // an input's value is its luminance, channels are read separately as e.g. a.r
+    enum class Variable : uint8_t
+    {
+        A, A_R, A_G, A_B, A_A,
+        B, B_R, B_G, B_B, B_A,
+        C, C_R, C_G, C_B, C_A,
+        X, Y, U, V
+    };
+
+    static constexpr int numVariablesPerInput = 5;
+
+    struct Instruction
+    {
+        Opcode opcode;
+        uint8_t dst;
+        uint8_t src[3]; // registers, or the Variable for Opcode::VARIABLE
+        float constant; // for Opcode::CONSTANT
+    };
+
+    struct Program
+    {
+        Instruction instructions[maxInstructions];
+        int numInstructions{ 0 };
+        uint32_t inputMask{ 0 }; // bit i is set iff input i is read, so unused inputs aren't fetched
+        uint8_t inputChannels[numInputs]{}; // Channels read from each input, luminance needs RGB
+        bool readsPosition{ false }; // x, y, u, or v, without them a formula over uniform inputs is uniform too
+    };
+
+    // false with a message for the UI if source isn't a valid formula, program is left empty in that case
+    bool compile(const std::string& source, Program& program, std::string& error);
+
+    // shared by the interpreter and constant folding, so folded constants match what a kernel would compute
+    __host__ __device__ inline float apply(Opcode opcode, float a, float b, float c)
+    {
+        switch (opcode)
+        {
+        case Opcode::NEGATE:
+            return -a;
+        case Opcode::ABS:
+            return fabsf(a);
+        case Opcode::FLOOR:
+            return floorf(a);
+        case Opcode::CEIL:
+            return ceilf(a);
+        case Opcode::FRACT:
+            return a - floorf(a);
+        case Opcode::SQRT:
+            return sqrtf(fmaxf(a, 0.f));
+        case Opcode::EXP:
+            return expf(a);
+        case Opcode::LOG:
+            return logf(a);
+        case Opcode::SIN:
+            return sinf(a);
+        case Opcode::COS:
+            return cosf(a);
+        case Opcode::TAN:
+            return tanf(a);
+        case Opcode::ADD:
+            return a + b;
+        case Opcode::SUBTRACT:
+            return a - b;
+        case Opcode::MULTIPLY:
+            return a * b;
+        case Opcode::DIVIDE:
+            return b == 0.f ? 0.f : a / b; // same as the math node
+        case Opcode::POWER:
+            return powf(a, b);
+        case Opcode::MIN:
+            return fminf(a, b);
+        case Opcode::MAX:
+            return fmaxf(a, b);
+        case Opcode::LESS:
+            return a < b ? 1.f : 0.f;
+        case Opcode::GREATER:
+            return a > b ? 1.f : 0.f;
+        case Opcode::LESS_EQUAL:
+            return a <= b ? 1.f : 0.f;
+        case Opcode::GREATER_EQUAL:
+            return a >= b ? 1.f : 0.f;
+        case Opcode::STEP:
+            return b < a ? 0.f : 1.f;
+        case Opcode::CLAMP:
+            return fminf(fmaxf(a, b), c);
+        case Opcode::MIX:
+            return a + (b - a) * c;
+        case Opcode::SMOOTHSTEP:
+        {
+            const float t = fminf(fmaxf((c - a) / (b - a), 0.f), 1.f);
+            return t * t * (3.f - 2.f * t);
+        }
+        default:
+            return 0.f;
+        }
+    }
+
+    // everything a program can read at one pixel
+    struct Variables
+    {
+        glm::vec4 inputs[numInputs];
+        glm::vec2 position; // in full resolution pixels
+        glm::vec2 uv;
+    };
+
+    __host__ __device__ inline float readVariable(const Variables& variables, Variable variable)
+    {
+        const int idx = (int)variable;
+        if (idx >= numInputs * numVariablesPerInput)
+        {
+            switch (variable)
+            {
+            case Variable::X:
+                return variables.position.x;
+            case Variable::Y:
+                return variables.position.y;
+            case Variable::U:
+                return variables.uv.x;
+            default:
+                return variables.uv.y;
+            }
+        }
+
+        const glm::vec4 col = variables.inputs[idx / numVariablesPerInput];
+        const int channel = idx % numVariablesPerInput;
+        if (channel == 0)
+        {
+            return ColorUtils::luminance(col);
+        }
+
+        return col[channel - 1];
+    }
+
+    // the result is always left in register 0
+    __host__ __device__ inline float run(const Program& program, const Variables& variables)
+    {
+        float registers[maxRegisters];
+        for (int instructionIdx = 0; instructionIdx < program.numInstructions; ++instructionIdx)
+        {
+            const Instruction& instruction = program.instructions[instructionIdx];
+            float result;
+            if (instruction.opcode == Opcode::CONSTANT)
+            {
+                result = instruction.constant;
+            }
+            else if (instruction.opcode == Opcode::VARIABLE)
+            {
+                result = readVariable(variables, (Variable)instruction.src[0]);
+            }
+            else
+            {
+                result = apply(instruction.opcode, registers[instruction.src[0]], registers[instruction.src[1]], registers[instruction.src[2]]);
+            }
+            registers[instruction.dst] = result;
+        }
+
+        return registers[0];
+    }
+}
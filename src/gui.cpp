@@ -11,15 +11,18 @@
 
 #include "nodes/all_nodes.hpp"
 
+#include "image_io/texture_readback.hpp"
+
 #include "portable_file_dialogs.h"
-#include "stb_image_write.h"
 #include <filesystem>
+#include <chrono>
 
 void Gui::setupNodeCreators()
 {
     nodeCreators = {
         { "color", std::make_unique<NodeColor> },
         { "file input", std::make_unique<NodeFileInput> },
+        { "EXR input", std::make_unique<NodeExrInput> },
         { "invert", std::make_unique<NodeInvert> },
         { "mix", std::make_unique<NodeMix> },
         { "noise", std::make_unique<NodeNoise> },
@@ -34,7 +37,8 @@ void Gui::setupNodeCreators()
         { "separate RGB", []() { return std::make_unique<NodeSeparateComponents<ComponentsType::RGB>>("separate RGB"); }},
         { "separate HSV", []() { return std::make_unique<NodeSeparateComponents<ComponentsType::HSV>>("separate HSV"); }},
         { "math", std::make_unique<NodeMath> },
-        { "color ramp", std::make_unique<NodeColorRamp> }
+        { "color ramp", std::make_unique<NodeColorRamp> },
+        { "expression", std::make_unique<NodeExpression> }
     };
 
     struct
@@ -102,6 +106,7 @@ void Gui::init(GLFWwindow* window)
     addNode(std::make_unique<NodeToneMapping>());
 
     this->nodeEvaluator.setOutputNode(this->outputNode);
+    this->nodeEvaluator.startWorker();
 }
 
 void Gui::setupStyle()
@@ -198,6 +203,9 @@ void Gui::setupStyle()
 
 void Gui::deinit()
 {
+    stopSequence();
+    nodeEvaluator.stopWorker();
+
     NodeBloom::freeDeviceMemory(); // not sure if this is the right place to call this but whatever
     NodePaintinator::freeDeviceMemory();
 
@@ -222,6 +230,9 @@ int Gui::addNode(std::unique_ptr<Node> node)
 
 void Gui::addEdge(int startPinId, int endPinId)
 {
+    nodeEvaluator.cancelEvaluation(); // the worker reads edges
+    nodeEvaluator.invalidateGraph();
+
     Pin& startPin = getPin(startPinId);
     Pin& endPin = getPin(endPinId);
 
@@ -245,8 +256,15 @@ void Gui::deleteNode(int nodeId)
         return;
     }
 
+    nodeEvaluator.cancelEvaluation();
+
     const auto& node = this->nodes[nodeId];
 
+    if (node.get() == sequenceInputNode)
+    {
+        stopSequence();
+    }
+
     for (auto& inputPin : node->inputPins)
     {
         deletePinEdges(inputPin);
@@ -257,6 +275,8 @@ void Gui::deleteNode(int nodeId)
         deletePinEdges(outputPin);
     }
 
+    nodeEvaluator.applyChangedNodes(); // deleting edges marked this node as changed
+    nodeEvaluator.discardStashedResults(node.get()); // its results can't be asked for again
     this->nodes.erase(nodeId);
 }
 
@@ -267,6 +287,8 @@ void Gui::deleteEdge(int edgeId)
 
 void Gui::deleteEdge(Edge* edge)
 {
+    nodeEvaluator.cancelEvaluation();
+    nodeEvaluator.invalidateGraph();
     nodeEvaluator.setChangedNode(edge->endPin->getNode());
 
     edge->startPin->removeEdge(edge);
@@ -293,6 +315,13 @@ void Gui::deletePinEdges(Pin& pin)
 
 void Gui::saveImage()
 {
+    nodeEvaluator.cancelEvaluation(); // the output texture can't change while it's being read back
+
+    if (!nodeEvaluator.isOutputComplete())
+    {
+        evaluateNetwork(); // the viewer may only have needed a proxy or part of the image
+    }
+
     Texture* outputTex = nodeEvaluator.getOutputTexture();
 
     if (outputTex == nullptr || outputTex->isUniform())
@@ -300,45 +329,406 @@ void Gui::saveImage()
         return;
     }
 
-    int numPixels = outputTex->resolution.x * outputTex->resolution.y;
-    float* host_floatPixels = new float[numPixels * 4];
-    uint8_t* host_charPixels = new uint8_t[numPixels * 4];
+    const std::string extension = ImageWriter::getExtension(exportOptions.format);
+    const std::string filterName = std::string("Image Files (") + extension + ")";
 
-    CUDA_CHECK(cudaMemcpy(host_floatPixels, outputTex->getDevPixels<TextureType::MULTI>(), numPixels * 4 * sizeof(float), cudaMemcpyDeviceToHost));
-    for (int i = 0; i < numPixels * 4; ++i)
+    std::string fileName = pfd::save_file("Save", "", { filterName, "*" + extension }).result();
+    if (fileName == "")
     {
-        host_charPixels[i] = min((int)(host_floatPixels[i] * 255.99f), 255);
+        return;
     }
 
-    delete[] host_floatPixels;
+    if (std::filesystem::path(fileName).extension().string() != extension)
+    {
+        fileName += extension;
+    }
 
-    std::string fileName = pfd::save_file("Save", "", { "Image Files (.png)", "*.png" }).result();
-    if (fileName == "")
+    const glm::ivec2 resolution = outputTex->resolution;
+
+    bool didSave;
+    if (exportOptions.format == ImageFormat::EXR)
+    {
+        auto host_pixels = std::make_unique<float[]>(outputTex->getNumPixels() * 4);
+        TextureReadback::readLinear(outputTex, host_pixels.get());
+
+        didSave = ImageWriter::writeExr(fileName, resolution, host_pixels.get(), exportOptions.exrHalf, exportOptions.exrCompression);
+    }
+    else
+    {
+        auto host_pixels = std::make_unique<uint8_t[]>(outputTex->getNumPixels() * 4);
+        TextureReadback::readLdr(outputTex, host_pixels.get());
+
+        if (exportOptions.format == ImageFormat::PNG)
+        {
+            didSave = ImageWriter::writePng(fileName, resolution, host_pixels.get());
+        }
+        else
+        {
+            didSave = ImageWriter::writeJpeg(fileName, resolution, host_pixels.get(), exportOptions.jpegQuality);
+        }
+    }
+
+    if (!didSave)
     {
+        fprintf(stderr, "ERR : failed to save %s\n", fileName.c_str());
+    }
+}
+
+void Gui::drawExportSettings()
+{
+    int selectedFormat = (int)exportOptions.format;
+    if (ImGui::Combo("format", &selectedFormat, ImageWriter::formatNames.data(), ImageWriter::formatNames.size()))
+    {
+        exportOptions.format = (ImageFormat)selectedFormat;
+    }
+
+    switch (exportOptions.format)
+    {
+    case ImageFormat::JPEG:
+        ImGui::SliderInt("quality", &exportOptions.jpegQuality, 1, 100);
+        break;
+    case ImageFormat::EXR:
+    {
+        ImGui::Checkbox("half float", &exportOptions.exrHalf);
+
+        const auto& compressionTypes = ImageWriter::exrCompressionTypes;
+        int selectedCompression = std::find(compressionTypes.begin(), compressionTypes.end(), exportOptions.exrCompression) - compressionTypes.begin();
+        if (ImGui::Combo("compression", &selectedCompression, ImageWriter::exrCompressionNames.data(), ImageWriter::exrCompressionNames.size()))
+        {
+            exportOptions.exrCompression = compressionTypes[selectedCompression];
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// ================================================================================
+// SEQUENCES
+// ================================================================================
+
+void Gui::startSequence()
+{
+    stopSequence();
+
+    // frames go to the selected file input node, or any file input node if none is selected
+    const int numSelectedNodes = ImNodes::NumSelectedNodes();
+    std::vector<int> selectedNodes(numSelectedNodes);
+    if (numSelectedNodes > 0)
+    {
+        ImNodes::GetSelectedNodes(selectedNodes.data());
+    }
+
+    NodeFileInput* inputNode = nullptr;
+    for (int nodeId : selectedNodes)
+    {
+        inputNode = dynamic_cast<NodeFileInput*>(this->nodes[nodeId].get());
+        if (inputNode != nullptr)
+        {
+            break;
+        }
+    }
+
+    for (auto it = this->nodes.begin(); inputNode == nullptr && it != this->nodes.end(); ++it)
+    {
+        inputNode = dynamic_cast<NodeFileInput*>(it->second.get());
+    }
+
+    if (inputNode == nullptr)
+    {
+        fprintf(stderr, "ERR : processing a sequence requires a file input node\n");
+        return;
+    }
+
+    std::vector<std::string> inputPaths = pfd::open_file("Select Frames", "", { "Image Files (.png, .jpg, .jpeg, .exr)", "*.png *.jpg *.jpeg *.exr" }, pfd::opt::multiselect).result();
+    if (inputPaths.empty())
+    {
+        return;
+    }
+
+    std::string outputDirectory = pfd::select_folder("Output Folder").result();
+    if (outputDirectory == "")
+    {
+        return;
+    }
+
+    std::sort(inputPaths.begin(), inputPaths.end());
+
+    if (!sequenceProcessor.start(inputPaths, outputDirectory, inputNode->getReadOptions(), exportOptions))
+    {
+        this->sequenceResultText = "not started, some frames share a name and would overwrite each other's output";
         return;
     }
 
-    if (std::filesystem::path(fileName).extension().string() != ".png")
+    this->sequenceInputNode = inputNode;
+    this->sequenceResultText.clear();
+}
+
+// evaluates as many decoded frames as possible within a time budget so the UI stays responsive
+void Gui::stepSequence()
+{
+    constexpr auto stepBudget = std::chrono::milliseconds(50);
+    const auto stepStart = std::chrono::steady_clock::now();
+
+    const ImageWriteOptions& writeOptions = sequenceProcessor.getWriteOptions();
+
+    nodeEvaluator.cancelEvaluation(); // frames are evaluated on this thread so they can be read back right away
+
+    SequenceFrame frame;
+    while (sequenceProcessor.canPushOutputFrame() && sequenceProcessor.tryPopDecodedFrame(frame))
+    {
+        sequenceInputNode->setSequenceFrame(std::move(frame.image));
+        nodeEvaluator.setChangedNode(sequenceInputNode);
+        evaluateNetwork();
+
+        Texture* outputTex = nodeEvaluator.getOutputTexture();
+        if (outputTex != nullptr && !outputTex->isUniform())
+        {
+            SequenceOutputFrame outputFrame;
+            outputFrame.frameIdx = frame.frameIdx;
+            outputFrame.resolution = outputTex->resolution;
+
+            if (writeOptions.format == ImageFormat::EXR)
+            {
+                outputFrame.linearPixels = std::make_unique<float[]>(outputTex->getNumPixels() * 4);
+                TextureReadback::readLinear(outputTex, outputFrame.linearPixels.get());
+            }
+            else
+            {
+                outputFrame.ldrPixels = std::make_unique<uint8_t[]>(outputTex->getNumPixels() * 4);
+                TextureReadback::readLdr(outputTex, outputFrame.ldrPixels.get());
+            }
+
+            sequenceProcessor.pushOutputFrame(std::move(outputFrame));
+        }
+        else
+        {
+            sequenceProcessor.skipOutputFrame(frame.frameIdx);
+        }
+
+        if (std::chrono::steady_clock::now() - stepStart > stepBudget)
+        {
+            break;
+        }
+    }
+
+    sequenceProcessor.finishOutputIfDecodeDone();
+
+    if (sequenceProcessor.isDone())
     {
-        fileName += ".png";
+        const std::string failureText = sequenceProcessor.getFailureText();
+        if (!failureText.empty())
+        {
+            this->sequenceResultText = "wrote " + std::to_string(sequenceProcessor.getNumFramesWritten()) + " / "
+                + std::to_string(sequenceProcessor.getNumFrames()) + " frames, " + failureText;
+        }
+
+        stopSequence();
     }
+}
 
-    stbi_write_png(fileName.c_str(), outputTex->resolution.x, outputTex->resolution.y, 4, host_charPixels, outputTex->resolution.x * 4);
+void Gui::stopSequence()
+{
+    sequenceProcessor.stop();
 
-    delete[] host_charPixels;
+    if (sequenceInputNode != nullptr)
+    {
+        nodeEvaluator.cancelEvaluation();
+        sequenceInputNode->clearSequenceFrame();
+        nodeEvaluator.setChangedNode(sequenceInputNode);
+        isNetworkDirty = true;
+
+        sequenceInputNode = nullptr;
+    }
+}
+
+void Gui::drawSequenceProgress()
+{
+    if (!sequenceProcessor.getIsActive() && this->sequenceResultText.empty())
+    {
+        return;
+    }
+
+    ImGui::Begin("Sequence", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoDocking);
+
+    if (!sequenceProcessor.getIsActive()) // finished with failed frames, or couldn't start
+    {
+        ImGui::Text("%s", this->sequenceResultText.c_str());
+        if (ImGui::Button("ok"))
+        {
+            this->sequenceResultText.clear();
+        }
+
+        ImGui::End();
+        return;
+    }
+
+    // failed frames count towards the bar so it still fills up, but they're listed so a partial export doesn't look complete
+    const int numFrames = sequenceProcessor.getNumFrames();
+    const int numFramesWritten = sequenceProcessor.getNumFramesWritten();
+    std::string progressText = std::to_string(numFramesWritten) + " / " + std::to_string(numFrames) + " frames";
+    const std::string failureText = sequenceProcessor.getFailureText();
+    if (!failureText.empty())
+    {
+        progressText += " (" + failureText + ")";
+    }
+    ImGui::ProgressBar(sequenceProcessor.getNumFramesFinished() / (float)numFrames, ImVec2(300, 0), progressText.c_str());
+
+    if (ImGui::Button("cancel"))
+    {
+        stopSequence();
+    }
+
+    ImGui::End();
+}
+
+// the worker must be idle, parameters are copied here so evaluation never reads anything the UI is editing
+ImageRegion Gui::prepareEvaluation(int proxyLevel, bool isLimitedToViewer)
+{
+    isNetworkDirty = false;
+    needsFullResPass = proxyLevel > 0;
+    for (const auto& [id, node] : nodes)
+    {
+        node->snapshotParameters();
+    }
+    nodeEvaluator.setProxyLevel(proxyLevel); // pins cache each level separately, so switching levels keeps both sets of caches
+
+    // the viewer region is empty until the viewer has been drawn once
+    const ImageRegion& viewerRegion = nodeEvaluator.getViewerRegion();
+    return isLimitedToViewer && !viewerRegion.isEmpty() ? viewerRegion : ImageRegion::unbounded();
+}
+
+// blocks until the output is ready, for anything that reads it back
+void Gui::evaluateNetwork(int proxyLevel, bool isLimitedToViewer)
+{
+    nodeEvaluator.cancelEvaluation();
+    nodeEvaluator.evaluate(prepareEvaluation(proxyLevel, isLimitedToViewer));
+}
+
+void Gui::submitNetwork(int proxyLevel, bool isLimitedToViewer)
+{
+    nodeEvaluator.submit(prepareEvaluation(proxyLevel, isLimitedToViewer));
+}
+
+void Gui::setOutputResolution(glm::ivec2 outputResolution)
+{
+    nodeEvaluator.cancelEvaluation();
+    nodeEvaluator.setOutputResolution(outputResolution);
+
+    // every cached texture may depend on the output resolution (e.g. uv gradient)
+    for (const auto& [id, node] : nodes)
+    {
+        nodeEvaluator.setChangedNode(node.get());
+    }
+    nodeEvaluator.releaseUnusedTextures();
+
+    isNetworkDirty = true;
+}
+
+void Gui::drawResolutionSettings()
+{
+    ImGui::InputInt2("size", glm::value_ptr(editedOutputResolution));
+    editedOutputResolution = glm::clamp(editedOutputResolution, glm::ivec2(1), glm::ivec2(16384));
+
+    ImGui::BeginDisabled(editedOutputResolution == nodeEvaluator.getOutputResolution());
+    if (ImGui::Button("apply"))
+    {
+        setOutputResolution(editedOutputResolution);
+    }
+    ImGui::EndDisabled();
+}
+
+void Gui::drawMemorySettings()
+{
+    int memoryBudgetMb = (int)(nodeEvaluator.getMemoryBudget() >> 20);
+    ImGui::SetNextItemWidth(120);
+    if (ImGui::InputInt("budget (MB)", &memoryBudgetMb, 256, 1024))
+    {
+        nodeEvaluator.setMemoryBudget((size_t)std::max(memoryBudgetMb, 64) << 20);
+    }
+
+    const std::vector<TextureBucketUsage> usage = nodeEvaluator.getTextureUsage();
+
+    size_t totalBytes = 0;
+    for (const auto& bucketUsage : usage)
+    {
+        totalBytes += bucketUsage.numBytes;
+    }
+    ImGui::Text("using %.1f MB", totalBytes / (1024.f * 1024.f));
+
+    const BufferPlanSummary planSummary = nodeEvaluator.getBufferPlanSummary();
+    ImGui::Text("last evaluation: %d outputs in %d planned buffers, %.1f MB", planSummary.numPlannedOutputs, planSummary.numBuffers, planSummary.peakBytes / (1024.f * 1024.f));
+
+    if (ImGui::BeginTable("textureUsage", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit))
+    {
+        ImGui::TableSetupColumn("resolution");
+        ImGui::TableSetupColumn("in use / total");
+        ImGui::TableSetupColumn("MB");
+        ImGui::TableHeadersRow();
+
+        for (const auto& bucketUsage : usage)
+        {
+            if (bucketUsage.resolution.x == 0)
+            {
+                continue; // uniform textures don't use device memory
+            }
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%d x %d", bucketUsage.resolution.x, bucketUsage.resolution.y);
+            ImGui::TableNextColumn();
+            ImGui::Text("%d / %d", bucketUsage.numTexturesInUse, bucketUsage.numTextures);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", bucketUsage.numBytes / (1024.f * 1024.f));
+        }
+
+        ImGui::EndTable();
+    }
 }
 
 void Gui::render()
 {
+    if (sequenceProcessor.getIsActive())
+    {
+        stepSequence();
+    }
+
+    // ImGui state here is from the previous frame, which is when any parameter changes happened
+    constexpr auto refineDelay = std::chrono::milliseconds(150);
+    const auto now = std::chrono::steady_clock::now();
+    const bool isDraggingParameter = ImGui::IsAnyItemActive();
+
+    // evaluation runs on a worker, edits made while it's busy pile up and are evaluated together once it's free
+    const bool isEvaluatorBusy = nodeEvaluator.isBusy();
+
     if (isNetworkDirty)
     {
-        isNetworkDirty = false;
-        for (const auto& [id, node] : nodes)
+        if (isEvaluatorBusy)
+        {
+            // full resolution passes are obsolete as soon as anything changes
+            // proxy passes are cheap, so they're left to finish and keep frames coming while dragging
+            if (nodeEvaluator.getProxyLevel() == 0)
+            {
+                nodeEvaluator.requestCancel();
+            }
+        }
+        else if (isDraggingParameter && interactiveProxyLevel > 0)
+        {
+            submitNetwork(interactiveProxyLevel, true);
+            lastProxyEvaluationTime = now;
+        }
+        else
         {
-            node->setIsBeingEvaluated(false); // set to true for reachable nodes in nodeEvaluator::evalute()
+            submitNetwork(0, true);
         }
-        nodeEvaluator.evaluate();
     }
+    else if (needsFullResPass && !isEvaluatorBusy && (!isDraggingParameter || now - lastProxyEvaluationTime > refineDelay))
+    {
+        submitNetwork(0, true); // only nodes downstream of the change are recomputed, full resolution caches upstream are still valid
+    }
+
+    nodeEvaluator.updateViewerTexture();
 
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
@@ -358,6 +748,46 @@ void Gui::render()
                 saveImage();
             }
 
+            if (ImGui::BeginMenu("Export Settings"))
+            {
+                drawExportSettings();
+                ImGui::EndMenu();
+            }
+
+            ImGui::Separator();
+
+            if (ImGui::MenuItem("Process Sequence...", nullptr, false, !sequenceProcessor.getIsActive()))
+            {
+                startSequence(); // frames are written using the current export settings
+            }
+
+            ImGui::EndMenu();
+        }
+
+        if (ImGui::BeginMenu("View"))
+        {
+            bool isViewerDownsampled = nodeEvaluator.getIsViewerDownsampled();
+            if (ImGui::MenuItem("Downsample Viewer", nullptr, &isViewerDownsampled)) // 8-bit at on-screen size, cheaper to read back and upload
+            {
+                nodeEvaluator.setIsViewerDownsampled(isViewerDownsampled);
+            }
+
+            static const std::vector<const char*> proxyLevelNames = { "off", "1/2", "1/4", "1/8" };
+            ImGui::SetNextItemWidth(80);
+            ImGui::Combo("Interactive Proxy", &interactiveProxyLevel, proxyLevelNames.data(), proxyLevelNames.size()); // resolution while dragging parameters
+
+            if (ImGui::BeginMenu("Output Resolution"))
+            {
+                drawResolutionSettings();
+                ImGui::EndMenu();
+            }
+
+            if (ImGui::BeginMenu("Texture Memory"))
+            {
+                drawMemorySettings();
+                ImGui::EndMenu();
+            }
+
             ImGui::EndMenu();
         }
 
@@ -415,6 +845,7 @@ void Gui::render()
     // ================================================================================
 
     updateNodeCreatorWindow();
+    drawSequenceProgress();
 
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -432,29 +863,89 @@ void Gui::drawOutputImageViewer()
         return;
     }
 
-    ImVec2 contentSize = ImGui::GetContentRegionAvail();
+    const ImVec2 contentMin = ImGui::GetCursorScreenPos();
+    const ImVec2 contentSize = ImGui::GetContentRegionAvail();
+    if (contentSize.x <= 0.f || contentSize.y <= 0.f)
+    {
+        return;
+    }
+
     float contentAspectRatio = contentSize.y / contentSize.x;
 
-    float imageAspectRatio = nodeEvaluator.outputResolution.y / (float)nodeEvaluator.outputResolution.x;
+    const glm::ivec2 outputResolution = nodeEvaluator.getOutputResolution();
+    float imageAspectRatio = outputResolution.y / (float)outputResolution.x;
 
-    ImVec2 imageSize;
+    glm::vec2 fitSize;
     if (contentAspectRatio < imageAspectRatio)
     {
-        imageSize.y = contentSize.y;
-        imageSize.x = imageSize.y / imageAspectRatio;
+        fitSize.y = contentSize.y;
+        fitSize.x = fitSize.y / imageAspectRatio;
     }
     else
     {
-        imageSize.x = contentSize.x;
-        imageSize.y = imageSize.x * imageAspectRatio;
+        fitSize.x = contentSize.x;
+        fitSize.y = fitSize.x * imageAspectRatio;
+    }
+
+    // scroll to zoom around the cursor, drag to pan, double click to fit
+    ImGui::InvisibleButton("viewer", contentSize);
+
+    const glm::vec2 contentMinPos(contentMin.x, contentMin.y);
+    const glm::vec2 contentMaxPos = contentMinPos + glm::vec2(contentSize.x, contentSize.y);
+    const glm::vec2 contentCenter = (contentMinPos + contentMaxPos) * 0.5f;
+    const glm::vec2 mousePos(io->MousePos.x, io->MousePos.y);
+
+    if (ImGui::IsItemHovered())
+    {
+        if (io->MouseWheel != 0.f)
+        {
+            const glm::vec2 mouseUv = viewerCenter + (mousePos - contentCenter) / (fitSize * viewerZoom);
+            viewerZoom = glm::clamp(viewerZoom * powf(1.25f, io->MouseWheel), 1.f, 64.f);
+            viewerCenter = mouseUv - (mousePos - contentCenter) / (fitSize * viewerZoom);
+        }
+
+        if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+        {
+            viewerZoom = 1.f;
+            viewerCenter = glm::vec2(0.5f);
+        }
+    }
+
+    const glm::vec2 imageSize = fitSize * viewerZoom;
+
+    if (ImGui::IsItemActive() && ImGui::IsMouseDragging(ImGuiMouseButton_Left, 0.f))
+    {
+        viewerCenter -= glm::vec2(io->MouseDelta.x, io->MouseDelta.y) / imageSize;
     }
 
-    ImVec2 oldCursorPos = ImGui::GetCursorScreenPos();
-    ImVec2 newCursorPos = (contentSize - imageSize) * 0.5f;
-    newCursorPos.y += oldCursorPos.y;
-    ImGui::SetCursorScreenPos(newCursorPos);
+    viewerCenter = glm::clamp(viewerCenter, glm::vec2(0.f), glm::vec2(1.f));
 
-    ImGui::Image((void*)(intptr_t)nodeEvaluator.viewerTex, imageSize);
+    const glm::vec2 imageMin = contentCenter - viewerCenter * imageSize;
+
+    // only the visible part of the output is evaluated
+    const glm::vec2 visibleUvMin = glm::clamp((contentMinPos - imageMin) / imageSize, 0.f, 1.f);
+    const glm::vec2 visibleUvMax = glm::clamp((contentMaxPos - imageMin) / imageSize, 0.f, 1.f);
+    const ImageRegion viewerRegion = {
+        glm::ivec2(glm::floor(visibleUvMin * glm::vec2(outputResolution))),
+        glm::ivec2(glm::ceil(visibleUvMax * glm::vec2(outputResolution)))
+    };
+
+    const glm::vec2 framebufferScale(io->DisplayFramebufferScale.x, io->DisplayFramebufferScale.y);
+    const glm::ivec2 viewerSize = glm::ivec2(glm::ceil((visibleUvMax - visibleUvMin) * imageSize * framebufferScale));
+
+    if (nodeEvaluator.setViewerRegion(viewerRegion, viewerSize))
+    {
+        isNetworkDirty = true;
+    }
+
+    // the viewer texture can lag a frame behind while panning, so it's drawn over the part of the image it actually holds
+    const glm::vec2 texMin = imageMin + nodeEvaluator.getViewerUvMin() * imageSize;
+    const glm::vec2 texMax = imageMin + nodeEvaluator.getViewerUvMax() * imageSize;
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->PushClipRect(contentMin, ImVec2(contentMaxPos.x, contentMaxPos.y), true);
+    drawList->AddImage((void*)(intptr_t)nodeEvaluator.getViewerTextureId(), ImVec2(texMin.x, texMin.y), ImVec2(texMax.x, texMax.y));
+    drawList->PopClipRect();
 }
 
 void Gui::drawNodeEditor()
@@ -471,6 +962,16 @@ void Gui::drawNodeEditor()
                 isNetworkDirty = true;
             }
         }
+
+        // nodes can hide pins when their parameters change (e.g. EXR layers), which invalidates any edges on those pins
+        for (auto& outputPin : node->outputPins)
+        {
+            if (!outputPin.getIsVisible() && outputPin.hasEdge())
+            {
+                deletePinEdges(outputPin);
+                isNetworkDirty = true;
+            }
+        }
     }
 
     for (const auto& [edgeId, edge] : edges)
@@ -8,10 +8,15 @@
 #include <unordered_map>
 #include <memory>
 #include <string>
+#include <chrono>
 
 #include "nodes/node.hpp"
 #include "nodes/edge.hpp"
 #include "nodes/node_evaluator.hpp"
+#include "image_io/image_writer.hpp"
+#include "image_io/sequence_processor.hpp"
+
+class NodeFileInput;
 
 class Gui
 {
@@ -19,11 +24,28 @@ private:
     GLFWwindow* window;
     ImGuiIO* io{ nullptr };
 
+    NodeEvaluator nodeEvaluator{ glm::ivec2(1080, 1350) }; // declared first so it outlives the nodes that release caches into it
+
     std::unordered_map<int, std::unique_ptr<Node>> nodes;
     std::unordered_map<int, std::unique_ptr<Edge>> edges;
 
     Node* outputNode;
-    NodeEvaluator nodeEvaluator{ glm::ivec2(1080, 1350) }; // TODO: allow user to set this
+    glm::ivec2 editedOutputResolution{ 1080, 1350 }; // applied from the view menu
+
+    // while a parameter is being dragged the network is evaluated at 1 / 2^interactiveProxyLevel scale
+    // and a full resolution pass follows once input goes idle
+    int interactiveProxyLevel{ 2 }; // 0 disables proxy evaluation
+    bool needsFullResPass{ false };
+    std::chrono::steady_clock::time_point lastProxyEvaluationTime;
+
+    float viewerZoom{ 1.f }; // 1 fits the whole output image in the viewer
+    glm::vec2 viewerCenter{ 0.5f, 0.5f }; // uv of the output image shown at the center of the viewer
+
+    ImageWriteOptions exportOptions;
+
+    SequenceProcessor sequenceProcessor;
+    NodeFileInput* sequenceInputNode{ nullptr };
+    std::string sequenceResultText; // why the last sequence failed or didn't start, shown until dismissed
 
     bool isFirstRender{ true };
     bool isNetworkDirty{ true };
@@ -65,6 +87,19 @@ private:
     void deletePinEdges(Pin& pin);
 
     void saveImage();
+    void drawExportSettings();
+
+    void startSequence();
+    void stepSequence();
+    void stopSequence();
+    void drawSequenceProgress();
+
+    ImageRegion prepareEvaluation(int proxyLevel, bool isLimitedToViewer);
+    void evaluateNetwork(int proxyLevel = 0, bool isLimitedToViewer = false);
+    void submitNetwork(int proxyLevel, bool isLimitedToViewer);
+    void setOutputResolution(glm::ivec2 outputResolution);
+    void drawResolutionSettings();
+    void drawMemorySettings();
 
     void drawOutputImageViewer();
     void drawNodeEditor();
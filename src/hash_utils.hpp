@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+// 64-bit FNV-1a, built up one value at a time
+// used to key node results by everything they depend on, so it only needs to be cheap and spread well, not be secure
+class Hasher
+{
+private:
+    uint64_t state{ 0xcbf29ce484222325ull };
+
+public:
+    Hasher& addBytes(const void* data, size_t numBytes)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < numBytes; ++i)
+        {
+            this->state ^= bytes[i];
+            this->state *= 0x100000001b3ull;
+        }
+        return *this;
+    }
+
+    // T has to be plain data without padding (e.g. glm vectors), since padding bytes aren't guaranteed to match between equal values
+    template<typename T>
+    Hasher& add(const T& value)
+    {
+        static_assert(std::is_standard_layout_v<T>);
+        return addBytes(&value, sizeof(T));
+    }
+
+    Hasher& add(const std::string& value)
+    {
+        add(value.size());
+        return addBytes(value.data(), value.size());
+    }
+
+    uint64_t get() const
+    {
+        return this->state;
+    }
+};
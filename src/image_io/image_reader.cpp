@@ -0,0 +1,770 @@
+#include "image_reader.hpp"
+
+#include "color_utils.hpp"
+#include "color_utils_batch.hpp"
+#include "thread_utils.hpp"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+static constexpr int minRowsPerThread = 16;
+static constexpr int downsampleTileSize = 64; // in output pixels
+
+void HostImage::allocate(glm::ivec2 resolution, int numChannels)
+{
+    this->resolution = resolution;
+    this->numChannels = numChannels;
+    this->pixels = std::make_unique<float[]>((size_t)resolution.x * resolution.y * numChannels);
+}
+
+void HostImage::downsample(int factor)
+{
+    if (factor <= 1 || pixels == nullptr)
+    {
+        return;
+    }
+
+    const glm::ivec2 outResolution = (resolution + factor - 1) / factor;
+    auto outPixels = std::make_unique<float[]>((size_t)outResolution.x * outResolution.y * numChannels);
+
+    // each tile only reads the block of source rows under it
+    const glm::ivec2 tileSize(downsampleTileSize);
+    ThreadUtils::parallelForTiles(ImageRegion::fromResolution(outResolution), tileSize, [&](const ImageRegion& tile)
+    {
+        ThreadUtils::ScratchArena& arena = ThreadUtils::getScratchArena();
+        ThreadUtils::ScratchArena::Scope scope(arena);
+        float* sum = arena.allocate<float>(numChannels);
+
+        for (int y = tile.min.y; y < tile.max.y; ++y)
+        {
+            const int sy0 = y * factor;
+            const int sy1 = std::min(sy0 + factor, resolution.y);
+
+            for (int x = tile.min.x; x < tile.max.x; ++x)
+            {
+                const int sx0 = x * factor;
+                const int sx1 = std::min(sx0 + factor, resolution.x);
+
+                std::fill(sum, sum + numChannels, 0.f);
+                for (int sy = sy0; sy < sy1; ++sy)
+                {
+                    const float* inRow = pixels.get() + ((size_t)sy * resolution.x) * numChannels;
+                    for (int sx = sx0; sx < sx1; ++sx)
+                    {
+                        for (int c = 0; c < numChannels; ++c)
+                        {
+                            sum[c] += inRow[sx * numChannels + c];
+                        }
+                    }
+                }
+
+                const float invNumSamples = 1.f / ((sy1 - sy0) * (sx1 - sx0));
+                float* outPixel = outPixels.get() + ((size_t)y * outResolution.x + x) * numChannels;
+                for (int c = 0; c < numChannels; ++c)
+                {
+                    outPixel[c] = sum[c] * invNumSamples;
+                }
+            }
+        }
+    });
+
+    resolution = outResolution;
+    pixels = std::move(outPixels);
+}
+
+static bool isAlphaChannelName(const std::string& name)
+{
+    return name == "A" || name == "a" || (name.size() > 2 && name.ends_with(".A"));
+}
+
+static void printExrError(const char* err)
+{
+    if (err)
+    {
+        fprintf(stderr, "ERR : %s\n", err);
+        FreeEXRErrorMessage(err);
+    }
+}
+
+// scanlines stored per chunk for each compression type tinyexr supports
+static int getLinesPerChunk(int compressionType)
+{
+    switch (compressionType)
+    {
+    case TINYEXR_COMPRESSIONTYPE_ZIP:
+    case TINYEXR_COMPRESSIONTYPE_ZFP:
+        return 16;
+    case TINYEXR_COMPRESSIONTYPE_PIZ:
+        return 32;
+    default:
+        return 1;
+    }
+}
+
+// ==================================================================
+// EXR
+// ==================================================================
+
+ExrReader::~ExrReader()
+{
+    close();
+}
+
+bool ExrReader::open(const std::string& filePath)
+{
+    close();
+
+    this->filePath = filePath;
+
+    if (ParseEXRVersionFromFile(&version, filePath.c_str()) != TINYEXR_SUCCESS)
+    {
+        fprintf(stderr, "ERR : invalid EXR file %s\n", filePath.c_str());
+        return false;
+    }
+
+    if (version.multipart || version.non_image)
+    {
+        fprintf(stderr, "ERR : multipart and deep EXR files are not supported\n");
+        return false;
+    }
+
+    InitEXRHeader(&header);
+
+    const char* err = nullptr;
+    if (ParseEXRHeaderFromFile(&header, &version, filePath.c_str(), &err) != TINYEXR_SUCCESS)
+    {
+        printExrError(err);
+        return false;
+    }
+
+    isHeaderLoaded = true;
+
+    // half channels are widened while decoding so every decoded channel is 4 bytes wide
+    for (int channelIdx = 0; channelIdx < header.num_channels; ++channelIdx)
+    {
+        if (header.pixel_types[channelIdx] == TINYEXR_PIXELTYPE_HALF)
+        {
+            header.requested_pixel_types[channelIdx] = TINYEXR_PIXELTYPE_FLOAT;
+        }
+    }
+
+    return true;
+}
+
+void ExrReader::close()
+{
+    freeImage();
+
+    if (isHeaderLoaded)
+    {
+        FreeEXRHeader(&header);
+        isHeaderLoaded = false;
+    }
+}
+
+bool ExrReader::isOpen() const
+{
+    return this->isHeaderLoaded;
+}
+
+const std::string& ExrReader::getFilePath() const
+{
+    return this->filePath;
+}
+
+glm::ivec2 ExrReader::getResolution() const
+{
+    return glm::ivec2(
+        header.display_window.max_x - header.display_window.min_x + 1,
+        header.display_window.max_y - header.display_window.min_y + 1
+    );
+}
+
+glm::ivec2 ExrReader::getDataWindowOffset() const
+{
+    return glm::ivec2(
+        header.display_window.min_x - header.data_window.min_x,
+        header.display_window.min_y - header.data_window.min_y
+    );
+}
+
+glm::ivec2 ExrReader::getDataWindowSize() const
+{
+    return glm::ivec2(
+        header.data_window.max_x - header.data_window.min_x + 1,
+        header.data_window.max_y - header.data_window.min_y + 1
+    );
+}
+
+int ExrReader::getNumChannels() const
+{
+    return header.num_channels;
+}
+
+const char* ExrReader::getChannelName(int channelIdx) const
+{
+    return header.channels[channelIdx].name;
+}
+
+int ExrReader::findChannel(const std::string& name) const
+{
+    for (int channelIdx = 0; channelIdx < header.num_channels; ++channelIdx)
+    {
+        if (name == header.channels[channelIdx].name)
+        {
+            return channelIdx;
+        }
+    }
+
+    return -1;
+}
+
+bool ExrReader::decode(const ImageRegion& region)
+{
+    freeImage();
+
+    // rows of the data window that overlap region
+    const glm::ivec2 dataSize = getDataWindowSize();
+    const ImageRegion dataRegion = region.offset(getDataWindowOffset()).intersect(ImageRegion::fromResolution(dataSize));
+
+    if (dataRegion.isEmpty())
+    {
+        return true; // nothing to decode, region is entirely outside the data window
+    }
+
+    const bool decodeAllRows = dataRegion.min.y == 0 && dataRegion.max.y == dataSize.y;
+
+    if (!header.tiled && !decodeAllRows && decodeRows(dataRegion.min.y, dataRegion.max.y))
+    {
+        return true;
+    }
+
+    // tiled file, whole image requested, or the chunk table couldn't be used
+    const char* err = nullptr;
+    if (LoadEXRImageFromFile(&image, &header, filePath.c_str(), &err) != TINYEXR_SUCCESS)
+    {
+        printExrError(err);
+        return false;
+    }
+
+    isImageLoaded = true;
+    decodedRowOffset = 0;
+
+    if (header.tiled)
+    {
+        buildTileLookup();
+    }
+
+    return true;
+}
+
+// builds a smaller in-memory EXR containing only the chunks that cover [rowMin, rowMax)
+// the header is reused as is and only the data window passed to tinyexr is narrowed to those chunks
+bool ExrReader::decodeRows(int rowMin, int rowMax)
+{
+    const int linesPerChunk = getLinesPerChunk(header.compression_type);
+    const int numChunks = header.chunk_count > 0
+        ? header.chunk_count
+        : (getDataWindowSize().y + linesPerChunk - 1) / linesPerChunk;
+
+    const int firstChunk = rowMin / linesPerChunk;
+    const int lastChunk = std::min((rowMax - 1) / linesPerChunk, numChunks - 1);
+    const int numDecodedChunks = lastChunk - firstChunk + 1;
+
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    // magic number + version + attributes, then the chunk offset table
+    const size_t headerSize = 8 + (size_t)header.header_len;
+    std::vector<uint64_t> offsets(numChunks);
+    file.seekg(headerSize);
+    file.read(reinterpret_cast<char*>(offsets.data()), numChunks * sizeof(uint64_t));
+
+    if (!file)
+    {
+        return false;
+    }
+
+    // each chunk starts with its first scanline and its data size
+    std::vector<int32_t> chunkHeaders(2 * numDecodedChunks);
+    size_t totalChunkSize = 0;
+    for (int chunkIdx = firstChunk; chunkIdx <= lastChunk; ++chunkIdx)
+    {
+        int32_t* chunkHeader = &chunkHeaders[2 * (chunkIdx - firstChunk)];
+
+        if (offsets[chunkIdx] == 0)
+        {
+            return false; // incomplete offset table
+        }
+
+        file.seekg(offsets[chunkIdx]);
+        file.read(reinterpret_cast<char*>(chunkHeader), 2 * sizeof(int32_t));
+
+        if (!file || chunkHeader[0] != header.data_window.min_y + chunkIdx * linesPerChunk || chunkHeader[1] <= 0)
+        {
+            return false;
+        }
+
+        totalChunkSize += 2 * sizeof(int32_t) + chunkHeader[1];
+    }
+
+    const size_t tableSize = numDecodedChunks * sizeof(uint64_t);
+    std::vector<unsigned char> memory(headerSize + tableSize + totalChunkSize);
+
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(memory.data()), headerSize);
+
+    size_t chunkStart = headerSize + tableSize;
+    for (int chunkIdx = firstChunk; chunkIdx <= lastChunk; ++chunkIdx)
+    {
+        const int32_t* chunkHeader = &chunkHeaders[2 * (chunkIdx - firstChunk)];
+        const size_t chunkSize = 2 * sizeof(int32_t) + chunkHeader[1];
+
+        uint64_t newOffset = chunkStart;
+        memcpy(memory.data() + headerSize + (chunkIdx - firstChunk) * sizeof(uint64_t), &newOffset, sizeof(uint64_t));
+
+        file.seekg(offsets[chunkIdx]);
+        file.read(reinterpret_cast<char*>(memory.data() + chunkStart), chunkSize);
+
+        chunkStart += chunkSize;
+    }
+
+    if (!file)
+    {
+        return false;
+    }
+
+    EXRHeader partialHeader = header; // shallow copy, channel arrays are still owned by header
+    partialHeader.data_window.min_y = header.data_window.min_y + firstChunk * linesPerChunk;
+    partialHeader.data_window.max_y = std::min(header.data_window.max_y, header.data_window.min_y + (lastChunk + 1) * linesPerChunk - 1);
+    if (partialHeader.chunk_count > 0)
+    {
+        partialHeader.chunk_count = numDecodedChunks;
+    }
+
+    const char* err = nullptr;
+    if (LoadEXRImageFromMemory(&image, &partialHeader, memory.data(), memory.size(), &err) != TINYEXR_SUCCESS)
+    {
+        printExrError(err);
+        return false;
+    }
+
+    isImageLoaded = true;
+    decodedRowOffset = firstChunk * linesPerChunk;
+
+    return true;
+}
+
+void ExrReader::buildTileLookup()
+{
+    const glm::ivec2 dataSize = getDataWindowSize();
+    const int numTilesX = (dataSize.x + header.tile_size_x - 1) / header.tile_size_x;
+    const int numTilesY = (dataSize.y + header.tile_size_y - 1) / header.tile_size_y;
+
+    tileLookup.assign(numTilesX * numTilesY, -1);
+
+    for (int tileIdx = 0; tileIdx < image.num_tiles; ++tileIdx)
+    {
+        const EXRTile& tile = image.tiles[tileIdx];
+        if (tile.level_x != 0 || tile.level_y != 0 || tile.offset_x >= numTilesX || tile.offset_y >= numTilesY)
+        {
+            continue;
+        }
+
+        tileLookup[tile.offset_y * numTilesX + tile.offset_x] = tileIdx;
+    }
+}
+
+void ExrReader::freeImage()
+{
+    if (isImageLoaded)
+    {
+        FreeEXRImage(&image);
+        isImageLoaded = false;
+    }
+
+    InitEXRImage(&image);
+    tileLookup.clear();
+    decodedRowOffset = 0;
+}
+
+const void* ExrReader::getDecodedSpan(int channelIdx, int dataX, int dataY, int& spanLength) const
+{
+    if (!header.tiled)
+    {
+        spanLength = image.width - dataX;
+
+        const size_t idx = (size_t)(dataY - decodedRowOffset) * image.width + dataX;
+        return reinterpret_cast<const uint32_t*>(image.images[channelIdx]) + idx;
+    }
+
+    const int numTilesX = (getDataWindowSize().x + header.tile_size_x - 1) / header.tile_size_x;
+    const int tileX = dataX / header.tile_size_x;
+    const int tileY = dataY / header.tile_size_y;
+    const int localX = dataX - tileX * header.tile_size_x;
+    const int localY = dataY - tileY * header.tile_size_y;
+
+    const int tileIdx = tileLookup[tileY * numTilesX + tileX];
+    if (tileIdx == -1)
+    {
+        spanLength = header.tile_size_x - localX;
+        return nullptr;
+    }
+
+    const EXRTile& tile = image.tiles[tileIdx];
+    spanLength = tile.width - localX;
+
+    const size_t idx = (size_t)localY * header.tile_size_x + localX;
+    return reinterpret_cast<const uint32_t*>(tile.images[channelIdx]) + idx;
+}
+
+void ExrReader::copyChannels(const std::vector<int>& channelIdxs, const std::vector<float>& fillValues,
+    const ImageRegion& region, bool srgbToLinear, float* outPixels) const
+{
+    const int numOutChannels = channelIdxs.size();
+    const glm::ivec2 regionSize = region.getSize();
+    const glm::ivec2 dataOffset = getDataWindowOffset();
+    const glm::ivec2 dataSize = getDataWindowSize();
+
+    const int decodedRowMin = isImageLoaded ? decodedRowOffset : 0;
+    const int decodedRowMax = isImageLoaded ? decodedRowOffset + image.height : 0;
+
+    // columns of region that lie inside the data window
+    const int dataXMin = std::max(region.min.x + dataOffset.x, 0);
+    const int dataXMax = std::min(region.max.x + dataOffset.x, dataSize.x);
+    const int validStart = std::clamp(dataXMin - (region.min.x + dataOffset.x), 0, regionSize.x);
+    const int validEnd = std::clamp(dataXMax - (region.min.x + dataOffset.x), validStart, regionSize.x);
+
+    // converted per row after copying, so the conversion runs over contiguous memory instead of one value at a time
+    uint32_t srgbChannelMask = 0;
+    if (srgbToLinear)
+    {
+        for (int outChannel = 0; outChannel < numOutChannels; ++outChannel)
+        {
+            const int channelIdx = channelIdxs[outChannel];
+            if (channelIdx != -1 && !isAlphaChannelName(header.channels[channelIdx].name))
+            {
+                srgbChannelMask |= 1u << outChannel;
+            }
+        }
+    }
+
+    ThreadUtils::parallelFor(0, regionSize.y, [&](int rowBegin, int rowEnd)
+    {
+        for (int row = rowBegin; row < rowEnd; ++row)
+        {
+            float* outRow = outPixels + (size_t)row * regionSize.x * numOutChannels;
+            const int dataY = region.min.y + row + dataOffset.y;
+
+            if (dataY < decodedRowMin || dataY >= decodedRowMax || validStart == validEnd)
+            {
+                std::fill(outRow, outRow + regionSize.x * numOutChannels, 0.f);
+                continue;
+            }
+
+            std::fill(outRow, outRow + validStart * numOutChannels, 0.f);
+            std::fill(outRow + validEnd * numOutChannels, outRow + regionSize.x * numOutChannels, 0.f);
+
+            for (int outChannel = 0; outChannel < numOutChannels; ++outChannel)
+            {
+                const int channelIdx = channelIdxs[outChannel];
+
+                if (channelIdx == -1)
+                {
+                    for (int x = validStart; x < validEnd; ++x)
+                    {
+                        outRow[x * numOutChannels + outChannel] = fillValues[outChannel];
+                    }
+                    continue;
+                }
+
+                const bool isUint = header.requested_pixel_types[channelIdx] == TINYEXR_PIXELTYPE_UINT;
+
+                int x = validStart;
+                while (x < validEnd)
+                {
+                    const int dataX = region.min.x + x + dataOffset.x;
+
+                    int spanLength;
+                    const void* span = getDecodedSpan(channelIdx, dataX, dataY, spanLength);
+                    spanLength = std::min(spanLength, validEnd - x);
+
+                    float* outValue = outRow + x * numOutChannels + outChannel;
+                    for (int spanIdx = 0; spanIdx < spanLength; ++spanIdx, outValue += numOutChannels)
+                    {
+                        if (span == nullptr)
+                        {
+                            *outValue = 0.f;
+                        }
+                        else if (isUint)
+                        {
+                            *outValue = (float)static_cast<const uint32_t*>(span)[spanIdx];
+                        }
+                        else
+                        {
+                            *outValue = static_cast<const float*>(span)[spanIdx];
+                        }
+                    }
+
+                    x += spanLength;
+                }
+            }
+
+            if (srgbChannelMask != 0)
+            {
+                ColorUtils::Batch::srgbToLinear(outRow + validStart * numOutChannels, validEnd - validStart, numOutChannels, srgbChannelMask);
+            }
+        }
+    }, minRowsPerThread);
+}
+
+// ==================================================================
+// READING
+// ==================================================================
+
+bool ImageReader::isExr(const std::string& filePath)
+{
+    return std::filesystem::path(filePath).extension().string() == ".exr";
+}
+
+static ImageRegion resolveRegion(const ImageRegion& requestedRegion, glm::ivec2 resolution)
+{
+    const ImageRegion fullRegion = ImageRegion::fromResolution(resolution);
+    return requestedRegion.isEmpty() ? fullRegion : requestedRegion.intersect(fullRegion);
+}
+
+static bool readExrImage(const std::string& filePath, const ImageReadOptions& options, HostImage& outImage)
+{
+    ExrReader reader;
+    if (!reader.open(filePath))
+    {
+        return false;
+    }
+
+    const ImageRegion region = resolveRegion(options.region, reader.getResolution());
+    if (region.isEmpty())
+    {
+        return false;
+    }
+
+    std::vector<int> channelIdxs;
+    std::vector<float> fillValues;
+    for (const auto& channelName : options.channels)
+    {
+        const bool isAlpha = isAlphaChannelName(channelName);
+
+        int channelIdx = reader.findChannel(channelName);
+        if (channelIdx == -1 && !isAlpha)
+        {
+            // greyscale files store a single luminance channel
+            channelIdx = reader.getNumChannels() == 1 ? 0 : reader.findChannel("Y");
+        }
+
+        channelIdxs.push_back(channelIdx);
+        fillValues.push_back(isAlpha ? 1.f : 0.f);
+    }
+
+    if (!reader.decode(region))
+    {
+        return false;
+    }
+
+    outImage.allocate(region.getSize(), channelIdxs.size());
+    reader.copyChannels(channelIdxs, fillValues, region, options.srgbToLinear, outImage.pixels.get());
+
+    return true;
+}
+
+// maps a channel name to a component of an stb image with numFileChannels components (grey, grey + alpha, RGB, RGBA)
+static int getStbComponent(const std::string& channelName, int numFileChannels)
+{
+    const bool hasAlpha = numFileChannels == 2 || numFileChannels == 4;
+
+    if (isAlphaChannelName(channelName))
+    {
+        return hasAlpha ? numFileChannels - 1 : -1;
+    }
+
+    if (numFileChannels <= 2)
+    {
+        return 0;
+    }
+
+    if (channelName == "R") return 0;
+    if (channelName == "G") return 1;
+    if (channelName == "B") return 2;
+    return -1;
+}
+
+template<typename T>
+static void convertStbPixels(const T* filePixels, int fileWidth, int numFileChannels,
+    const ImageRegion& region, const std::vector<int>& components, const std::vector<bool>& isAlpha,
+    const float* colorTable, bool srgbToLinear, float alphaScale, HostImage& outImage)
+{
+    const int numOutChannels = components.size();
+    const glm::ivec2 regionSize = region.getSize();
+
+    uint32_t srgbChannelMask = 0;
+    if (std::is_same_v<T, float> && srgbToLinear)
+    {
+        for (int outChannel = 0; outChannel < numOutChannels; ++outChannel)
+        {
+            if (components[outChannel] != -1 && !isAlpha[outChannel])
+            {
+                srgbChannelMask |= 1u << outChannel;
+            }
+        }
+    }
+
+    ThreadUtils::parallelFor(0, regionSize.y, [&](int rowBegin, int rowEnd)
+    {
+        for (int row = rowBegin; row < rowEnd; ++row)
+        {
+            const T* inPixel = filePixels + ((size_t)(region.min.y + row) * fileWidth + region.min.x) * numFileChannels;
+            float* outRow = outImage.pixels.get() + (size_t)row * regionSize.x * numOutChannels;
+            float* outPixel = outRow;
+
+            for (int x = 0; x < regionSize.x; ++x, inPixel += numFileChannels, outPixel += numOutChannels)
+            {
+                for (int outChannel = 0; outChannel < numOutChannels; ++outChannel)
+                {
+                    const int component = components[outChannel];
+                    if (component == -1)
+                    {
+                        outPixel[outChannel] = isAlpha[outChannel] ? 1.f : 0.f;
+                    }
+                    else if (isAlpha[outChannel])
+                    {
+                        outPixel[outChannel] = inPixel[component] * alphaScale;
+                    }
+                    else if constexpr (std::is_same_v<T, float>)
+                    {
+                        outPixel[outChannel] = inPixel[component]; // converted for the whole row below
+                    }
+                    else
+                    {
+                        outPixel[outChannel] = colorTable[inPixel[component]];
+                    }
+                }
+            }
+
+            if (srgbChannelMask != 0)
+            {
+                ColorUtils::Batch::srgbToLinear(outRow, regionSize.x, numOutChannels, srgbChannelMask);
+            }
+        }
+    }, minRowsPerThread);
+}
+
+// integer pixels are converted through a table holding every possible value, which is far cheaper than calling pow per channel
+template<typename T>
+static std::vector<float> makeColorTable(bool srgbToLinear)
+{
+    constexpr int numValues = 1 << (8 * sizeof(T));
+    constexpr float scale = 1.f / (numValues - 1);
+
+    std::vector<float> table(numValues);
+    for (int value = 0; value < numValues; ++value)
+    {
+        table[value] = srgbToLinear ? ColorUtils::srgbToLinear(value * scale) : value * scale;
+    }
+
+    return table;
+}
+
+// built once per type, so reading a sequence doesn't redo them every frame
+template<typename T>
+static const std::vector<float>& getColorTable(bool srgbToLinear)
+{
+    static const std::vector<float> linearTable = makeColorTable<T>(false);
+    static const std::vector<float> srgbTable = makeColorTable<T>(true);
+    return srgbToLinear ? srgbTable : linearTable;
+}
+
+static bool readStbImage(const std::string& filePath, const ImageReadOptions& options, HostImage& outImage)
+{
+    int width, height, numFileChannels;
+    if (!stbi_info(filePath.c_str(), &width, &height, &numFileChannels))
+    {
+        return false;
+    }
+
+    const ImageRegion region = resolveRegion(options.region, glm::ivec2(width, height));
+    if (region.isEmpty())
+    {
+        return false;
+    }
+
+    std::vector<int> components;
+    std::vector<bool> isAlpha;
+    for (const auto& channelName : options.channels)
+    {
+        components.push_back(getStbComponent(channelName, numFileChannels));
+        isAlpha.push_back(isAlphaChannelName(channelName));
+    }
+
+    const bool isHdr = stbi_is_hdr(filePath.c_str());
+    const bool is16Bit = !isHdr && stbi_is_16_bit(filePath.c_str());
+
+    // decode with the file's own channel count to avoid expanding to RGBA
+    void* filePixels;
+    if (isHdr)
+    {
+        filePixels = stbi_loadf(filePath.c_str(), &width, &height, &numFileChannels, 0);
+    }
+    else if (is16Bit)
+    {
+        filePixels = stbi_load_16(filePath.c_str(), &width, &height, &numFileChannels, 0);
+    }
+    else
+    {
+        filePixels = stbi_load(filePath.c_str(), &width, &height, &numFileChannels, 0);
+    }
+
+    if (filePixels == nullptr)
+    {
+        return false;
+    }
+
+    outImage.allocate(region.getSize(), components.size());
+
+    if (isHdr)
+    {
+        convertStbPixels(static_cast<const float*>(filePixels), width, numFileChannels, region, components, isAlpha,
+            nullptr, options.srgbToLinear, 1.f, outImage);
+    }
+    else if (is16Bit)
+    {
+        const auto& colorTable = getColorTable<stbi_us>(options.srgbToLinear);
+        convertStbPixels(static_cast<const stbi_us*>(filePixels), width, numFileChannels, region, components, isAlpha,
+            colorTable.data(), options.srgbToLinear, 1.f / 65535.f, outImage);
+    }
+    else
+    {
+        const auto& colorTable = getColorTable<stbi_uc>(options.srgbToLinear);
+        convertStbPixels(static_cast<const stbi_uc*>(filePixels), width, numFileChannels, region, components, isAlpha,
+            colorTable.data(), options.srgbToLinear, 1.f / 255.f, outImage);
+    }
+
+    stbi_image_free(filePixels);
+
+    return true;
+}
+
+bool ImageReader::readImage(const std::string& filePath, const ImageReadOptions& options, HostImage& outImage)
+{
+    if (isExr(filePath))
+    {
+        return readExrImage(filePath, options, outImage);
+    }
+
+    return readStbImage(filePath, options, outImage);
+}
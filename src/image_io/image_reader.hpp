@@ -0,0 +1,95 @@
+#pragma once
+
+#include "image_region.hpp"
+
+#include "tinyexr.h"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ImageReadOptions
+{
+    ImageRegion region{}; // empty region reads the whole image
+    std::vector<std::string> channels{ "R", "G", "B", "A" };
+    bool srgbToLinear{ false }; // applies to every channel except alpha
+};
+
+// interleaved float pixels, options.channels.size() floats per pixel
+struct HostImage
+{
+    glm::ivec2 resolution{ 0, 0 };
+    int numChannels{ 0 };
+    std::unique_ptr<float[]> pixels;
+
+    void allocate(glm::ivec2 resolution, int numChannels);
+
+    // box filters by an integer factor, resolution is rounded up and edge pixels average only the samples that exist
+    void downsample(int factor);
+};
+
+// reads the header of an EXR file once and then decodes any subset of its channels
+// scanline files only decode the chunks that overlap the requested region
+class ExrReader
+{
+private:
+    std::string filePath;
+
+    EXRVersion version{};
+    EXRHeader header{};
+    bool isHeaderLoaded{ false };
+
+    EXRImage image{};
+    bool isImageLoaded{ false };
+    int decodedRowOffset{ 0 }; // first decoded row of the data window
+    std::vector<int> tileLookup; // tile grid cell -> index into image.tiles
+
+public:
+    ExrReader() = default;
+    ~ExrReader();
+
+    ExrReader(const ExrReader&) = delete;
+    ExrReader& operator=(const ExrReader&) = delete;
+
+    bool open(const std::string& filePath);
+    void close();
+
+    bool isOpen() const;
+    const std::string& getFilePath() const;
+
+    glm::ivec2 getResolution() const; // display window size
+
+    int getNumChannels() const;
+    const char* getChannelName(int channelIdx) const;
+    int findChannel(const std::string& name) const; // -1 if not found
+
+    // decodes every chunk overlapping region (display window coordinates) using all available threads
+    bool decode(const ImageRegion& region);
+    void freeImage();
+
+    // writes interleaved pixels covering region, which must be within the decoded region
+    // channel index -1 writes the corresponding fill value, pixels outside the data window are written as 0
+    void copyChannels(const std::vector<int>& channelIdxs, const std::vector<float>& fillValues,
+        const ImageRegion& region, bool srgbToLinear, float* outPixels) const;
+
+private:
+    bool decodeRows(int rowMin, int rowMax);
+    void buildTileLookup();
+
+    glm::ivec2 getDataWindowOffset() const; // display window coordinates -> data window coordinates
+    glm::ivec2 getDataWindowSize() const;
+
+    // pointer to the decoded value at (dataX, dataY) plus the number of values that follow it contiguously in that row
+    // nullptr if the value wasn't decoded (e.g. a missing tile)
+    const void* getDecodedSpan(int channelIdx, int dataX, int dataY, int& spanLength) const;
+};
+
+namespace ImageReader
+{
+    bool isExr(const std::string& filePath);
+
+    // returns false if the file can't be read, in which case outImage is left empty
+    bool readImage(const std::string& filePath, const ImageReadOptions& options, HostImage& outImage);
+}
@@ -0,0 +1,619 @@
+#include "image_writer.hpp"
+
+#include "thread_utils.hpp"
+
+#include "stb_image_write.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstring>
+#include <fstream>
+
+const std::vector<const char*> ImageWriter::formatNames = { "PNG", "JPEG", "EXR" };
+const std::vector<const char*> ImageWriter::exrCompressionNames = { "none", "RLE", "ZIPS", "ZIP", "PIZ" };
+const std::vector<int> ImageWriter::exrCompressionTypes = {
+    TINYEXR_COMPRESSIONTYPE_NONE,
+    TINYEXR_COMPRESSIONTYPE_RLE,
+    TINYEXR_COMPRESSIONTYPE_ZIPS,
+    TINYEXR_COMPRESSIONTYPE_ZIP,
+    TINYEXR_COMPRESSIONTYPE_PIZ
+};
+
+const char* ImageWriter::getExtension(ImageFormat format)
+{
+    switch (format)
+    {
+    case ImageFormat::PNG:
+        return ".png";
+    case ImageFormat::JPEG:
+        return ".jpg";
+    case ImageFormat::EXR:
+        return ".exr";
+    default:
+        throw std::runtime_error("invalid image format");
+    }
+}
+
+// ==================================================================
+// PNG
+// ==================================================================
+
+// stb_image_write compresses the whole image as a single deflate stream on one thread, which dominates save time for
+// large images. instead, the image is split into horizontal strips which are filtered and compressed independently.
+// each strip is a fixed Huffman deflate block that may still reference the previous 32 KB of data, and strips are
+// joined with empty stored blocks (like zlib's Z_SYNC_FLUSH) so the result is a single valid zlib stream.
+
+namespace
+{
+    constexpr int pngBytesPerPixel = 4;
+    constexpr int minRowsPerStrip = 32;
+
+    constexpr int deflateWindowSize = 32768;
+    constexpr int deflateHashBits = 15;
+    constexpr int deflateMaxChainLength = 32;
+    constexpr int deflateMinMatch = 3;
+    constexpr int deflateMaxMatch = 258;
+
+    constexpr std::array<int, 29> lengthBases = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+    constexpr std::array<int, 29> lengthExtraBits = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+    constexpr std::array<int, 30> distanceBases = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+        6145, 8193, 12289, 16385, 24577
+    };
+    constexpr std::array<int, 30> distanceExtraBits = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+    };
+
+    struct DeflateTables
+    {
+        std::array<uint8_t, deflateMaxMatch + 1> lengthCodes{};
+        std::array<uint8_t, deflateWindowSize + 1> distanceCodes{};
+        std::array<uint32_t, 256> crcTable{};
+
+        DeflateTables()
+        {
+            for (int code = 0; code < (int)lengthBases.size(); ++code)
+            {
+                const int nextBase = code + 1 < (int)lengthBases.size() ? lengthBases[code + 1] : deflateMaxMatch + 1;
+                for (int length = lengthBases[code]; length < nextBase; ++length)
+                {
+                    lengthCodes[length] = code;
+                }
+            }
+
+            for (int code = 0; code < (int)distanceBases.size(); ++code)
+            {
+                const int nextBase = code + 1 < (int)distanceBases.size() ? distanceBases[code + 1] : deflateWindowSize + 1;
+                for (int distance = distanceBases[code]; distance < nextBase; ++distance)
+                {
+                    distanceCodes[distance] = code;
+                }
+            }
+
+            for (uint32_t n = 0; n < 256; ++n)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k)
+                {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                crcTable[n] = c;
+            }
+        }
+    };
+
+    const DeflateTables& getDeflateTables()
+    {
+        static const DeflateTables tables;
+        return tables;
+    }
+
+    uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+    {
+        const auto& crcTable = getDeflateTables().crcTable;
+
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    constexpr uint32_t adlerBase = 65521;
+
+    uint32_t adler32(const uint8_t* data, size_t size)
+    {
+        uint32_t a = 1, b = 0;
+        while (size > 0)
+        {
+            const size_t blockSize = std::min(size, (size_t)5552); // largest block that can't overflow b
+            for (size_t i = 0; i < blockSize; ++i)
+            {
+                a += data[i];
+                b += a;
+            }
+            a %= adlerBase;
+            b %= adlerBase;
+
+            data += blockSize;
+            size -= blockSize;
+        }
+        return (b << 16) | a;
+    }
+
+    // checksum of two concatenated buffers from their individual checksums, same as zlib's adler32_combine()
+    uint32_t adler32Combine(uint32_t adler1, uint32_t adler2, size_t size2)
+    {
+        const uint32_t rem = size2 % adlerBase;
+        uint32_t sum1 = adler1 & 0xFFFF;
+        uint32_t sum2 = (rem * sum1) % adlerBase;
+        sum1 += (adler2 & 0xFFFF) + adlerBase - 1;
+        sum2 += ((adler1 >> 16) & 0xFFFF) + ((adler2 >> 16) & 0xFFFF) + adlerBase - rem;
+
+        if (sum1 >= adlerBase) sum1 -= adlerBase;
+        if (sum1 >= adlerBase) sum1 -= adlerBase;
+        if (sum2 >= (adlerBase << 1)) sum2 -= (adlerBase << 1);
+        if (sum2 >= adlerBase) sum2 -= adlerBase;
+
+        return sum1 | (sum2 << 16);
+    }
+
+    class BitWriter
+    {
+    private:
+        std::vector<uint8_t>& bytes;
+        uint64_t bitBuffer{ 0 };
+        int numBits{ 0 };
+
+    public:
+        BitWriter(std::vector<uint8_t>& bytes)
+            : bytes(bytes)
+        {}
+
+        void writeBits(uint32_t bits, int count)
+        {
+            bitBuffer |= (uint64_t)bits << numBits;
+            numBits += count;
+            while (numBits >= 8)
+            {
+                bytes.push_back(bitBuffer & 0xFF);
+                bitBuffer >>= 8;
+                numBits -= 8;
+            }
+        }
+
+        // Huffman codes are packed starting from their most significant bit
+        void writeCode(uint32_t code, int length)
+        {
+            uint32_t reversed = 0;
+            for (int i = 0; i < length; ++i)
+            {
+                reversed = (reversed << 1) | ((code >> i) & 1);
+            }
+            writeBits(reversed, length);
+        }
+
+        void alignToByte()
+        {
+            if (numBits > 0)
+            {
+                bytes.push_back(bitBuffer & 0xFF);
+                bitBuffer = 0;
+                numBits = 0;
+            }
+        }
+    };
+
+    void writeLiteral(BitWriter& writer, int literal)
+    {
+        if (literal < 144)
+        {
+            writer.writeCode(0x30 + literal, 8);
+        }
+        else
+        {
+            writer.writeCode(0x190 + literal - 144, 9);
+        }
+    }
+
+    void writeLengthSymbol(BitWriter& writer, int symbol)
+    {
+        if (symbol < 280)
+        {
+            writer.writeCode(symbol - 256, 7);
+        }
+        else
+        {
+            writer.writeCode(0xC0 + symbol - 280, 8);
+        }
+    }
+
+    void writeMatch(BitWriter& writer, int length, int distance)
+    {
+        const auto& tables = getDeflateTables();
+
+        const int lengthCode = tables.lengthCodes[length];
+        writeLengthSymbol(writer, 257 + lengthCode);
+        writer.writeBits(length - lengthBases[lengthCode], lengthExtraBits[lengthCode]);
+
+        const int distanceCode = tables.distanceCodes[distance];
+        writer.writeCode(distanceCode, 5);
+        writer.writeBits(distance - distanceBases[distanceCode], distanceExtraBits[distanceCode]);
+    }
+
+    inline uint32_t hash3(const uint8_t* p)
+    {
+        return ((p[0] | (p[1] << 8) | (p[2] << 16)) * 2654435761u) >> (32 - deflateHashBits);
+    }
+
+    // compresses data[begin, end) as one fixed Huffman block, matches may reach back before begin
+    void deflateStrip(const uint8_t* data, size_t dataSize, size_t begin, size_t end, bool isLastStrip, std::vector<uint8_t>& outBytes)
+    {
+        std::vector<int> head(1 << deflateHashBits, -1);
+        std::vector<int> prev(deflateWindowSize, -1);
+
+        auto insert = [&](size_t pos)
+        {
+            if (pos + deflateMinMatch > dataSize)
+            {
+                return;
+            }
+
+            const uint32_t hash = hash3(data + pos);
+            prev[pos & (deflateWindowSize - 1)] = head[hash];
+            head[hash] = (int)pos;
+        };
+
+        // prime the hash chains with the window preceding this strip
+        for (size_t pos = begin > deflateWindowSize ? begin - deflateWindowSize : 0; pos < begin; ++pos)
+        {
+            insert(pos);
+        }
+
+        BitWriter writer(outBytes);
+        writer.writeBits(isLastStrip ? 1 : 0, 1); // BFINAL
+        writer.writeBits(1, 2); // BTYPE = fixed Huffman
+
+        size_t pos = begin;
+        while (pos < end)
+        {
+            const int maxLength = (int)std::min((size_t)deflateMaxMatch, end - pos);
+
+            int bestLength = 0;
+            int bestDistance = 0;
+            if (maxLength >= deflateMinMatch)
+            {
+                int candidate = head[hash3(data + pos)];
+                int chainLength = deflateMaxChainLength;
+                while (candidate != -1 && pos - candidate <= deflateWindowSize && chainLength-- > 0)
+                {
+                    const uint8_t* a = data + candidate;
+                    const uint8_t* b = data + pos;
+                    if (a[bestLength] == b[bestLength])
+                    {
+                        int length = 0;
+                        while (length < maxLength && a[length] == b[length])
+                        {
+                            ++length;
+                        }
+
+                        if (length > bestLength)
+                        {
+                            bestLength = length;
+                            bestDistance = (int)(pos - candidate);
+
+                            if (length == maxLength)
+                            {
+                                break;
+                            }
+                        }
+                    }
+
+                    candidate = prev[candidate & (deflateWindowSize - 1)];
+                }
+            }
+
+            if (bestLength >= deflateMinMatch)
+            {
+                writeMatch(writer, bestLength, bestDistance);
+                for (int i = 0; i < bestLength; ++i)
+                {
+                    insert(pos + i);
+                }
+                pos += bestLength;
+            }
+            else
+            {
+                writeLiteral(writer, data[pos]);
+                insert(pos);
+                ++pos;
+            }
+        }
+
+        writer.writeCode(0, 7); // end of block
+
+        if (!isLastStrip)
+        {
+            // empty stored block to realign to a byte boundary so the next strip can be appended directly
+            writer.writeBits(0, 3);
+            writer.alignToByte();
+            outBytes.insert(outBytes.end(), { 0x00, 0x00, 0xFF, 0xFF });
+        }
+
+        writer.alignToByte();
+    }
+
+    void appendUint32(std::vector<uint8_t>& bytes, uint32_t value)
+    {
+        bytes.insert(bytes.end(), { (uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value });
+    }
+
+    void appendChunk(std::vector<uint8_t>& bytes, const char* type, const uint8_t* data, size_t size)
+    {
+        appendUint32(bytes, (uint32_t)size);
+
+        const size_t typeStart = bytes.size();
+        bytes.insert(bytes.end(), type, type + 4);
+        bytes.insert(bytes.end(), data, data + size);
+
+        appendUint32(bytes, crc32(bytes.data() + typeStart, size + 4));
+    }
+
+    inline uint8_t paethPredictor(int a, int b, int c)
+    {
+        const int p = a + b - c;
+        const int pa = abs(p - a);
+        const int pb = abs(p - b);
+        const int pc = abs(p - c);
+        if (pa <= pb && pa <= pc) return a;
+        if (pb <= pc) return b;
+        return c;
+    }
+
+    // writes the filter type byte followed by the filtered row, picking the filter with the smallest sum of absolute values
+    void filterRow(const uint8_t* row, const uint8_t* prevRow, int rowSize, uint8_t* outRow, std::vector<uint8_t>& scratch)
+    {
+        int bestSum = INT_MAX;
+        for (int filterType = 0; filterType < 5; ++filterType)
+        {
+            int sum = 0;
+            for (int i = 0; i < rowSize; ++i)
+            {
+                const int a = i >= pngBytesPerPixel ? row[i - pngBytesPerPixel] : 0;
+                const int b = prevRow != nullptr ? prevRow[i] : 0;
+                const int c = i >= pngBytesPerPixel && prevRow != nullptr ? prevRow[i - pngBytesPerPixel] : 0;
+
+                uint8_t predictor;
+                switch (filterType)
+                {
+                case 0: predictor = 0; break;
+                case 1: predictor = a; break;
+                case 2: predictor = b; break;
+                case 3: predictor = (a + b) >> 1; break;
+                default: predictor = paethPredictor(a, b, c); break;
+                }
+
+                const uint8_t filtered = row[i] - predictor;
+                scratch[i] = filtered;
+                sum += abs((int8_t)filtered);
+            }
+
+            if (sum < bestSum)
+            {
+                bestSum = sum;
+                outRow[0] = filterType;
+                memcpy(outRow + 1, scratch.data(), rowSize);
+            }
+        }
+    }
+}
+
+bool ImageWriter::writePng(const std::string& filePath, glm::ivec2 resolution, const uint8_t* pixels)
+{
+    const int rowSize = resolution.x * pngBytesPerPixel;
+    const size_t filteredRowSize = rowSize + 1;
+    const size_t filteredSize = filteredRowSize * resolution.y;
+
+    std::vector<uint8_t> filtered(filteredSize);
+
+    const int numStrips = std::clamp(resolution.y / minRowsPerStrip, 1, ThreadUtils::getNumThreads());
+    const auto getStripBegin = [&](int stripIdx)
+    {
+        return filteredRowSize * ((size_t)resolution.y * stripIdx / numStrips);
+    };
+
+    // each strip becomes its own IDAT chunk so checksums can also be computed in parallel
+    std::vector<std::vector<uint8_t>> stripChunks(numStrips);
+    std::vector<uint32_t> stripAdlers(numStrips);
+    std::vector<size_t> stripSizes(numStrips);
+
+    // a strip is compressed as soon as the strips its deflate window reaches back into are filtered,
+    // so compressing the top of the image overlaps with filtering the rest of it
+    std::vector<ThreadUtils::TaskHandle> filterTasks(numStrips);
+    std::vector<ThreadUtils::TaskHandle> compressTasks(numStrips);
+    for (int stripIdx = 0; stripIdx < numStrips; ++stripIdx)
+    {
+        filterTasks[stripIdx] = ThreadUtils::submit([&, stripIdx]
+        {
+            const int rowBegin = (int)((size_t)resolution.y * stripIdx / numStrips);
+            const int rowEnd = (int)((size_t)resolution.y * (stripIdx + 1) / numStrips);
+
+            std::vector<uint8_t> scratch(rowSize);
+            for (int y = rowBegin; y < rowEnd; ++y)
+            {
+                const uint8_t* row = pixels + (size_t)y * rowSize;
+                const uint8_t* prevRow = y > 0 ? row - rowSize : nullptr;
+                filterRow(row, prevRow, rowSize, filtered.data() + y * filteredRowSize, scratch);
+            }
+        });
+
+        const size_t begin = getStripBegin(stripIdx);
+        const size_t windowBegin = begin > deflateWindowSize ? begin - deflateWindowSize : 0;
+
+        std::vector<ThreadUtils::TaskHandle> dependencies;
+        for (int dependencyIdx = stripIdx; dependencyIdx >= 0; --dependencyIdx)
+        {
+            dependencies.push_back(filterTasks[dependencyIdx]);
+            if (getStripBegin(dependencyIdx) <= windowBegin)
+            {
+                break;
+            }
+        }
+
+        compressTasks[stripIdx] = ThreadUtils::submit([&, stripIdx]
+        {
+            const size_t begin = getStripBegin(stripIdx);
+            const size_t end = getStripBegin(stripIdx + 1);
+
+            std::vector<uint8_t> compressed;
+            compressed.reserve((end - begin) / 2);
+            if (stripIdx == 0)
+            {
+                compressed.insert(compressed.end(), { 0x78, 0x01 }); // zlib header
+            }
+
+            deflateStrip(filtered.data(), filteredSize, begin, end, stripIdx == numStrips - 1, compressed);
+
+            stripAdlers[stripIdx] = adler32(filtered.data() + begin, end - begin);
+            stripSizes[stripIdx] = end - begin;
+
+            appendChunk(stripChunks[stripIdx], "IDAT", compressed.data(), compressed.size());
+        }, dependencies);
+    }
+
+    // every filter task is a dependency of its own strip's compression, so this waits for all of them
+    for (const auto& compressTask : compressTasks)
+    {
+        ThreadUtils::wait(compressTask);
+    }
+
+    uint32_t adler = stripAdlers[0];
+    for (int stripIdx = 1; stripIdx < numStrips; ++stripIdx)
+    {
+        adler = adler32Combine(adler, stripAdlers[stripIdx], stripSizes[stripIdx]);
+    }
+
+    std::vector<uint8_t> header = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    std::vector<uint8_t> ihdr;
+    appendUint32(ihdr, resolution.x);
+    appendUint32(ihdr, resolution.y);
+    ihdr.insert(ihdr.end(), { 8, 6, 0, 0, 0 }); // 8-bit RGBA, deflate, adaptive filtering, no interlacing
+    appendChunk(header, "IHDR", ihdr.data(), ihdr.size());
+
+    std::vector<uint8_t> footer;
+    std::vector<uint8_t> adlerBytes;
+    appendUint32(adlerBytes, adler);
+    appendChunk(footer, "IDAT", adlerBytes.data(), adlerBytes.size()); // end of the zlib stream
+    appendChunk(footer, "IEND", nullptr, 0);
+
+    std::ofstream file(filePath, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+    for (const auto& chunk : stripChunks)
+    {
+        file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+    }
+    file.write(reinterpret_cast<const char*>(footer.data()), footer.size());
+
+    return file.good();
+}
+
+// ==================================================================
+// JPEG
+// ==================================================================
+
+bool ImageWriter::writeJpeg(const std::string& filePath, glm::ivec2 resolution, const uint8_t* pixels, int quality)
+{
+    // alpha is ignored
+    return stbi_write_jpg(filePath.c_str(), resolution.x, resolution.y, 4, pixels, quality) != 0;
+}
+
+// ==================================================================
+// EXR
+// ==================================================================
+
+static constexpr int exrTileSize = 128;
+
+bool ImageWriter::writeExr(const std::string& filePath, glm::ivec2 resolution, const float* pixels, bool half, int compression)
+{
+    // channels are stored alphabetically since most readers expect that order
+    constexpr int numChannels = 4;
+    const char* channelNames[numChannels] = { "A", "B", "G", "R" };
+    const int channelComponents[numChannels] = { 3, 2, 1, 0 };
+
+    const size_t numPixels = (size_t)resolution.x * resolution.y;
+
+    std::vector<float> planes(numPixels * numChannels);
+    // tiles split the work evenly whatever the image's aspect ratio
+    ThreadUtils::parallelForTiles(ImageRegion::fromResolution(resolution), glm::ivec2(exrTileSize), [&](const ImageRegion& tile)
+    {
+        for (int y = tile.min.y; y < tile.max.y; ++y)
+        {
+            for (size_t idx = (size_t)y * resolution.x + tile.min.x; idx < (size_t)y * resolution.x + tile.max.x; ++idx)
+            {
+                for (int channelIdx = 0; channelIdx < numChannels; ++channelIdx)
+                {
+                    planes[channelIdx * numPixels + idx] = pixels[idx * 4 + channelComponents[channelIdx]];
+                }
+            }
+        }
+    });
+
+    float* planePtrs[numChannels];
+    for (int channelIdx = 0; channelIdx < numChannels; ++channelIdx)
+    {
+        planePtrs[channelIdx] = planes.data() + channelIdx * numPixels;
+    }
+
+    EXRImage image;
+    InitEXRImage(&image);
+    image.num_channels = numChannels;
+    image.images = reinterpret_cast<unsigned char**>(planePtrs);
+    image.width = resolution.x;
+    image.height = resolution.y;
+
+    EXRChannelInfo channelInfos[numChannels];
+    int pixelTypes[numChannels];
+    int requestedPixelTypes[numChannels];
+    for (int channelIdx = 0; channelIdx < numChannels; ++channelIdx)
+    {
+        memset(&channelInfos[channelIdx], 0, sizeof(EXRChannelInfo));
+        strncpy(channelInfos[channelIdx].name, channelNames[channelIdx], 255);
+        pixelTypes[channelIdx] = TINYEXR_PIXELTYPE_FLOAT;
+        requestedPixelTypes[channelIdx] = half ? TINYEXR_PIXELTYPE_HALF : TINYEXR_PIXELTYPE_FLOAT;
+    }
+
+    EXRHeader header;
+    InitEXRHeader(&header);
+    header.num_channels = numChannels;
+    header.channels = channelInfos;
+    header.pixel_types = pixelTypes;
+    header.requested_pixel_types = requestedPixelTypes;
+    header.compression_type = compression;
+
+    // chunks are compressed on multiple threads since tinyexr is built with TINYEXR_USE_THREAD
+    const char* err = nullptr;
+    if (SaveEXRImageToFile(&image, &header, filePath.c_str(), &err) != TINYEXR_SUCCESS)
+    {
+        if (err)
+        {
+            fprintf(stderr, "ERR : %s\n", err);
+            FreeEXRErrorMessage(err);
+        }
+
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "tinyexr.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class ImageFormat
+{
+    PNG, JPEG, EXR
+};
+
+struct ImageWriteOptions
+{
+    ImageFormat format{ ImageFormat::PNG };
+
+    int jpegQuality{ 95 }; // 1-100
+
+    bool exrHalf{ true }; // 16-bit half instead of 32-bit float channels
+    int exrCompression{ TINYEXR_COMPRESSIONTYPE_ZIP };
+};
+
+namespace ImageWriter
+{
+    extern const std::vector<const char*> formatNames;
+    extern const std::vector<const char*> exrCompressionNames;
+    extern const std::vector<int> exrCompressionTypes; // parallel to exrCompressionNames
+
+    const char* getExtension(ImageFormat format); // including the dot
+
+    // all functions take interleaved RGBA pixels, top row first, and return false on failure
+
+    bool writePng(const std::string& filePath, glm::ivec2 resolution, const uint8_t* pixels);
+    bool writeJpeg(const std::string& filePath, glm::ivec2 resolution, const uint8_t* pixels, int quality);
+    bool writeExr(const std::string& filePath, glm::ivec2 resolution, const float* pixels, bool half, int compression);
+}
@@ -0,0 +1,228 @@
+#include "sequence_processor.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <unordered_set>
+
+SequenceProcessor::~SequenceProcessor()
+{
+    stop();
+}
+
+// frames are written as <input stem><extension>, so inputs sharing a stem (e.g. shot.png and shot.exr, or the same
+// name in two folders) would overwrite each other. stems are compared case-insensitively since Windows paths are
+static bool findDuplicateStem(const std::vector<std::string>& inputPaths, std::string& outStem)
+{
+    std::unordered_set<std::string> stems;
+    for (const auto& inputPath : inputPaths)
+    {
+        std::string stem = std::filesystem::path(inputPath).stem().string();
+        std::transform(stem.begin(), stem.end(), stem.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        if (!stems.insert(stem).second)
+        {
+            outStem = std::filesystem::path(inputPath).stem().string();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool SequenceProcessor::start(const std::vector<std::string>& inputPaths, const std::string& outputDirectory,
+    const ImageReadOptions& readOptions, const ImageWriteOptions& writeOptions)
+{
+    stop();
+
+    std::string duplicateStem;
+    if (findDuplicateStem(inputPaths, duplicateStem))
+    {
+        fprintf(stderr, "ERR : more than one frame is named %s, their outputs would overwrite each other\n", duplicateStem.c_str());
+        return false;
+    }
+
+    this->inputPaths = inputPaths;
+    this->outputDirectory = outputDirectory;
+    this->readOptions = readOptions;
+    this->writeOptions = writeOptions;
+
+    decodedFrames.reopen();
+    outputFrames.reopen();
+
+    isCancelled = false;
+    isEncodeFinished = false;
+    numFramesWritten = 0;
+    numFramesFailedToRead = 0;
+    numFramesFailedToWrite = 0;
+    isActive = true;
+
+    decodeThread = std::thread(&SequenceProcessor::decodeLoop, this);
+    encodeThread = std::thread(&SequenceProcessor::encodeLoop, this);
+    return true;
+}
+
+void SequenceProcessor::stop()
+{
+    if (!isActive)
+    {
+        return;
+    }
+
+    isCancelled = true;
+    decodedFrames.close();
+    outputFrames.close();
+
+    decodeThread.join();
+    encodeThread.join();
+
+    isActive = false;
+}
+
+bool SequenceProcessor::getIsActive() const
+{
+    return this->isActive;
+}
+
+bool SequenceProcessor::isDone() const
+{
+    return this->isEncodeFinished;
+}
+
+int SequenceProcessor::getNumFrames() const
+{
+    return inputPaths.size();
+}
+
+int SequenceProcessor::getNumFramesWritten() const
+{
+    return this->numFramesWritten;
+}
+
+int SequenceProcessor::getNumFramesFailedToRead() const
+{
+    return this->numFramesFailedToRead;
+}
+
+int SequenceProcessor::getNumFramesFailedToWrite() const
+{
+    return this->numFramesFailedToWrite;
+}
+
+int SequenceProcessor::getNumFramesFinished() const
+{
+    return this->numFramesWritten + this->numFramesFailedToRead + this->numFramesFailedToWrite;
+}
+
+std::string SequenceProcessor::getFailureText() const
+{
+    std::string text;
+    if (this->numFramesFailedToRead > 0)
+    {
+        text = std::to_string(this->numFramesFailedToRead) + " failed to read";
+    }
+
+    if (this->numFramesFailedToWrite > 0)
+    {
+        text += (text.empty() ? "" : ", ") + std::to_string(this->numFramesFailedToWrite) + " failed to save";
+    }
+
+    return text;
+}
+
+const ImageWriteOptions& SequenceProcessor::getWriteOptions() const
+{
+    return this->writeOptions;
+}
+
+bool SequenceProcessor::tryPopDecodedFrame(SequenceFrame& outFrame)
+{
+    return decodedFrames.tryPop(outFrame);
+}
+
+bool SequenceProcessor::canPushOutputFrame() const
+{
+    return !outputFrames.isFull(); // only the main thread pushes, so this can't change before the push
+}
+
+void SequenceProcessor::pushOutputFrame(SequenceOutputFrame&& frame)
+{
+    outputFrames.push(std::move(frame));
+}
+
+void SequenceProcessor::skipOutputFrame(int frameIdx)
+{
+    fprintf(stderr, "ERR : no output image for %s, skipping frame\n", inputPaths[frameIdx].c_str());
+    ++numFramesFailedToWrite;
+}
+
+void SequenceProcessor::finishOutputIfDecodeDone()
+{
+    if (decodedFrames.isDrained())
+    {
+        outputFrames.close();
+    }
+}
+
+void SequenceProcessor::decodeLoop()
+{
+    for (int frameIdx = 0; frameIdx < (int)inputPaths.size() && !isCancelled; ++frameIdx)
+    {
+        SequenceFrame frame;
+        frame.frameIdx = frameIdx;
+
+        if (!ImageReader::readImage(inputPaths[frameIdx], readOptions, frame.image))
+        {
+            fprintf(stderr, "ERR : failed to read %s, skipping frame\n", inputPaths[frameIdx].c_str());
+            ++numFramesFailedToRead;
+            continue;
+        }
+
+        if (!decodedFrames.push(std::move(frame)))
+        {
+            break; // cancelled
+        }
+    }
+
+    decodedFrames.close();
+}
+
+void SequenceProcessor::encodeLoop()
+{
+    const char* extension = ImageWriter::getExtension(writeOptions.format);
+
+    SequenceOutputFrame frame;
+    while (outputFrames.pop(frame) && !isCancelled)
+    {
+        const std::string stem = std::filesystem::path(inputPaths[frame.frameIdx]).stem().string();
+        const std::string outputPath = (std::filesystem::path(outputDirectory) / (stem + extension)).string();
+
+        bool didWrite;
+        switch (writeOptions.format)
+        {
+        case ImageFormat::PNG:
+            didWrite = ImageWriter::writePng(outputPath, frame.resolution, frame.ldrPixels.get());
+            break;
+        case ImageFormat::JPEG:
+            didWrite = ImageWriter::writeJpeg(outputPath, frame.resolution, frame.ldrPixels.get(), writeOptions.jpegQuality);
+            break;
+        case ImageFormat::EXR:
+            didWrite = ImageWriter::writeExr(outputPath, frame.resolution, frame.linearPixels.get(), writeOptions.exrHalf, writeOptions.exrCompression);
+            break;
+        default:
+            didWrite = false;
+            break;
+        }
+
+        if (didWrite)
+        {
+            ++numFramesWritten;
+        }
+        else
+        {
+            fprintf(stderr, "ERR : failed to save %s\n", outputPath.c_str());
+            ++numFramesFailedToWrite;
+        }
+    }
+
+    isEncodeFinished = true;
+}
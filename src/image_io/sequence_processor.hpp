@@ -0,0 +1,82 @@
+#pragma once
+
+#include "bounded_queue.hpp"
+#include "image_io/image_reader.hpp"
+#include "image_io/image_writer.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+struct SequenceFrame
+{
+    int frameIdx{ -1 };
+    HostImage image;
+};
+
+struct SequenceOutputFrame
+{
+    int frameIdx{ -1 };
+    glm::ivec2 resolution{ 0, 0 };
+    std::unique_ptr<uint8_t[]> ldrPixels; // PNG and JPEG
+    std::unique_ptr<float[]> linearPixels; // EXR
+};
+
+// runs a frame sequence through the node network as a three stage pipeline:
+// - a decode thread reads frame N + 1
+// - the main thread evaluates frame N (CUDA and OpenGL calls have to stay there)
+// - an encode thread writes frame N - 1
+// stages are connected by small bounded queues so throughput is limited by the slowest stage instead of the sum of all three
+class SequenceProcessor
+{
+private:
+    static constexpr int queueCapacity = 2;
+
+    std::vector<std::string> inputPaths;
+    std::string outputDirectory;
+    ImageReadOptions readOptions;
+    ImageWriteOptions writeOptions;
+
+    BoundedQueue<SequenceFrame> decodedFrames{ queueCapacity };
+    BoundedQueue<SequenceOutputFrame> outputFrames{ queueCapacity };
+
+    std::thread decodeThread;
+    std::thread encodeThread;
+
+    bool isActive{ false };
+    std::atomic<bool> isCancelled{ false };
+    std::atomic<bool> isEncodeFinished{ false };
+    std::atomic<int> numFramesWritten{ 0 };
+    std::atomic<int> numFramesFailedToRead{ 0 };
+    std::atomic<int> numFramesFailedToWrite{ 0 }; // including frames the network produced no image for
+
+public:
+    SequenceProcessor() = default;
+    ~SequenceProcessor();
+
+    // false if two inputs would be written to the same output file
+    bool start(const std::vector<std::string>& inputPaths, const std::string& outputDirectory,
+        const ImageReadOptions& readOptions, const ImageWriteOptions& writeOptions);
+    void stop(); // cancels any frames that haven't been written yet
+
+    bool getIsActive() const;
+    bool isDone() const; // every frame has been written
+    int getNumFrames() const;
+    int getNumFramesWritten() const;
+    int getNumFramesFailedToRead() const;
+    int getNumFramesFailedToWrite() const;
+    int getNumFramesFinished() const; // written or failed, reaches getNumFrames() once every frame has been handled
+    std::string getFailureText() const; // e.g. "1 failed to read, 2 failed to save", empty if nothing failed
+    const ImageWriteOptions& getWriteOptions() const;
+
+    // main thread side of the pipeline
+    bool tryPopDecodedFrame(SequenceFrame& outFrame);
+    bool canPushOutputFrame() const;
+    void pushOutputFrame(SequenceOutputFrame&& frame);
+    void skipOutputFrame(int frameIdx); // for frames that evaluated to nothing that can be written
+    void finishOutputIfDecodeDone(); // lets the encode thread exit once every decoded frame has been evaluated
+
+private:
+    void decodeLoop();
+    void encodeLoop();
+};
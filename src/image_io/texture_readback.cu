@@ -0,0 +1,60 @@
+#include "texture_readback.hpp"
+
+#include "nodes/node_utils.hpp"
+
+static constexpr int readbackBlockSize = 512;
+
+__global__ void kernToLdr(Texture inTex, uchar4* out)
+{
+    const int idx = (blockIdx.x * blockDim.x) + threadIdx.x;
+
+    if (idx >= inTex.getNumPixels())
+    {
+        return;
+    }
+
+    glm::vec4 col = glm::clamp(inTex.getColor<TextureType::MULTI>(idx), 0.f, 1.f);
+    out[idx] = make_uchar4(col.r * 255.99f, col.g * 255.99f, col.b * 255.99f, col.a * 255.99f);
+}
+
+__global__ void kernToLinear(Texture inTex, glm::vec4* out)
+{
+    const int idx = (blockIdx.x * blockDim.x) + threadIdx.x;
+
+    if (idx >= inTex.getNumPixels())
+    {
+        return;
+    }
+
+    out[idx] = ColorUtils::srgbToLinear(inTex.getColor<TextureType::MULTI>(idx));
+}
+
+void TextureReadback::readLdr(Texture* tex, uint8_t* host_pixels)
+{
+    const int numPixels = tex->getNumPixels();
+
+    uchar4* dev_pixels;
+    CUDA_CHECK(cudaMalloc(&dev_pixels, numPixels * sizeof(uchar4)));
+
+    const dim3 blockSize(readbackBlockSize);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(numPixels, blockSize);
+    kernToLdr<<<blocksPerGrid, blockSize>>>(*tex, dev_pixels);
+
+    CUDA_CHECK(cudaMemcpy(host_pixels, dev_pixels, numPixels * sizeof(uchar4), cudaMemcpyDeviceToHost));
+    CUDA_CHECK(cudaFree(dev_pixels));
+}
+
+void TextureReadback::readLinear(Texture* tex, float* host_pixels)
+{
+    const int numPixels = tex->getNumPixels();
+
+    glm::vec4* dev_pixels;
+    CUDA_CHECK(cudaMalloc(&dev_pixels, numPixels * sizeof(glm::vec4)));
+
+    const dim3 blockSize(readbackBlockSize);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(numPixels, blockSize);
+    kernToLinear<<<blocksPerGrid, blockSize>>>(*tex, dev_pixels);
+
+    CUDA_CHECK(cudaMemcpy(host_pixels, dev_pixels, numPixels * sizeof(glm::vec4), cudaMemcpyDeviceToHost));
+    CUDA_CHECK(cudaFree(dev_pixels));
+}
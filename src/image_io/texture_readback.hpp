@@ -0,0 +1,15 @@
+#pragma once
+
+#include "texture.hpp"
+
+#include <cstdint>
+
+// converts on the GPU so only the final pixel format is copied back to the host
+namespace TextureReadback
+{
+    // 8-bit RGBA, values are clamped to [0, 1]
+    void readLdr(Texture* tex, uint8_t* host_pixels);
+
+    // float RGBA with the output node's sRGB encoding removed, values above 1 are preserved
+    void readLinear(Texture* tex, float* host_pixels);
+}
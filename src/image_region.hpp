@@ -0,0 +1,86 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include "cuda_includes.hpp"
+
+// axis-aligned pixel rectangle, min inclusive and max exclusive
+struct ImageRegion
+{
+    static constexpr int maxCoordinate = 1 << 28; // leaves room to expand unbounded regions without overflowing
+
+    glm::ivec2 min{ 0, 0 };
+    glm::ivec2 max{ 0, 0 };
+
+    __host__ __device__ static inline ImageRegion fromResolution(glm::ivec2 resolution)
+    {
+        return { glm::ivec2(0, 0), resolution };
+    }
+
+    // covers any image, used when a node needs all of its inputs regardless of what's requested from it
+    __host__ __device__ static inline ImageRegion unbounded()
+    {
+        return { glm::ivec2(-maxCoordinate), glm::ivec2(maxCoordinate) };
+    }
+
+    __host__ __device__ inline glm::ivec2 getSize() const
+    {
+        return glm::max(max - min, glm::ivec2(0));
+    }
+
+    __host__ __device__ inline int getNumPixels() const
+    {
+        glm::ivec2 size = getSize();
+        return size.x * size.y;
+    }
+
+    __host__ __device__ inline bool isEmpty() const
+    {
+        return max.x <= min.x || max.y <= min.y;
+    }
+
+    __host__ __device__ inline bool contains(const ImageRegion& other) const
+    {
+        return other.isEmpty() || (glm::all(glm::greaterThanEqual(other.min, min)) && glm::all(glm::lessThanEqual(other.max, max)));
+    }
+
+    __host__ __device__ inline ImageRegion intersect(const ImageRegion& other) const
+    {
+        return { glm::max(min, other.min), glm::min(max, other.max) };
+    }
+
+    // bounding box of both regions
+    __host__ __device__ inline ImageRegion unite(const ImageRegion& other) const
+    {
+        if (isEmpty())
+        {
+            return other;
+        }
+
+        if (other.isEmpty())
+        {
+            return *this;
+        }
+
+        return { glm::min(min, other.min), glm::max(max, other.max) };
+    }
+
+    __host__ __device__ inline ImageRegion offset(glm::ivec2 amount) const
+    {
+        return { min + amount, max + amount };
+    }
+
+    __host__ __device__ inline ImageRegion expand(int amount) const
+    {
+        if (isEmpty())
+        {
+            return *this;
+        }
+
+        return { glm::max(min - amount, glm::ivec2(-maxCoordinate)), glm::min(max + amount, glm::ivec2(maxCoordinate)) };
+    }
+
+    __host__ __device__ inline bool operator==(const ImageRegion& other) const
+    {
+        return min == other.min && max == other.max;
+    }
+};
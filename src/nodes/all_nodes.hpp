@@ -10,6 +10,7 @@
 #include "types/node_uvgradient.hpp"
 #include "types/node_color.hpp"
 #include "types/node_fileinput.hpp"
+#include "types/node_exrinput.hpp"
 #include "types/node_exposure.hpp"
 #include "types/node_brightnesscontrast.hpp"
 #include "types/node_bloom.hpp"
@@ -20,3 +21,4 @@
 #include "types/node_separatecomponents.hpp"
 #include "types/node_math.hpp"
 #include "types/node_colorramp.hpp"
+#include "types/node_expression.hpp"
@@ -0,0 +1,182 @@
+#include "compiled_graph.hpp"
+
+#include "node.hpp"
+#include "edge.hpp"
+
+#include <unordered_map>
+#include <cstdio>
+
+void CompiledGraph::compile(Node* outputNode)
+{
+    invalidate();
+
+    // depth first post-order from the output, visiting inputs in pin order
+    // this keeps each branch together and evaluates earlier pins first, so e.g. a mix node's factor is known before either
+    // of its images is evaluated and the evaluator can skip the image that isn't needed
+    enum class VisitState
+    {
+        IN_PROGRESS,
+        DONE
+    };
+
+    struct StackEntry
+    {
+        Node* node;
+        int nextInputPinIdx;
+    };
+
+    std::unordered_map<Node*, VisitState> visitStates;
+    std::vector<StackEntry> stack;
+    std::vector<Node*> postOrder;
+    bool hasCycle = false;
+
+    stack.push_back({ outputNode, 0 });
+    visitStates[outputNode] = VisitState::IN_PROGRESS;
+    while (!stack.empty())
+    {
+        StackEntry& entry = stack.back();
+        if (entry.nextInputPinIdx == entry.node->inputPins.size())
+        {
+            visitStates[entry.node] = VisitState::DONE;
+            postOrder.push_back(entry.node);
+            stack.pop_back();
+            continue;
+        }
+
+        const Pin& inputPin = entry.node->inputPins[entry.nextInputPinIdx++];
+        for (const auto& edge : inputPin.getEdges()) // should be at most 1 edge
+        {
+            Node* otherNode = edge->startPin->getNode();
+
+            auto it = visitStates.find(otherNode);
+            if (it == visitStates.end())
+            {
+                visitStates[otherNode] = VisitState::IN_PROGRESS;
+                stack.push_back({ otherNode, 0 }); // invalidates entry
+                break;
+            }
+
+            if (it->second == VisitState::IN_PROGRESS)
+            {
+                hasCycle = true;
+            }
+        }
+    }
+
+    if (hasCycle)
+    {
+        // nothing upstream of the output gets evaluated, same as if the cycle had been rejected when it was connected
+        printf("WARNING: node graph has a cycle, nothing will be evaluated\n");
+        this->isValid = true;
+        return;
+    }
+
+    for (Node* node : postOrder)
+    {
+        node->setCompiledIdx(this->nodes.size());
+        this->nodes.push_back(node);
+    }
+
+    const int numNodes = this->nodes.size();
+
+    this->inputOffsets.reserve(numNodes + 1);
+    for (Node* node : this->nodes)
+    {
+        this->inputOffsets.push_back(this->inputs.size());
+
+        for (int inputPinIdx = 0; inputPinIdx < node->inputPins.size(); ++inputPinIdx)
+        {
+            for (const auto& edge : node->inputPins[inputPinIdx].getEdges())
+            {
+                this->inputs.push_back({ edge->startPin->getNode()->getCompiledIdx(), inputPinIdx, edge->startPin });
+            }
+        }
+    }
+    this->inputOffsets.push_back(this->inputs.size());
+
+    // consumers always come later in the order, so walking backwards sees every consumer's mask before its producers
+    this->numWords = (numNodes + 63) / 64;
+    this->descendantMasks.assign((size_t)numNodes * this->numWords, 0);
+    for (int nodeIdx = numNodes - 1; nodeIdx >= 0; --nodeIdx)
+    {
+        uint64_t* mask = &this->descendantMasks[(size_t)nodeIdx * this->numWords];
+        mask[nodeIdx / 64] |= 1ull << (nodeIdx % 64);
+
+        for (const Input* input = getInputsBegin(nodeIdx); input != getInputsEnd(nodeIdx); ++input)
+        {
+            uint64_t* otherMask = &this->descendantMasks[(size_t)input->nodeIdx * this->numWords];
+            for (int word = 0; word < this->numWords; ++word)
+            {
+                otherMask[word] |= mask[word];
+            }
+        }
+    }
+
+    this->isValid = true;
+}
+
+void CompiledGraph::invalidate()
+{
+    for (Node* node : this->nodes)
+    {
+        node->setCompiledIdx(-1);
+    }
+
+    this->nodes.clear();
+    this->inputOffsets.clear();
+    this->inputs.clear();
+    this->numWords = 0;
+    this->descendantMasks.clear();
+    this->isValid = false;
+}
+
+bool CompiledGraph::getIsValid() const
+{
+    return this->isValid;
+}
+
+int CompiledGraph::getNumNodes() const
+{
+    return this->nodes.size();
+}
+
+Node* CompiledGraph::getNode(int nodeIdx) const
+{
+    return this->nodes[nodeIdx];
+}
+
+const CompiledGraph::Input* CompiledGraph::getInputsBegin(int nodeIdx) const
+{
+    return this->inputs.data() + this->inputOffsets[nodeIdx];
+}
+
+const CompiledGraph::Input* CompiledGraph::getInputsEnd(int nodeIdx) const
+{
+    return this->inputs.data() + this->inputOffsets[nodeIdx + 1];
+}
+
+int CompiledGraph::getNumInputs() const
+{
+    return this->inputs.size();
+}
+
+int CompiledGraph::getInputIdx(const Input* input) const
+{
+    return input - this->inputs.data();
+}
+
+int CompiledGraph::getNumWords() const
+{
+    return this->numWords;
+}
+
+void CompiledGraph::addDescendants(int nodeIdx, std::vector<uint64_t>& mask) const
+{
+    mask.resize(this->numWords, 0);
+
+    const uint64_t* descendantMask = &this->descendantMasks[(size_t)nodeIdx * this->numWords];
+    for (int word = 0; word < this->numWords; ++word)
+    {
+        mask[word] |= descendantMask[word];
+    }
+}
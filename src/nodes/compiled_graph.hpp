@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+class Node;
+class Pin;
+
+// flat, index based form of everything upstream of the output node
+// node indices double as positions in a topological order, so the output node is always last
+// only rebuilt when edges change, parameter edits just flip bits
+class CompiledGraph
+{
+public:
+    struct Input
+    {
+        int nodeIdx; // producer
+        int inputPinIdx; // on the consumer
+        Pin* outputPin; // on the producer
+    };
+
+private:
+    bool isValid{ false };
+
+    std::vector<Node*> nodes;
+
+    // CSR, the inputs of node i are inputs[inputOffsets[i]] to inputs[inputOffsets[i + 1] - 1]
+    std::vector<int> inputOffsets;
+    std::vector<Input> inputs;
+
+    // numWords 64-bit words per node, each node's mask includes itself
+    int numWords{ 0 };
+    std::vector<uint64_t> descendantMasks;
+
+public:
+    void compile(Node* outputNode);
+    void invalidate(); // resets the nodes' indices, so call it before any of them are deleted
+
+    bool getIsValid() const;
+
+    int getNumNodes() const;
+    Node* getNode(int nodeIdx) const;
+
+    const Input* getInputsBegin(int nodeIdx) const;
+    const Input* getInputsEnd(int nodeIdx) const;
+    int getNumInputs() const;
+    int getInputIdx(const Input* input) const; // position across all nodes' inputs, for per-edge state
+
+    int getNumWords() const;
+    void addDescendants(int nodeIdx, std::vector<uint64_t>& mask) const; // mask |= descendants of nodeIdx
+};
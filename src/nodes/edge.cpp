@@ -8,13 +8,13 @@ Edge::Edge(Pin* startPin, Pin* endPin)
 
 Texture* Edge::getTexture() const
 {
-    Texture* startPinCachedTexture = startPin->getCachedTexture();
-    if (startPinCachedTexture != nullptr)
+    // set while the end node is being evaluated, either the start pin's cache or a buffer it was materialized into
+    if (this->texture != nullptr)
     {
-        return startPinCachedTexture;
+        return this->texture;
     }
 
-    return this->texture;
+    return startPin->getCachedTexture();
 }
 
 void Edge::setTexture(Texture* texture)
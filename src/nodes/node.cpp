@@ -12,8 +12,19 @@ Node::Node(const std::string& name)
     Node::nextId += NODE_ID_STRIDE;
 }
 
+// the node evaluator keeps pointers to cached pins, so they're unregistered here whichever way the node is deleted
 Node::~Node()
-{}
+{
+    if (this->nodeEvaluator == nullptr)
+    {
+        return;
+    }
+
+    for (auto& outputPin : outputPins)
+    {
+        outputPin.deleteCache();
+    }
+}
 
 Pin& Node::addPin(PinType type, const std::string& name)
 {
@@ -27,7 +38,7 @@ Pin& Node::addPin(PinType type)
     return addPin(type, type == PinType::INPUT ? "input" : "output");
 }
 
-bool Node::getIsExpensive()
+bool Node::getIsExpensive() const
 {
     return this->isExpensive;
 }
@@ -37,6 +48,136 @@ void Node::setExpensive()
     this->isExpensive = true;
 }
 
+bool Node::getIsCachingOutputs() const
+{
+    return this->isCachingOutputs;
+}
+
+void Node::setIsCachingOutputs(bool isCachingOutputs)
+{
+    this->isCachingOutputs = isCachingOutputs;
+}
+
+float Node::getEvaluationMs(int level) const
+{
+    return this->evaluationMs[level];
+}
+
+void Node::recordEvaluationMs(int level, float ms)
+{
+    // smoothed since times vary with the evaluated region and whatever else the GPU is doing
+    float& smoothedMs = this->evaluationMs[level];
+    smoothedMs = smoothedMs == 0.f ? ms : glm::mix(smoothedMs, ms, 0.3f);
+}
+
+bool Node::getNeedsFullImage() const
+{
+    return this->needsFullImage;
+}
+
+void Node::setNeedsFullImage()
+{
+    this->needsFullImage = true;
+}
+
+bool Node::getIsInPlace() const
+{
+    return this->isInPlace;
+}
+
+void Node::setInPlace()
+{
+    this->isInPlace = true;
+}
+
+bool Node::getReadsProceduralInputs() const
+{
+    return this->readsProceduralInputs;
+}
+
+void Node::setReadsProceduralInputs()
+{
+    this->readsProceduralInputs = true;
+}
+
+Texture* Node::requestOutputTexture(Texture* inTex, TextureType textureType)
+{
+    const int narrowedChannel = textureType == TextureType::MULTI ? getNarrowedChannel() : -1;
+    const bool isSingle = textureType == TextureType::SINGLE || narrowedChannel != -1;
+
+    const bool isMatchingType = isSingle ? inTex->isType<TextureType::SINGLE>() : inTex->isType<TextureType::MULTI>();
+    // outputs have to stay dense and interleaved for Texture::storeColor(), so planar inputs get a new texture
+    const bool isInterleaved = inTex->getLayout() == TextureLayout::INTERLEAVED;
+    if (this->isInPlace && isMatchingType && isInterleaved && nodeEvaluator->canWriteInPlace(inputPins[0], inTex))
+    {
+        nodeEvaluator->claimTexture(inTex);
+        inTex->setNarrowedChannel(narrowedChannel);
+        return inTex;
+    }
+
+    return requestOutputTexture(inTex->resolution, textureType);
+}
+
+Texture* Node::requestOutputTexture(glm::ivec2 resolution, TextureType textureType)
+{
+    const int narrowedChannel = textureType == TextureType::MULTI ? getNarrowedChannel() : -1;
+    if (textureType == TextureType::MULTI && narrowedChannel == -1)
+    {
+        return nodeEvaluator->requestTexture<TextureType::MULTI>(resolution);
+    }
+
+    Texture* outTex = nodeEvaluator->requestTexture<TextureType::SINGLE>(resolution);
+    outTex->setNarrowedChannel(narrowedChannel);
+    return outTex;
+}
+
+int Node::getNarrowedChannel() const
+{
+    // caches can be read again by consumers that demand other channels, so only outputs that are released after this
+    // evaluation are narrowed
+    if (this->isCachingOutputs)
+    {
+        return -1;
+    }
+
+    switch (outputPins[0].getChannelDemand())
+    {
+    case Channels::R:
+        return 0;
+    case Channels::G:
+        return 1;
+    case Channels::B:
+        return 2;
+    default:
+        return -1;
+    }
+}
+
+ImageRegion Node::getInputRegion(int inputPinIdx, const ImageRegion& outputRegion) const
+{
+    return outputRegion;
+}
+
+uint8_t Node::getInputChannelDemand(int inputPinIdx) const
+{
+    return inputPins[inputPinIdx].getTextureType() == TextureType::SINGLE ? Channels::RGB : Channels::RGBA;
+}
+
+const ImageRegion& Node::getOutputRegion() const
+{
+    return this->outputRegion;
+}
+
+void Node::setOutputRegion(const ImageRegion& outputRegion)
+{
+    this->outputRegion = outputRegion;
+}
+
+ImageRegion Node::getEvaluationRegion(glm::ivec2 resolution) const
+{
+    return this->outputRegion.intersect(ImageRegion::fromResolution(resolution));
+}
+
 unsigned int Node::getTitleBarColor() const
 {
     return IM_COL32(11, 109, 191, 255);
@@ -65,12 +206,70 @@ Texture* Node::getPinTextureOrUniformColor(const Pin& pin, float col)
     return getPinTextureOrUniformColor(pin, Texture::singleToMulti(col));
 }
 
+bool Node::getUniformInput(const Pin& pin, float backupValue, float& value) const
+{
+    if (!pin.hasEdge())
+    {
+        value = backupValue;
+        return true;
+    }
+
+    Texture* tex = pin.getSingleTexture();
+    if (tex == nullptr || !tex->isUniform())
+    {
+        return false;
+    }
+
+    value = tex->getUniformColor<TextureType::SINGLE>();
+    return true;
+}
+
+bool Node::isInputNeeded(int inputPinIdx) const
+{
+    return true;
+}
+
+void Node::snapshotParameters()
+{
+    // do nothing, should be overridden by nodes with parameters
+}
+
+bool Node::hashParameters(Hasher& hasher) const
+{
+    return true; // nothing to add for nodes without parameters
+}
+
 // can potentially add pre- and post-effects to this function
 void Node::evaluate()
 {
+    if (!this->readsProceduralInputs)
+    {
+        materializeProceduralInputs();
+    }
+
     _evaluate();
 }
 
+void Node::materializeProceduralInputs()
+{
+    for (int inputPinIdx = 0; inputPinIdx < this->inputPins.size(); ++inputPinIdx)
+    {
+        for (Edge* edge : this->inputPins[inputPinIdx].getEdges())
+        {
+            Texture* tex = edge->getTexture();
+            if (tex == nullptr || !tex->isProcedural())
+            {
+                continue;
+            }
+
+            // only what this node reads, other consumers sample the function themselves or materialize their own part
+            Texture* bufferTex = nodeEvaluator->materializeProcedural(*tex, getInputRegion(inputPinIdx, this->outputRegion));
+            edge->clearTexture();
+            edge->setTexture(bufferTex);
+        }
+    }
+}
+
 void Node::clearInputTextures()
 {
     for (auto& inputPin : this->inputPins)
@@ -89,6 +288,26 @@ void Node::setIsBeingEvaluated(bool isBeingEvaluated)
     this->isBeingEvaluated = isBeingEvaluated;
 }
 
+int Node::getCompiledIdx() const
+{
+    return this->compiledIdx;
+}
+
+void Node::setCompiledIdx(int compiledIdx)
+{
+    this->compiledIdx = compiledIdx;
+}
+
+uint64_t Node::getResultHash() const
+{
+    return this->resultHash;
+}
+
+void Node::setResultHash(uint64_t resultHash)
+{
+    this->resultHash = resultHash;
+}
+
 Pin& Node::getPin(int pinId)
 {
     for (auto& inputPin : inputPins) 
@@ -112,8 +331,18 @@ void Node::setNodeEvaluator(NodeEvaluator* nodeEvaluator)
     this->nodeEvaluator = nodeEvaluator;
 }
 
+NodeEvaluator* Node::getNodeEvaluator() const
+{
+    return this->nodeEvaluator;
+}
+
 void Node::drawPin(const Pin& pin, int pinNumber, bool& didParameterChange)
 {
+    if (!pin.getIsVisible())
+    {
+        return;
+    }
+
     ImNodes::PushColorStyle(ImNodesCol_Pin, pin.getColor());
     ImNodes::PushColorStyle(ImNodesCol_PinHovered, pin.getHoveredColor());
 
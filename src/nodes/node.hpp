@@ -2,6 +2,8 @@
 
 #define NODE_ID_STRIDE 32
 
+#define NUM_RESOLUTION_LEVELS 4 // full resolution plus 1/2, 1/4, and 1/8 scale proxies
+
 #define DEFAULT_BLOCK_SIZE_1D 512
 #define DEFAULT_BLOCK_SIZE_2D_X 32
 #define DEFAULT_BLOCK_SIZE_2D_Y 32
@@ -13,6 +15,8 @@
 #include "node_utils.hpp"
 #include "texture.hpp"
 #include "color_utils.hpp"
+#include "image_region.hpp"
+#include "hash_utils.hpp"
 
 #include "ImGui/imgui.h"
 
@@ -31,6 +35,16 @@ private:
     static int nextId;
 
     bool isExpensive{ false };
+    bool isCachingOutputs{ false }; // chosen by the node evaluator's cost model before each evaluation
+    float evaluationMs[NUM_RESOLUTION_LEVELS]{}; // smoothed measured time per resolution level, 0 until timed
+    bool needsFullImage{ false };
+    bool isInPlace{ false };
+    bool readsProceduralInputs{ false };
+
+    ImageRegion outputRegion{}; // what downstream nodes need from this node in the current evaluation
+
+    int compiledIdx{ -1 };
+    uint64_t resultHash{ 0 }; // 0 if the result can't be reused
 
 protected:
     const std::string name;
@@ -47,7 +61,20 @@ protected:
     Pin& addPin(PinType type, const std::string& name);
     Pin& addPin(PinType type);
 
-    void setExpensive();
+    void setExpensive(); // caches outputs until the node has been timed, after that the node evaluator's cost model decides
+    void setNeedsFullImage(); // for nodes that always read and write entire images, e.g. anything with global operations
+    void setInPlace(); // for pointwise nodes that can write their output over their first input
+    // for pointwise nodes that read every input through Texture::dispatchKinds() and Texture::fetchColor(), which sample
+    // procedural textures inline, other nodes get procedural inputs materialized into buffers before they're evaluated
+    void setReadsProceduralInputs();
+
+    // in-place nodes get inTex (from the first input pin) back if nothing else will read it, which keeps chains of them in one buffer
+    // MULTI outputs only demanded in one of R, G, or B are stored as a SINGLE texture of that channel, so kernels have to
+    // write them with Texture::storeColor(), consumers read the channel back as every color channel
+    Texture* requestOutputTexture(Texture* inTex, TextureType textureType);
+    Texture* requestOutputTexture(glm::ivec2 resolution, TextureType textureType);
+
+    ImageRegion getEvaluationRegion(glm::ivec2 resolution) const; // output region clipped to an image
 
     virtual unsigned int getTitleBarColor() const;
     virtual unsigned int getTitleBarHoveredColor() const;
@@ -56,6 +83,10 @@ protected:
     Texture* getPinTextureOrUniformColor(const Pin& pin, glm::vec4 col);
     Texture* getPinTextureOrUniformColor(const Pin& pin, float col);
 
+    // true iff the pin is known to hold a single value right now, either its backup value or an input that's uniform
+    // inputs are known once they've been evaluated in the current evaluation, or if they're cached
+    bool getUniformInput(const Pin& pin, float backupValue, float& value) const;
+
     virtual bool drawPinBeforeExtras(const Pin* pin, int pinNumber);
     virtual bool drawPinExtras(const Pin* pin, int pinNumber);
     virtual bool drawPinAfterExtras(const Pin* pin, int pinNumber);
@@ -68,16 +99,54 @@ public:
     Pin& getPin(int pinId);
 
     void setNodeEvaluator(NodeEvaluator* nodeEvaluator);
+    NodeEvaluator* getNodeEvaluator() const;
+
+    // copies parameters edited by the UI into the ones read by _evaluate(), called on the main thread while nothing is being evaluated
+    virtual void snapshotParameters();
+
+    // adds every snapshotted parameter that _evaluate() reads, inputs are handled by the node evaluator
+    // returns false if results can't be reused from one evaluation to another (e.g. they depend on external data)
+    virtual bool hashParameters(Hasher& hasher) const;
 
     void evaluate();
     void clearInputTextures();
 
-    bool getIsExpensive();
+    bool getIsExpensive() const;
+    bool getIsCachingOutputs() const;
+    void setIsCachingOutputs(bool isCachingOutputs);
+    float getEvaluationMs(int level) const;
+    void recordEvaluationMs(int level, float ms);
+    bool getNeedsFullImage() const;
+    bool getIsInPlace() const;
+    bool getReadsProceduralInputs() const;
+
+    // false if the input can't affect the output given what's known about the other inputs (see getUniformInput())
+    // asked again whenever one of the inputs is evaluated, unneeded inputs are skipped and read as their backup values
+    virtual bool isInputNeeded(int inputPinIdx) const;
+
+    // region of the given input needed to produce outputRegion, pointwise nodes need exactly the same region
+    virtual ImageRegion getInputRegion(int inputPinIdx, const ImageRegion& outputRegion) const;
+
+    // channels of the given input needed to produce the channels demanded of the outputs (see Pin::getChannelDemand())
+    // single channel inputs are read as luminance, so by default they need RGB and other inputs need everything
+    virtual uint8_t getInputChannelDemand(int inputPinIdx) const;
+
+    const ImageRegion& getOutputRegion() const;
+    void setOutputRegion(const ImageRegion& outputRegion);
 
     bool getIsBeingEvaluated();
     void setIsBeingEvaluated(bool isBeingEvaluated);
 
+    int getCompiledIdx() const; // index in the node evaluator's compiled graph, -1 if it isn't part of it
+    void setCompiledIdx(int compiledIdx);
+
+    uint64_t getResultHash() const; // of the current evaluation, covers parameters and everything upstream
+    void setResultHash(uint64_t resultHash);
+
 private:
+    void materializeProceduralInputs();
+    int getNarrowedChannel() const; // channel the first output is stored as, -1 for all of them
+
     void drawPin(const Pin& pin, int pinNumber, bool& didParameterChange);
 
 public:
@@ -1,15 +1,19 @@
 #include "node_evaluator.hpp"
 
-#include <stack>
+#include <bit>
 #include <queue>
 #include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
 
 NodeEvaluator::NodeEvaluator(glm::ivec2 outputResolution)
-    : outputResolution(outputResolution), viewerTex(-1)
+    : outputResolution(outputResolution)
 {}
 
 NodeEvaluator::~NodeEvaluator()
 {
+    stopWorker();
+
     for (const auto& [res, resTextures] : this->textures)
     {
         for (const auto& tex : resTextures)
@@ -17,21 +21,135 @@ NodeEvaluator::~NodeEvaluator()
             tex->free();
         }
     }
+
+    for (cudaEvent_t event : this->timingEvents)
+    {
+        CUDA_CHECK(cudaEventDestroy(event));
+    }
+
+    viewerStaging.free();
 }
 
 void NodeEvaluator::init()
 {
-    glActiveTexture(GL_TEXTURE0);
-    glGenTextures(1, &viewerTex);
-    glBindTexture(GL_TEXTURE_2D, viewerTex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    viewerStaging.init();
+}
+
+void NodeEvaluator::startWorker()
+{
+    if (this->isWorkerRunning)
+    {
+        return;
+    }
+
+    this->isWorkerRunning = true;
+    this->workerThread = std::thread(&NodeEvaluator::workerLoop, this);
+}
+
+void NodeEvaluator::stopWorker()
+{
+    if (!this->workerThread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->workerMutex);
+        this->isWorkerRunning = false;
+        this->hasPendingJob = false;
+        this->cancelRequested = true;
+    }
+    this->workerCondition.notify_all();
+
+    this->workerThread.join();
+    this->cancelRequested = false;
+}
+
+void NodeEvaluator::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(this->workerMutex);
+    while (true)
+    {
+        this->workerCondition.wait(lock, [this] { return this->hasPendingJob || !this->isWorkerRunning; });
+
+        if (!this->isWorkerRunning)
+        {
+            return;
+        }
+
+        const ImageRegion outputRegion = this->pendingOutputRegion;
+        this->hasPendingJob = false;
+        this->isEvaluating = true;
+
+        lock.unlock();
+        evaluate(outputRegion);
+        lock.lock();
+
+        this->isEvaluating = false;
+        this->cancelRequested = false; // cleared here so a request can't leak into the next job
+        this->workerCondition.notify_all();
+    }
+}
+
+void NodeEvaluator::submit(const ImageRegion& outputRegion)
+{
+    applyChangedNodes();
+
+    if (!this->compiledGraph.getIsValid())
+    {
+        this->compiledGraph.compile(this->outputNode);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->workerMutex);
+        this->pendingOutputRegion = outputRegion;
+        this->hasPendingJob = true;
+    }
+    this->workerCondition.notify_all();
+}
+
+bool NodeEvaluator::isBusy()
+{
+    std::lock_guard<std::mutex> lock(this->workerMutex);
+    return this->hasPendingJob || this->isEvaluating;
+}
+
+void NodeEvaluator::requestCancel()
+{
+    std::lock_guard<std::mutex> lock(this->workerMutex);
+    this->hasPendingJob = false;
+    if (this->isEvaluating)
+    {
+        this->cancelRequested = true;
+    }
+}
+
+void NodeEvaluator::cancelEvaluation()
+{
+    std::unique_lock<std::mutex> lock(this->workerMutex);
+    this->hasPendingJob = false;
+    if (this->isEvaluating)
+    {
+        this->cancelRequested = true;
+        this->workerCondition.wait(lock, [this] { return !this->isEvaluating; });
+    }
+    lock.unlock();
+
+    applyChangedNodes();
+}
+
+bool NodeEvaluator::isCancelRequested() const
+{
+    return this->cancelRequested;
 }
 
 void NodeEvaluator::setOutputNode(Node* outputNode)
 {
+    if (outputNode != this->outputNode)
+    {
+        invalidateGraph();
+    }
+
     this->outputNode = outputNode;
 }
 
@@ -40,188 +158,1160 @@ Texture* NodeEvaluator::requestUniformTexture()
     return this->requestTexture<TextureType::MULTI>(glm::ivec2(0));
 }
 
-Texture* NodeEvaluator::getOutputTexture() const
+bool NodeEvaluator::canWriteInPlace(const Pin& inputPin, Texture* tex) const
 {
-    return this->outputTexture;
+    if (tex->isUniform() || tex->isView() || tex->isProcedural() || !inputPin.hasEdge())
+    {
+        return false;
+    }
+
+    // a cache holds a reference too, but it's read directly by the edge when the edge itself holds nothing
+    const Pin* outputPin = (*inputPin.getEdges().begin())->startPin;
+    if (outputPin->getCachedTexture() == tex)
+    {
+        return false;
+    }
+
+    const int numPlanReferences = std::count(this->plannedTextureHolds.begin(), this->plannedTextureHolds.end(), tex);
+    return tex->numReferences == 1 + numPlanReferences;
 }
 
-void NodeEvaluator::setOutputTexture(Texture* texture)
+Texture* NodeEvaluator::getFreeViewSlot()
 {
-    this->outputTexture = texture;
+    for (const auto& slot : this->textureViews)
+    {
+        if (slot->numReferences == 0 && !slot->isView())
+        {
+            return slot.get();
+        }
+    }
+
+    return this->textureViews.emplace_back(std::make_unique<Texture>()).get();
 }
 
-bool NodeEvaluator::hasOutputTexture() const
+Texture* NodeEvaluator::requestView(const Texture& view)
 {
-    return this->outputTexture != nullptr;
+    if (!view.hasContiguousRows())
+    {
+        throw std::runtime_error("crop views can't be propagated, nodes may read them by linear index");
+    }
+
+    Texture* viewPtr = getFreeViewSlot();
+    *viewPtr = view;
+    viewPtr->numReferences = 1;
+    ++view.getViewParent()->numReferences;
+    requestedTextures.push_back(viewPtr);
+
+    return viewPtr;
 }
 
-// this might be unnecessarily complicated but strikes a good balance between memory usage and performance
-// - caching everything would lead to significantly higher memory usage
-// - not caching means bad performance on editing nodes later on in a chain
-bool NodeEvaluator::setChangedNode(Node* changedNode)
+Texture* NodeEvaluator::requestProcedural(const Texture& procTex)
 {
-    bool outputNodeReachable = false;
+    // nothing to keep alive, so the slot is free again as soon as the last reference is dropped
+    Texture* procPtr = getFreeViewSlot();
+    *procPtr = procTex;
+    procPtr->numReferences = 1;
+    requestedTextures.push_back(procPtr);
 
-    // delete cache of any pins reachable from changed node
-    std::queue<Node*> frontier;
-    std::unordered_set<Node*> visited;
-    frontier.push(changedNode);
-    visited.insert(changedNode);
-    while (!frontier.empty())
-    {
-        Node* thisNode = frontier.front();
-        frontier.pop();
+    return procPtr;
+}
 
-        for (auto& thisOutputPin : thisNode->outputPins)
-        {
-            thisOutputPin.deleteCache();
+Texture* NodeEvaluator::materializeProcedural(const Texture& procTex, const ImageRegion& region)
+{
+    Texture* outTex = procTex.getProceduralTextureType() == TextureType::SINGLE
+        ? requestTexture<TextureType::SINGLE>(procTex.resolution)
+        : requestTexture<TextureType::MULTI>(procTex.resolution);
 
-            for (const auto& edge : thisOutputPin.getEdges())
-            {
-                Node* otherNode = edge->endPin->getNode();
+    const ImageRegion clippedRegion = region.intersect(ImageRegion::fromResolution(procTex.resolution));
+    if (!clippedRegion.isEmpty())
+    {
+        Procedural::materialize(procTex, *outTex, clippedRegion);
+    }
 
-                if (!visited.contains(otherNode))
-                {
-                    visited.insert(otherNode);
-                    frontier.push(otherNode);
-                }
+    return outTex;
+}
 
-                if (otherNode == this->outputNode)
-                {
-                    outputNodeReachable = true;
-                }
-            }
+void NodeEvaluator::sweepTextureViews()
+{
+    for (const auto& slot : this->textureViews)
+    {
+        if (slot->numReferences == 0 && slot->isView())
+        {
+            --slot->getViewParent()->numReferences;
+            *slot = Texture(); // marks the slot as free
         }
     }
+}
 
-    return outputNodeReachable;
+void NodeEvaluator::claimTexture(Texture* tex)
+{
+    ++tex->numReferences;
+    requestedTextures.push_back(tex);
 }
 
-void NodeEvaluator::evaluate()
+void NodeEvaluator::releaseUnusedTextures()
 {
-    std::stack<Node*> nodesWithIndegreeZero; // using a stack to allow for a more depth-first topological sort?
-                                             // might mean better memory usage during evaluation, idk
-    std::unordered_map<Node*, int> indegrees;
+    applyChangedNodes(); // changed nodes may still be holding on to caches
+    freeUnusedTextures(false);
+    trimTexturePool();
+}
 
-    std::queue<Node*> frontier;
-    std::unordered_set<Node*> visited;
-    frontier.push(this->outputNode);
-    visited.insert(this->outputNode);
-    while (!frontier.empty())
+void NodeEvaluator::freeUnusedTextures(bool onlyIdleBuckets)
+{
+    sweepTextureViews();
+
+    for (auto& [res, resTextures] : this->textures)
     {
-        Node* thisNode = frontier.front();
-        frontier.pop();
+        if (onlyIdleBuckets && this->bucketLastUsedEvaluations[res] + numIdleBucketEvaluations > this->evaluationIdx)
+        {
+            continue;
+        }
 
-        int indegree = 0;
-        for (const auto& thisInputPin : thisNode->inputPins)
+        std::erase_if(resTextures, [this](const std::unique_ptr<Texture>& tex)
         {
-            for (const auto& edge : thisInputPin.getEdges()) // should be at most 1 edge
+            if (tex->numReferences > 0)
             {
-                Pin* otherOutputPin = edge->startPin;
+                return false;
+            }
+
+            this->numAllocatedBytes -= tex->getNumBytes();
+            tex->free();
+            return true;
+        });
+    }
+}
+
+Texture* NodeEvaluator::makeRoom(glm::ivec2 resolution, TextureType texType, TextureLayout layout, size_t numBytes)
+{
+    const size_t budget = this->memoryBudget;
+    if (this->numAllocatedBytes + numBytes <= budget)
+    {
+        return nullptr;
+    }
+
+    freeUnusedTextures(false);
 
-                if (otherOutputPin->getCacheState() == PinCacheState::CACHED)
+    while (this->numAllocatedBytes + numBytes > budget)
+    {
+        // stashed results are only needed if an edit is undone, so they go before any live cache
+        Texture* evictedTex = evictStashedResult();
+        if (evictedTex == nullptr)
+        {
+            // uniform and procedural caches are skipped since they don't hold any device memory
+            Pin* lruPin = nullptr;
+            int lruLevel = 0;
+            uint64_t lruEvaluationIdx = this->evaluationIdx;
+            for (Pin* pin : this->cachedPins)
+            {
+                for (int level = 0; level < NUM_RESOLUTION_LEVELS; ++level)
                 {
-                    continue;
+                    Texture* cachedTex = pin->getCachedTexture(level);
+                    if (cachedTex != nullptr && !cachedTex->isUniform() && !cachedTex->isProcedural() && pin->getCacheLastUsedEvaluation(level) < lruEvaluationIdx)
+                    {
+                        lruPin = pin;
+                        lruLevel = level;
+                        lruEvaluationIdx = pin->getCacheLastUsedEvaluation(level);
+                    }
                 }
+            }
 
-                ++indegree;
-
-                Node* otherNode = otherOutputPin->getNode();
-                if (!visited.contains(otherNode))
+            if (lruPin == nullptr)
+            {
+                if (!this->hasWarnedOverBudget)
                 {
-                    visited.insert(otherNode);
-                    frontier.push(otherNode);
+                    printf("WARNING: texture memory budget exceeded by caches the current evaluation needs\n");
+                    this->hasWarnedOverBudget = true;
                 }
+                return nullptr;
             }
+
+            evictedTex = lruPin->getCachedTexture(lruLevel);
+            lruPin->evictCache(lruLevel); // the node is evaluated again the next time this cache is needed
+        }
+
+        if (evictedTex->numReferences > 0)
+        {
+            continue;
+        }
+
+        if (evictedTex->isView()) // its parent is released and freed here if nothing else holds it
+        {
+            freeUnusedTextures(false);
+            continue;
         }
 
-        indegrees[thisNode] = indegree;
-        if (indegree == 0)
+        const bool isMatchingType = texType == TextureType::SINGLE ? evictedTex->isType<TextureType::SINGLE>() : evictedTex->isType<TextureType::MULTI>();
+        if (evictedTex->resolution == resolution && isMatchingType && evictedTex->getLayout() == layout)
         {
-            nodesWithIndegreeZero.push(thisNode);
+            return evictedTex;
         }
+
+        freeUnusedTextures(false);
     }
 
-    // TODO: check for cycles in the above search (probably need to convert to DFS)
+    return nullptr;
+}
+
+Texture* NodeEvaluator::evictStashedResult()
+{
+    if (this->stashedResults.empty())
+    {
+        return nullptr;
+    }
 
-    std::vector<Node*> topoSortedNodes;
-    while (!nodesWithIndegreeZero.empty())
+    auto oldestIt = std::min_element(this->stashedResults.begin(), this->stashedResults.end(), [](const StashedResult& a, const StashedResult& b)
     {
-        Node* node = nodesWithIndegreeZero.top();
-        nodesWithIndegreeZero.pop();
+        return a.stashedEvaluation < b.stashedEvaluation;
+    });
 
-        topoSortedNodes.push_back(node);
+    Texture* texture = oldestIt->texture;
+    --texture->numReferences;
+    this->stashedResults.erase(oldestIt);
+    return texture;
+}
 
-        for (const auto& outputPin : node->outputPins)
+// runs after each evaluation
+void NodeEvaluator::trimTexturePool()
+{
+    // buffers for resolutions that stopped being used (e.g. a previous input image) are freed after a while
+    // and everything unused goes if the pool is over budget
+    freeUnusedTextures(this->numAllocatedBytes <= this->memoryBudget);
+
+    std::erase_if(this->textures, [this](const auto& entry)
+    {
+        if (!entry.second.empty())
         {
-            for (const auto& edge : outputPin.getEdges())
-            {
-                Node* otherNode = edge->endPin->getNode();
-                if (--indegrees[otherNode] == 0)
-                {
-                    nodesWithIndegreeZero.push(otherNode);
-                }
-            }
+            return false;
         }
-    }
 
-    for (const auto& node : topoSortedNodes)
+        this->bucketLastUsedEvaluations.erase(entry.first);
+        return true;
+    });
+
+    std::vector<TextureBucketUsage> usage;
+    for (const auto& [res, resTextures] : this->textures)
     {
-        node->setIsBeingEvaluated(true); // set to false in Gui::render()
+        TextureBucketUsage& bucketUsage = usage.emplace_back(TextureBucketUsage{ res, (int)resTextures.size(), 0, 0 });
+        for (const auto& tex : resTextures)
+        {
+            bucketUsage.numTexturesInUse += tex->numReferences > 0 ? 1 : 0;
+            bucketUsage.numBytes += tex->getNumBytes();
+        }
     }
 
-#ifndef NDEBUG
-    printf("evaluating %d nodes\n", (int)topoSortedNodes.size());
-#endif
+    std::sort(usage.begin(), usage.end(), [](const TextureBucketUsage& a, const TextureBucketUsage& b) { return a.numBytes > b.numBytes; });
+
+    std::lock_guard<std::mutex> lock(this->usageMutex);
+    this->textureUsage = std::move(usage);
+}
+
+size_t NodeEvaluator::getMemoryBudget() const
+{
+    return this->memoryBudget;
+}
+
+void NodeEvaluator::setMemoryBudget(size_t memoryBudget)
+{
+    this->memoryBudget = memoryBudget;
+}
+
+std::vector<TextureBucketUsage> NodeEvaluator::getTextureUsage()
+{
+    std::lock_guard<std::mutex> lock(this->usageMutex);
+    return this->textureUsage;
+}
 
-    for (const auto& node : topoSortedNodes)
+void NodeEvaluator::registerCachedPin(Pin* pin)
+{
+    this->cachedPins.insert(pin);
+}
+
+void NodeEvaluator::unregisterCachedPin(Pin* pin)
+{
+    this->cachedPins.erase(pin);
+}
+
+void NodeEvaluator::stashResult(const Pin* pin, int level, uint64_t resultHash, Texture* texture, const ImageRegion& region)
+{
+    // a smaller region of the same result may have been stashed before
+    std::erase_if(this->stashedResults, [&](const StashedResult& stashedResult)
     {
-        if (node->getIsExpensive())
+        if (stashedResult.pin != pin || stashedResult.level != level || stashedResult.resultHash != resultHash)
         {
-            for (auto& outputPin : node->outputPins)
-            {
-                outputPin.prepareForCache(); // does nothing if cache already exists
-            }
+            return false;
         }
 
-        node->evaluate(); // will cache textures in pins if necessary when calling propagateTexture()
-        node->clearInputTextures();
+        --stashedResult.texture->numReferences;
+        return true;
+    });
 
-        for (auto& tex : requestedTextures)
+    if (this->stashedResults.size() >= maxNumStashedResults)
+    {
+        evictStashedResult();
+    }
+
+    this->stashedResults.push_back({ pin, level, resultHash, texture, region, this->evaluationIdx });
+}
+
+void NodeEvaluator::discardStashedResults(const Node* node)
+{
+    std::erase_if(this->stashedResults, [node](const StashedResult& stashedResult)
+    {
+        if (stashedResult.pin->getNode() != node)
         {
-            --tex->numReferences;
+            return false;
         }
-        requestedTextures.clear();
-    }
 
-    cudaDeviceSynchronize();
+        --stashedResult.texture->numReferences;
+        return true;
+    });
+}
+
+bool NodeEvaluator::restoreStashedResult(Pin* pin, const ImageRegion& region)
+{
+    const uint64_t resultHash = pin->getResultHash();
+    if (resultHash == 0)
+    {
+        return false;
+    }
 
-    if (outputTexture == nullptr)
+    for (auto it = this->stashedResults.begin(); it != this->stashedResults.end(); ++it)
     {
-        return;
+        if (it->pin == pin && it->level == this->proxyLevel && it->resultHash == resultHash && it->region.contains(region))
+        {
+            pin->restoreCache(it->texture, it->region, resultHash);
+            this->stashedResults.erase(it);
+            return true;
+        }
     }
 
-    float* host_pixels;
-    int sizeBytes = outputResolution.x * outputResolution.y * sizeof(glm::vec4);
-    CUDA_CHECK(cudaMallocHost(&host_pixels, sizeBytes));
-    CUDA_CHECK(cudaMemcpy(host_pixels, outputTexture->getDevPixels<TextureType::MULTI>(), sizeBytes, cudaMemcpyDeviceToHost));
+    return false;
+}
+
+uint64_t NodeEvaluator::getEvaluationIdx() const
+{
+    return this->evaluationIdx;
+}
 
-    // TODO: CUDA/OpenGL interop (may need to request a special texture from NodeEvaluator)
-    // TODO: replace with glTexSubImage2D?
-    glActiveTexture(GL_TEXTURE0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, outputResolution.x, outputResolution.y, false, GL_RGBA, GL_FLOAT, host_pixels);
+glm::ivec2 NodeEvaluator::getOutputResolution() const
+{
+    return this->outputResolution;
+}
 
-    CUDA_CHECK(cudaFreeHost(host_pixels));
+void NodeEvaluator::setOutputResolution(glm::ivec2 outputResolution)
+{
+    this->outputResolution = glm::max(outputResolution, glm::ivec2(1));
+}
 
-#ifndef NDEBUG
-    int numTextures = 0;
-    int numUniformTextures = 0;
-    for (const auto& [res, textures] : this->textures)
+int NodeEvaluator::getProxyLevel() const
+{
+    return this->proxyLevel;
+}
+
+void NodeEvaluator::setProxyLevel(int proxyLevel)
+{
+    this->proxyLevel = glm::clamp(proxyLevel, 0, NUM_RESOLUTION_LEVELS - 1);
+}
+
+float NodeEvaluator::getResolutionScale() const
+{
+    return 1.f / (1 << this->proxyLevel);
+}
+
+glm::ivec2 NodeEvaluator::getScaledResolution(glm::ivec2 fullResolution) const
+{
+    // rounded up so every full resolution pixel maps to some proxy pixel
+    const int factor = 1 << this->proxyLevel;
+    return glm::max((fullResolution + factor - 1) / factor, glm::ivec2(1));
+}
+
+Texture* NodeEvaluator::getOutputTexture() const
+{
+    return this->outputTexture;
+}
+
+void NodeEvaluator::setOutputTexture(Texture* texture)
+{
+    if (this->evaluatingOutputTexture != nullptr)
     {
-        (res.x == 0 ? numUniformTextures : numTextures) += textures.size();
+        --this->evaluatingOutputTexture->numReferences;
     }
-    printf("num textures: %d\n", numTextures);
-    printf("num uniform textures: %d\n", numUniformTextures);
+
+    this->evaluatingOutputTexture = texture;
+
+    if (texture != nullptr)
+    {
+        ++texture->numReferences;
+    }
+}
+
+bool NodeEvaluator::hasOutputTexture()
+{
+    std::lock_guard<std::mutex> lock(this->viewerMutex);
+    return this->outputTexture != nullptr;
+}
+
+// this might be unnecessarily complicated but strikes a good balance between memory usage and performance
+// - caching everything would lead to significantly higher memory usage
+// - not caching means bad performance on editing nodes later on in a chain
+bool NodeEvaluator::setChangedNode(Node* changedNode)
+{
+    const int compiledIdx = changedNode->getCompiledIdx();
+    if (compiledIdx != -1)
+    {
+        // everything in the compiled graph is upstream of the output
+        this->compiledGraph.addDescendants(compiledIdx, this->pendingDirtyMask);
+        return true;
+    }
+
+    // not compiled yet, or not connected to the output
+    this->pendingChangedNodes.insert(changedNode);
+
+    bool outputNodeReachable = false;
+
+    std::queue<Node*> frontier;
+    std::unordered_set<Node*> visited;
+    frontier.push(changedNode);
+    visited.insert(changedNode);
+    while (!frontier.empty())
+    {
+        Node* thisNode = frontier.front();
+        frontier.pop();
+
+        for (const auto& thisOutputPin : thisNode->outputPins)
+        {
+            for (const auto& edge : thisOutputPin.getEdges())
+            {
+                Node* otherNode = edge->endPin->getNode();
+
+                if (!visited.contains(otherNode))
+                {
+                    visited.insert(otherNode);
+                    frontier.push(otherNode);
+                }
+
+                if (otherNode == this->outputNode)
+                {
+                    outputNodeReachable = true;
+                }
+            }
+        }
+    }
+
+    return outputNodeReachable;
+}
+
+void NodeEvaluator::applyChangedNodes()
+{
+    for (int word = 0; word < this->pendingDirtyMask.size(); ++word)
+    {
+        uint64_t bits = this->pendingDirtyMask[word];
+        while (bits != 0)
+        {
+            const int nodeIdx = word * 64 + std::countr_zero(bits);
+            bits &= bits - 1;
+
+            for (auto& outputPin : this->compiledGraph.getNode(nodeIdx)->outputPins)
+            {
+                outputPin.stashCache();
+            }
+        }
+    }
+    this->pendingDirtyMask.clear();
+
+    // delete cache of any pins reachable from changed nodes
+    std::queue<Node*> frontier;
+    std::unordered_set<Node*> visited;
+    for (Node* changedNode : this->pendingChangedNodes)
+    {
+        frontier.push(changedNode);
+        visited.insert(changedNode);
+    }
+    this->pendingChangedNodes.clear();
+
+    while (!frontier.empty())
+    {
+        Node* thisNode = frontier.front();
+        frontier.pop();
+
+        for (auto& thisOutputPin : thisNode->outputPins)
+        {
+            thisOutputPin.stashCache();
+
+            for (const auto& edge : thisOutputPin.getEdges())
+            {
+                Node* otherNode = edge->endPin->getNode();
+
+                if (!visited.contains(otherNode))
+                {
+                    visited.insert(otherNode);
+                    frontier.push(otherNode);
+                }
+            }
+        }
+    }
+}
+
+void NodeEvaluator::invalidateGraph()
+{
+    applyChangedNodes(); // dirty bits refer to the old indices
+    this->compiledGraph.invalidate();
+}
+
+// a node's result hash covers its parameters and the result hashes of its inputs, so equal hashes mean equal results
+void NodeEvaluator::hashResults()
+{
+    const uint64_t seed = Hasher().add(this->outputResolution).get(); // generators like the uv gradient depend on it
+
+    for (int nodeIdx = 0; nodeIdx < this->compiledGraph.getNumNodes(); ++nodeIdx)
+    {
+        Node* node = this->compiledGraph.getNode(nodeIdx);
+
+        Hasher hasher;
+        hasher.add(seed).add(node->id);
+        bool isReusable = node->hashParameters(hasher);
+
+        // inputs come earlier in the plan, so their hashes are already up to date
+        for (const CompiledGraph::Input* input = this->compiledGraph.getInputsBegin(nodeIdx); input != this->compiledGraph.getInputsEnd(nodeIdx); ++input)
+        {
+            const uint64_t inputHash = input->outputPin->getResultHash();
+            isReusable = isReusable && inputHash != 0;
+            hasher.add(input->inputPinIdx).add(inputHash);
+        }
+
+        node->setResultHash(isReusable ? std::max(hasher.get(), (uint64_t)1) : 0);
+    }
+}
+
+// decides which nodes cache their outputs in this evaluation
+// a node's recompute cost is its own measured time plus that of everything uncached upstream of it, so long chains of cheap
+// nodes still get a cache every so often, while quick nodes with big outputs don't take memory from slow ones
+void NodeEvaluator::chooseCachedNodes()
+{
+    struct Candidate
+    {
+        Node* node;
+        float recomputeMs;
+        size_t numBytes;
+    };
+
+    const int numNodes = this->compiledGraph.getNumNodes();
+    this->nodeRecomputeMs.assign(numNodes, 0.f);
+
+    std::vector<Candidate> candidates;
+    size_t totalBytes = 0;
+    for (int nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+    {
+        Node* node = this->compiledGraph.getNode(nodeIdx);
+        const float evaluationMs = node->getEvaluationMs(this->proxyLevel);
+
+        float recomputeMs = evaluationMs;
+        for (const CompiledGraph::Input* input = this->compiledGraph.getInputsBegin(nodeIdx); input != this->compiledGraph.getInputsEnd(nodeIdx); ++input)
+        {
+            if (!this->compiledGraph.getNode(input->nodeIdx)->getIsCachingOutputs())
+            {
+                recomputeMs += this->nodeRecomputeMs[input->nodeIdx];
+            }
+        }
+        this->nodeRecomputeMs[nodeIdx] = recomputeMs;
+
+        // nodes that haven't been timed at this level yet fall back to their expensive flag
+        bool isCachingOutputs = evaluationMs > 0.f ? recomputeMs >= minCachedRecomputeMs : node->getIsExpensive();
+        isCachingOutputs = isCachingOutputs && !node->outputPins.empty();
+        node->setIsCachingOutputs(isCachingOutputs);
+
+        if (!isCachingOutputs)
+        {
+            continue;
+        }
+
+        size_t numBytes = 0;
+        for (const auto& outputPin : node->outputPins)
+        {
+            glm::ivec2 resolution;
+            TextureType textureType;
+            if (outputPin.getLastTextureFormat(resolution, textureType))
+            {
+                numBytes += textureType == TextureType::SINGLE ? Texture::getNumBytes<TextureType::SINGLE>(resolution) : Texture::getNumBytes<TextureType::MULTI>(resolution);
+            }
+        }
+
+        candidates.push_back({ node, recomputeMs, numBytes });
+        totalBytes += numBytes;
+    }
+
+    // over budget, keep the caches that save the most time per byte
+    const size_t cacheBudget = (size_t)(this->memoryBudget * cacheBudgetFraction);
+    if (totalBytes > cacheBudget)
+    {
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b)
+        {
+            return a.recomputeMs / std::max(a.numBytes, (size_t)1) > b.recomputeMs / std::max(b.numBytes, (size_t)1);
+        });
+
+        size_t numCachedBytes = 0;
+        for (const Candidate& candidate : candidates)
+        {
+            if (numCachedBytes + candidate.numBytes <= cacheBudget)
+            {
+                numCachedBytes += candidate.numBytes;
+            }
+            else
+            {
+                candidate.node->setIsCachingOutputs(false);
+            }
+        }
+    }
+}
+
+// an evaluated node can make other inputs of its consumers unneeded, e.g. a mix factor that turns out to be uniformly 0
+// anything that was only scheduled for those inputs is pruned before it runs, along with whatever only it needed
+void NodeEvaluator::pruneUnneededInputs(Node* evaluatedNode)
+{
+    std::vector<const CompiledGraph::Input*> releasedInputs;
+
+    for (const auto& outputPin : evaluatedNode->outputPins)
+    {
+        for (const auto& edge : outputPin.getEdges())
+        {
+            Node* consumer = edge->endPin->getNode();
+            const int consumerIdx = consumer->getCompiledIdx();
+            if (consumerIdx == -1 || !this->nodesToEvaluate[consumerIdx] || this->nodesDone[consumerIdx])
+            {
+                continue;
+            }
+
+            for (const CompiledGraph::Input* input = this->compiledGraph.getInputsBegin(consumerIdx); input != this->compiledGraph.getInputsEnd(consumerIdx); ++input)
+            {
+                uint8_t& isDemanded = this->inputDemands[this->compiledGraph.getInputIdx(input)];
+                if (isDemanded && !consumer->isInputNeeded(input->inputPinIdx))
+                {
+                    isDemanded = 0;
+                    releasedInputs.push_back(input);
+                }
+            }
+        }
+    }
+
+    while (!releasedInputs.empty())
+    {
+        const int producerIdx = releasedInputs.back()->nodeIdx;
+        releasedInputs.pop_back();
+
+        if (--this->nodeDemands[producerIdx] > 0 || !this->nodesToEvaluate[producerIdx] || this->nodesDone[producerIdx])
+        {
+            continue;
+        }
+
+        Node* producer = this->compiledGraph.getNode(producerIdx);
+        producer->setIsBeingEvaluated(false); // upstream nodes that still run won't hand it textures
+        producer->clearInputTextures();
+        this->nodesDone[producerIdx] = 1;
+        ++this->numPrunedNodes;
+
+        for (const CompiledGraph::Input* input = this->compiledGraph.getInputsBegin(producerIdx); input != this->compiledGraph.getInputsEnd(producerIdx); ++input)
+        {
+            uint8_t& isDemanded = this->inputDemands[this->compiledGraph.getInputIdx(input)];
+            if (isDemanded)
+            {
+                isDemanded = 0;
+                releasedInputs.push_back(input);
+            }
+        }
+    }
+}
+
+void NodeEvaluator::recordNodeTimings(const std::vector<Node*>& schedule)
+{
+    if (this->timedScheduleIdxs.empty())
+    {
+        return;
+    }
+
+    CUDA_CHECK(cudaEventSynchronize(this->timingEvents[this->timedScheduleIdxs.back() * 2 + 1]));
+
+    for (int scheduleIdx : this->timedScheduleIdxs)
+    {
+        float ms;
+        CUDA_CHECK(cudaEventElapsedTime(&ms, this->timingEvents[scheduleIdx * 2], this->timingEvents[scheduleIdx * 2 + 1]));
+        schedule[scheduleIdx]->recordEvaluationMs(this->proxyLevel, ms);
+    }
+}
+
+void NodeEvaluator::evaluate(const ImageRegion& outputRegion)
+{
+    ++this->evaluationIdx;
+    this->hasWarnedOverBudget = false;
+
+    if (!this->compiledGraph.getIsValid())
+    {
+        this->compiledGraph.compile(this->outputNode); // only for synchronous evaluation, submit() compiles ahead of time
+    }
+
+    hashResults();
+    chooseCachedNodes();
+
+    // walk back from the output, mapping each node's region to the regions it needs from its inputs
+    // a node only needs to be evaluated if one of the regions requested from it isn't covered by a cache
+    // caches can't cut this walk short because whether a cache is usable depends on the region requested from it
+    const int numNodes = this->compiledGraph.getNumNodes();
+    this->nodeRegions.assign(numNodes, ImageRegion{});
+    this->nodesToEvaluate.assign(numNodes, 0);
+    this->nodesDone.assign(numNodes, 0);
+    this->nodeDemands.assign(numNodes, 0);
+    this->inputDemands.assign(this->compiledGraph.getNumInputs(), 0);
+    this->numPrunedNodes = 0;
+
+    // channel demands are built up again from the output along with the regions
+    for (int nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+    {
+        for (auto& outputPin : this->compiledGraph.getNode(nodeIdx)->outputPins)
+        {
+            outputPin.setChannelDemand(0);
+        }
+    }
+
+    const int outputNodeIdx = this->outputNode->getCompiledIdx(); // -1 if the output is part of a cycle
+    if (outputNodeIdx != -1)
+    {
+        this->nodeRegions[outputNodeIdx] = scaleRegion(outputRegion, this->proxyLevel);
+        this->nodesToEvaluate[outputNodeIdx] = 1;
+        this->nodeDemands[outputNodeIdx] = 1;
+    }
+
+    for (int nodeIdx = numNodes - 1; nodeIdx >= 0; --nodeIdx)
+    {
+        if (!this->nodesToEvaluate[nodeIdx])
+        {
+            continue;
+        }
+
+        Node* node = this->compiledGraph.getNode(nodeIdx);
+        const ImageRegion region = node->getNeedsFullImage() ? ImageRegion::unbounded() : this->nodeRegions[nodeIdx];
+        node->setOutputRegion(region);
+
+        for (const CompiledGraph::Input* input = this->compiledGraph.getInputsBegin(nodeIdx); input != this->compiledGraph.getInputsEnd(nodeIdx); ++input)
+        {
+            // e.g. a mix node with an unconnected factor of 0 never reads its second image
+            if (!node->isInputNeeded(input->inputPinIdx))
+            {
+                continue;
+            }
+
+            this->inputDemands[this->compiledGraph.getInputIdx(input)] = 1;
+            ++this->nodeDemands[input->nodeIdx];
+
+            Pin* otherOutputPin = input->outputPin;
+
+            // every consumer comes later in the compiled graph, so a node's output demands are complete once it's reached
+            otherOutputPin->addChannelDemand(node->getInputChannelDemand(input->inputPinIdx));
+
+            // requests are merged even when they're cached so a reevaluated node still covers all of its cached pins
+            const ImageRegion inputRegion = node->getInputRegion(input->inputPinIdx, region);
+            this->nodeRegions[input->nodeIdx] = this->nodeRegions[input->nodeIdx].unite(inputRegion);
+
+            if (otherOutputPin->getCacheState() != PinCacheState::CACHED)
+            {
+                restoreStashedResult(otherOutputPin, inputRegion);
+            }
+
+            if (otherOutputPin->getCacheState() == PinCacheState::CACHED)
+            {
+                otherOutputPin->touchCache(); // protects it from eviction during this evaluation
+            }
+
+            if (otherOutputPin->getCacheState() != PinCacheState::CACHED || !otherOutputPin->getCachedRegion().contains(inputRegion))
+            {
+                this->nodesToEvaluate[input->nodeIdx] = 1;
+            }
+        }
+    }
+
+    std::vector<Node*> schedule;
+    for (int nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+    {
+        if (this->nodesToEvaluate[nodeIdx])
+        {
+            schedule.push_back(this->compiledGraph.getNode(nodeIdx));
+        }
+    }
+
+    for (const auto& node : schedule)
+    {
+        node->setIsBeingEvaluated(true);
+    }
+
+#ifndef NDEBUG
+    printf("evaluating %d nodes\n", (int)schedule.size());
+#endif
+
+    planBuffers(schedule);
+
+    while (this->timingEvents.size() < schedule.size() * 2)
+    {
+        cudaEvent_t event;
+        CUDA_CHECK(cudaEventCreate(&event));
+        this->timingEvents.push_back(event);
+    }
+    this->timedScheduleIdxs.clear();
+
+    bool wasCancelled = false;
+    for (int nodeIdx = 0; nodeIdx < schedule.size(); ++nodeIdx)
+    {
+        Node* node = schedule[nodeIdx];
+
+        // a newer state is waiting, so there's no point finishing this one
+        // nodes that were skipped still need their input edges cleared to release upstream textures
+        if (wasCancelled || isCancelRequested())
+        {
+            wasCancelled = true;
+            node->clearInputTextures();
+            continue;
+        }
+
+        if (this->nodesDone[node->getCompiledIdx()]) // pruned, its input textures were already released
+        {
+            continue;
+        }
+
+        for (auto& outputPin : node->outputPins)
+        {
+            if (node->getIsCachingOutputs())
+            {
+                outputPin.prepareForCache();
+            }
+            else if (outputPin.getCachedTexture() != nullptr)
+            {
+                outputPin.evictCache(this->proxyLevel); // the cost model dropped this node since its cache was made
+            }
+        }
+
+        // the events also cover any host work in between, e.g. decoding a file while the GPU waits for it
+        CUDA_CHECK(cudaEventRecord(this->timingEvents[nodeIdx * 2]));
+        this->currentPlannedTextures = &this->plannedNodeTextures[nodeIdx];
+        node->evaluate(); // will cache textures in pins if necessary when calling propagateTexture()
+        node->clearInputTextures();
+        CUDA_CHECK(cudaEventRecord(this->timingEvents[nodeIdx * 2 + 1]));
+
+        if (!isCancelRequested()) // long running nodes can stop partway through
+        {
+            this->timedScheduleIdxs.push_back(nodeIdx);
+        }
+
+        this->nodesDone[node->getCompiledIdx()] = 1;
+        pruneUnneededInputs(node);
+
+        for (auto& tex : requestedTextures)
+        {
+            --tex->numReferences;
+        }
+        requestedTextures.clear();
+        sweepTextureViews(); // so buffers only held by finished views can be planned into again
+    }
+
+    this->currentPlannedTextures = nullptr;
+    releasePlannedBuffers();
+    recordNodeTimings(schedule);
+
+    for (const auto& node : schedule)
+    {
+        node->setIsBeingEvaluated(false);
+    }
+
+    if (wasCancelled)
+    {
+        setOutputTexture(nullptr); // a partially evaluated frame is never shown
+    }
+    else
+    {
+        publishOutputTexture(outputRegion);
+    }
+
+    trimTexturePool();
+
+#ifndef NDEBUG
+    printf("skipped %d unneeded nodes\n", this->numPrunedNodes);
+
+    int numTextures = 0;
+    int numUniformTextures = 0;
+    for (const auto& [res, textures] : this->textures)
+    {
+        (res.x == 0 ? numUniformTextures : numTextures) += textures.size();
+    }
+    printf("num textures: %d\n", numTextures);
+    printf("num uniform textures: %d\n", numUniformTextures);
+    printf("texture memory: %.1f MB\n", this->numAllocatedBytes / (1024.f * 1024.f));
     printf("\n");
 #endif
 }
+
+// outputs that are only needed within this evaluation get a buffer by interval colouring their lifetimes in the schedule,
+// so outputs whose lifetimes don't overlap share a buffer and peak memory doesn't depend on the order of the pool
+// buffers are acquired up front and handed to their nodes in requestTexture() without searching the pool
+// cached outputs outlive the evaluation and are left to the pool, as is anything that hasn't been evaluated before
+void NodeEvaluator::planBuffers(const std::vector<Node*>& schedule)
+{
+    struct PlannedBuffer
+    {
+        glm::ivec2 resolution;
+        TextureType textureType;
+        int lastUseIdx;
+    };
+
+    // compiled index -> schedule index, -1 if not scheduled
+    this->scheduleIdxs.assign(this->compiledGraph.getNumNodes(), -1);
+    for (int nodeIdx = 0; nodeIdx < schedule.size(); ++nodeIdx)
+    {
+        this->scheduleIdxs[schedule[nodeIdx]->getCompiledIdx()] = nodeIdx;
+    }
+
+    std::vector<PlannedBuffer> buffers;
+    std::vector<std::vector<int>> nodeBufferIdxs(schedule.size());
+    std::unordered_map<const Pin*, int> pinBufferIdxs;
+    std::unordered_set<const Pin*> singleConsumerPins;
+    int numPlannedOutputs = 0;
+
+    for (int nodeIdx = 0; nodeIdx < schedule.size(); ++nodeIdx)
+    {
+        const Node* node = schedule[nodeIdx];
+        if (node->getIsCachingOutputs())
+        {
+            continue;
+        }
+
+        for (const auto& outputPin : node->outputPins)
+        {
+            glm::ivec2 resolution;
+            TextureType textureType;
+            if (!outputPin.getLastTextureFormat(resolution, textureType))
+            {
+                continue;
+            }
+
+            int lastUseIdx = -1;
+            int numConsumers = 0;
+            for (const auto& edge : outputPin.getEdges())
+            {
+                const int consumerCompiledIdx = edge->endPin->getNode()->getCompiledIdx();
+                const int consumerIdx = consumerCompiledIdx == -1 ? -1 : this->scheduleIdxs[consumerCompiledIdx];
+                if (consumerIdx != -1)
+                {
+                    lastUseIdx = std::max(lastUseIdx, consumerIdx);
+                    ++numConsumers;
+                }
+            }
+
+            if (lastUseIdx < 0)
+            {
+                continue;
+            }
+
+            int bufferIdx = -1;
+
+            // an in-place node takes over its input's buffer when it's the only consumer, see Node::requestOutputTexture()
+            const Pin& inPlaceInputPin = node->inputPins[0];
+            if (node->getIsInPlace() && inPlaceInputPin.hasEdge())
+            {
+                const Pin* inPlaceSourcePin = (*inPlaceInputPin.getEdges().begin())->startPin;
+                auto it = pinBufferIdxs.find(inPlaceSourcePin);
+                if (it != pinBufferIdxs.end() && singleConsumerPins.contains(inPlaceSourcePin))
+                {
+                    const PlannedBuffer& inputBuffer = buffers[it->second];
+                    if (inputBuffer.lastUseIdx == nodeIdx && inputBuffer.resolution == resolution && inputBuffer.textureType == textureType)
+                    {
+                        bufferIdx = it->second;
+                    }
+                }
+            }
+
+            // nodes are visited in schedule order, so first fit over buffers that are already dead is an optimal colouring
+            for (int i = 0; bufferIdx == -1 && i < buffers.size(); ++i)
+            {
+                const PlannedBuffer& buffer = buffers[i];
+                if (buffer.lastUseIdx < nodeIdx && buffer.resolution == resolution && buffer.textureType == textureType)
+                {
+                    bufferIdx = i;
+                }
+            }
+
+            if (bufferIdx == -1)
+            {
+                bufferIdx = buffers.size();
+                buffers.push_back({ resolution, textureType, -1 });
+            }
+
+            buffers[bufferIdx].lastUseIdx = lastUseIdx;
+            nodeBufferIdxs[nodeIdx].push_back(bufferIdx);
+            pinBufferIdxs[&outputPin] = bufferIdx;
+            if (numConsumers == 1)
+            {
+                singleConsumerPins.insert(&outputPin);
+            }
+            ++numPlannedOutputs;
+        }
+    }
+
+    // the plan holds one reference to each buffer for the whole evaluation
+    std::vector<Texture*> bufferTextures;
+    size_t peakBytes = 0;
+    for (const auto& buffer : buffers)
+    {
+        Texture* tex = buffer.textureType == TextureType::SINGLE
+            ? requestTexture<TextureType::SINGLE>(buffer.resolution)
+            : requestTexture<TextureType::MULTI>(buffer.resolution);
+        bufferTextures.push_back(tex);
+        peakBytes += tex->getNumBytes();
+    }
+    this->plannedTextureHolds = std::move(this->requestedTextures);
+    this->requestedTextures.clear();
+
+    this->plannedNodeTextures.assign(schedule.size(), {});
+    for (int nodeIdx = 0; nodeIdx < schedule.size(); ++nodeIdx)
+    {
+        for (int bufferIdx : nodeBufferIdxs[nodeIdx])
+        {
+            this->plannedNodeTextures[nodeIdx].push_back(bufferTextures[bufferIdx]);
+        }
+    }
+
+#ifndef NDEBUG
+    printf("planned %d outputs into %d buffers, peak %.1f MB\n", numPlannedOutputs, (int)buffers.size(), peakBytes / (1024.f * 1024.f));
+#endif
+
+    std::lock_guard<std::mutex> lock(this->usageMutex);
+    this->bufferPlanSummary = { numPlannedOutputs, (int)buffers.size(), peakBytes };
+}
+
+void NodeEvaluator::releasePlannedBuffers()
+{
+    for (auto& tex : this->plannedTextureHolds)
+    {
+        --tex->numReferences;
+    }
+    this->plannedTextureHolds.clear();
+    this->plannedNodeTextures.clear();
+}
+
+BufferPlanSummary NodeEvaluator::getBufferPlanSummary()
+{
+    std::lock_guard<std::mutex> lock(this->usageMutex);
+    return this->bufferPlanSummary;
+}
+
+void NodeEvaluator::publishOutputTexture(const ImageRegion& outputRegion)
+{
+    std::lock_guard<std::mutex> lock(this->viewerMutex);
+
+    if (this->outputTexture != nullptr)
+    {
+        --this->outputTexture->numReferences;
+    }
+
+    // the reference taken in setOutputTexture() moves to the published texture
+    this->outputTexture = this->evaluatingOutputTexture;
+    this->evaluatingOutputTexture = nullptr;
+
+    this->evaluatedRegion = outputRegion.intersect(ImageRegion::fromResolution(this->outputResolution));
+    this->evaluatedProxyLevel = this->proxyLevel;
+
+    if (this->outputTexture != nullptr)
+    {
+        stageOutputTexture(); // uploaded to the viewer in updateViewerTexture()
+    }
+}
+
+GLuint NodeEvaluator::getViewerTextureId() const
+{
+    return viewerStaging.getTextureId();
+}
+
+glm::vec2 NodeEvaluator::getViewerUvMin() const
+{
+    return viewerStaging.getUvMin();
+}
+
+glm::vec2 NodeEvaluator::getViewerUvMax() const
+{
+    return viewerStaging.getUvMax();
+}
+
+void NodeEvaluator::updateViewerTexture()
+{
+    std::lock_guard<std::mutex> lock(this->viewerMutex);
+    viewerStaging.upload();
+}
+
+bool NodeEvaluator::getIsViewerDownsampled() const
+{
+    return this->isViewerDownsampled;
+}
+
+void NodeEvaluator::setIsViewerDownsampled(bool isViewerDownsampled)
+{
+    if (isViewerDownsampled == this->isViewerDownsampled)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(this->viewerMutex);
+    this->isViewerDownsampled = isViewerDownsampled;
+
+    if (outputTexture != nullptr)
+    {
+        stageOutputTexture();
+    }
+}
+
+bool NodeEvaluator::setViewerRegion(const ImageRegion& viewerRegion, glm::ivec2 viewerSize)
+{
+    if (viewerRegion == this->viewerRegion && viewerSize == this->viewerSize)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(this->viewerMutex);
+    this->viewerRegion = viewerRegion;
+    this->viewerSize = viewerSize;
+
+    if (!this->evaluatedRegion.contains(viewerRegion))
+    {
+        return true;
+    }
+
+    // the output texture stays intact between evaluations so it can be restaged without evaluating again
+    if (outputTexture != nullptr)
+    {
+        stageOutputTexture();
+    }
+
+    return false;
+}
+
+ImageRegion NodeEvaluator::scaleRegion(const ImageRegion& fullRegion, int proxyLevel)
+{
+    // rounded outwards so the scaled region covers at least the same area
+    const int factor = 1 << proxyLevel;
+    return {
+        glm::ivec2(glm::floor(glm::vec2(fullRegion.min) / (float)factor)),
+        glm::ivec2(glm::ceil(glm::vec2(fullRegion.max) / (float)factor))
+    };
+}
+
+const ImageRegion& NodeEvaluator::getViewerRegion() const
+{
+    return this->viewerRegion;
+}
+
+bool NodeEvaluator::isOutputComplete()
+{
+    std::lock_guard<std::mutex> lock(this->viewerMutex);
+    return this->evaluatedProxyLevel == 0 && this->evaluatedRegion.contains(ImageRegion::fromResolution(this->outputResolution));
+}
+
+void NodeEvaluator::stageOutputTexture()
+{
+    // only the part of the output that's on screen is staged, in output texture coordinates
+    const ImageRegion fullRegion = this->viewerRegion.intersect(this->evaluatedRegion);
+    const ImageRegion region = scaleRegion(fullRegion, this->evaluatedProxyLevel).intersect(ImageRegion::fromResolution(outputTexture->resolution));
+    viewerStaging.stage(outputTexture, region, isViewerDownsampled ? viewerSize : glm::ivec2(0));
+}
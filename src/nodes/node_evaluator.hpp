@@ -3,10 +3,17 @@
 #include "node.hpp"
 #include "edge.hpp"
 #include "texture.hpp"
+#include "viewer_staging.hpp"
+#include "image_region.hpp"
+#include "compiled_graph.hpp"
 
 #include <unordered_map>
 #include <unordered_set>
 #include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 #include "cuda_includes.hpp"
 #include <glm/glm.hpp>
@@ -16,59 +23,179 @@ class Node;
 class Pin;
 class Edge;
 
+struct TextureBucketUsage
+{
+    glm::ivec2 resolution;
+    int numTextures;
+    int numTexturesInUse; // referenced by an edge, a pin cache, or the viewer
+    size_t numBytes;
+};
+
+struct BufferPlanSummary
+{
+    int numPlannedOutputs{ 0 };
+    int numBuffers{ 0 };
+    size_t peakBytes{ 0 }; // of the planned buffers, caches and scratch textures come on top of this
+};
+
 class NodeEvaluator
 {
 private:
     Node* outputNode{ nullptr };
 
+    // compiled on the main thread, so it never changes while the worker is evaluating
+    CompiledGraph compiledGraph;
+
+    // per evaluation scratch, indexed by compiled node index
+    std::vector<ImageRegion> nodeRegions;
+    std::vector<uint8_t> nodesToEvaluate;
+    std::vector<uint8_t> nodesDone; // evaluated or pruned
+    std::vector<int> nodeDemands; // number of needed inputs each node feeds, pruned once this drops to 0
+    std::vector<uint8_t> inputDemands; // indexed by CompiledGraph::getInputIdx()
+    int numPrunedNodes{ 0 };
+    std::vector<int> scheduleIdxs;
+    std::vector<float> nodeRecomputeMs;
+
+    // two per scheduled node, timings are read back once the whole schedule has been submitted
+    std::vector<cudaEvent_t> timingEvents;
+    std::vector<int> timedScheduleIdxs;
+
+    static constexpr size_t defaultMemoryBudget = (size_t)4 << 30;
+    static constexpr float cacheBudgetFraction = 0.5f; // the rest of the budget is left for buffers used during evaluation
+    static constexpr float minCachedRecomputeMs = 4.f; // outputs that are quicker than this to recompute aren't cached
+    static constexpr int numIdleBucketEvaluations = 8; // unused buffers in a bucket are freed after this many evaluations without a request
+
+    // the pool is kept within memoryBudget by freeing unused buffers, then evicting the least recently used pin caches
     std::unordered_map<glm::ivec2, std::vector<std::unique_ptr<Texture>>, ResolutionHash> textures;
-    Texture* outputTexture{ nullptr };
+    // see requestView() and requestProcedural(), a view's slot holds a reference to its parent until it's swept
+    std::vector<std::unique_ptr<Texture>> textureViews;
+    std::unordered_map<glm::ivec2, uint64_t, ResolutionHash> bucketLastUsedEvaluations;
+    size_t numAllocatedBytes{ 0 };
+    std::atomic<size_t> memoryBudget{ defaultMemoryBudget };
+
+    uint64_t evaluationIdx{ 0 }; // pins record this when their cache is used, caches used in the current evaluation can't be evicted
+    std::unordered_set<Pin*> cachedPins;
+    bool hasWarnedOverBudget{ false };
+
+    // caches replaced by an edit are stashed by result hash, so undoing the edit or toggling between two parameter values
+    // restores them instead of evaluating again
+    // stashed results are the first thing evicted when memory runs out
+    struct StashedResult
+    {
+        const Pin* pin;
+        int level;
+        uint64_t resultHash;
+        Texture* texture; // holds a reference
+        ImageRegion region;
+        uint64_t stashedEvaluation;
+    };
+    static constexpr int maxNumStashedResults = 32;
+    std::vector<StashedResult> stashedResults;
+
+    std::mutex usageMutex;
+    std::vector<TextureBucketUsage> textureUsage; // updated after each evaluation so the UI doesn't read the pool while it changes
+    BufferPlanSummary bufferPlanSummary;
+
+    // both hold a reference so the worker can't reuse them while the viewer reads them
+    Texture* outputTexture{ nullptr }; // latest completed frame
+    Texture* evaluatingOutputTexture{ nullptr }; // published once the current evaluation finishes without being cancelled
 
     std::vector<Texture*> requestedTextures;
 
-public:
-    GLuint viewerTex;
+    // see planBuffers()
+    std::vector<Texture*> plannedTextureHolds;
+    std::vector<std::vector<Texture*>> plannedNodeTextures; // indexed by position in the schedule
+    const std::vector<Texture*>* currentPlannedTextures{ nullptr };
+
+    // evaluation runs on a worker thread
+    // the main thread only touches the graph and caches while the worker is idle, so edits made during an evaluation
+    // are recorded here and applied before the next one starts
+    std::vector<uint64_t> pendingDirtyMask; // nodes in the compiled graph whose caches are stale
+    std::unordered_set<Node*> pendingChangedNodes; // changed nodes outside of the compiled graph
+
+    std::thread workerThread;
+    std::mutex workerMutex;
+    std::condition_variable workerCondition;
+    bool isWorkerRunning{ false };
+    bool hasPendingJob{ false };
+    bool isEvaluating{ false };
+    ImageRegion pendingOutputRegion{};
+    std::atomic<bool> cancelRequested{ false };
+
+    std::mutex viewerMutex; // guards the published output and viewer staging, which both threads touch
+    ViewerStaging viewerStaging;
+    bool isViewerDownsampled{ true };
+    glm::ivec2 viewerSize{ 0, 0 };
+    ImageRegion viewerRegion{}; // visible part of the output in full resolution pixels
 
-    const glm::ivec2 outputResolution;
+    // what the current output texture holds, in full resolution pixels
+    ImageRegion evaluatedRegion{};
+    int evaluatedProxyLevel{ 0 };
 
+    glm::ivec2 outputResolution;
+    int proxyLevel{ 0 }; // resolution is scaled by 1 / 2^proxyLevel
+
+public:
     NodeEvaluator(glm::ivec2 outputResolution);
     ~NodeEvaluator();
 
     void init();
 
+    void startWorker();
+    void stopWorker();
+
     void setOutputNode(Node* outputNode);
 
-    template<TextureType texType>
+    template<TextureType texType, TextureLayout layout = TextureLayout::INTERLEAVED>
     Texture* requestTexture(glm::ivec2 resolution)
     {
-        bool isUniform = resolution.x == 0;
-
-        if (this->textures.contains(resolution))
+        // a planned buffer is free when the plan's reference is the only one left
+        if (this->currentPlannedTextures != nullptr)
         {
-            for (const auto& texture : this->textures[resolution])
+            for (Texture* plannedTex : *this->currentPlannedTextures)
             {
-                if (texture->numReferences == 0 && (isUniform || texture->isType<texType>()))
+                if (plannedTex->numReferences == 1 && plannedTex->resolution == resolution && plannedTex->isType<texType>() && plannedTex->getLayout() == layout)
                 {
-                    ++texture->numReferences;
-                    requestedTextures.push_back(texture.get());
-                    return texture.get();
+                    ++plannedTex->numReferences;
+                    requestedTextures.push_back(plannedTex);
+                    return plannedTex;
                 }
             }
         }
-        else
+
+        bool isUniform = resolution.x == 0;
+
+        this->bucketLastUsedEvaluations[resolution] = this->evaluationIdx;
+
+        Texture* texPtr = nullptr;
+        for (const auto& texture : this->textures[resolution])
         {
-            this->textures[resolution] = std::vector<std::unique_ptr<Texture>>();
+            if (texture->numReferences == 0 && (isUniform || (texture->isType<texType>() && texture->getLayout() == layout)))
+            {
+                texPtr = texture.get();
+                break;
+            }
         }
 
-        auto tex = std::make_unique<Texture>();
-
-        if (!isUniform)
+        if (texPtr == nullptr && !isUniform)
         {
-            tex->malloc<texType>(resolution);
+            // evicting a cache can free up a texture that fits this request
+            texPtr = makeRoom(resolution, texType, layout, Texture::getNumBytes<texType>(resolution));
         }
 
-        Texture* texPtr = tex.get();
-        this->textures[resolution].push_back(std::move(tex));
+        if (texPtr == nullptr)
+        {
+            auto tex = std::make_unique<Texture>();
+
+            if (!isUniform)
+            {
+                tex->malloc<texType, layout>(resolution);
+                this->numAllocatedBytes += tex->getNumBytes();
+            }
+
+            texPtr = tex.get();
+            this->textures[resolution].push_back(std::move(tex));
+        }
 
         ++texPtr->numReferences;
         requestedTextures.push_back(texPtr);
@@ -77,18 +204,109 @@ public:
     }
 
     template<TextureType texType>
-    Texture* requestTexture() // defaults to output resolution
+    Texture* requestTexture() // defaults to output resolution at the current proxy level
     {
-        return this->requestTexture<texType>(this->outputResolution);
+        return this->requestTexture<texType>(getScaledResolution(this->outputResolution));
     }
 
     Texture* requestUniformTexture(); // resolution = (0, 0)
 
-    Texture* getOutputTexture() const;
-    void setOutputTexture(Texture* texture);
-    bool hasOutputTexture() const;
+    // wraps a view (e.g. Texture::getChannelView()) so it can be propagated like a requested texture
+    // the parent stays referenced, and so can't be reused or written in place, until nothing references the view
+    Texture* requestView(const Texture& view);
+
+    // wraps a procedural texture (see Texture::makeProcedural()) so it can be propagated like a requested texture
+    Texture* requestProcedural(const Texture& procTex);
+
+    // buffer with region of procTex filled in, requested by the current node
+    // for nodes that read their inputs some other way than Texture::fetchColor()
+    Texture* materializeProcedural(const Texture& procTex, const ImageRegion& region);
+
+    // true iff tex came through inputPin's edge and nothing else (another edge, a cache) will read it
+    bool canWriteInPlace(const Pin& inputPin, Texture* tex) const;
+    void claimTexture(Texture* tex); // hands an existing texture to the current node as if it was requested
+
+    void releaseUnusedTextures(); // frees textures that aren't referenced by anything, including pin caches, worker must be idle
+
+    size_t getMemoryBudget() const;
+    void setMemoryBudget(size_t memoryBudget); // applied from the next texture request
+    std::vector<TextureBucketUsage> getTextureUsage(); // as of the last evaluation
+    BufferPlanSummary getBufferPlanSummary();
+
+    // pins with a cached texture at any level register themselves so the least recently used one can be evicted
+    void registerCachedPin(Pin* pin);
+    void unregisterCachedPin(Pin* pin);
+    uint64_t getEvaluationIdx() const;
+
+    void stashResult(const Pin* pin, int level, uint64_t resultHash, Texture* texture, const ImageRegion& region); // takes over the pin's reference
+    void discardStashedResults(const Node* node); // call before deleting the node, worker must be idle
 
+    glm::ivec2 getOutputResolution() const; // full resolution
+    void setOutputResolution(glm::ivec2 outputResolution); // caller is responsible for invalidating caches
+
+    int getProxyLevel() const;
+    void setProxyLevel(int proxyLevel);
+
+    // nodes with parameters measured in pixels should multiply them by this
+    float getResolutionScale() const;
+    glm::ivec2 getScaledResolution(glm::ivec2 fullResolution) const;
+    static ImageRegion scaleRegion(const ImageRegion& fullRegion, int proxyLevel);
+
+    Texture* getOutputTexture() const; // latest completed frame, only safe to read while the worker is idle
+    void setOutputTexture(Texture* texture); // called by the output node during evaluation
+    bool hasOutputTexture();
+
+    // caches are invalidated before the next evaluation starts
     bool setChangedNode(Node* changedNode); // returns true iff this->outputNode is reachable from changedNode
+    void applyChangedNodes(); // invalidates caches right away, worker must be idle (e.g. before deleting a changed node)
+    void invalidateGraph(); // call before adding or removing edges, worker must be idle
+
+    // only computes what's needed for outputRegion (full resolution pixels) at the current proxy level
+    // runs on the calling thread, so the worker has to be idle (see cancelEvaluation())
+    void evaluate(const ImageRegion& outputRegion);
+    bool isOutputComplete();
+
+    // queues an evaluation on the worker, which must be idle
+    // node parameters should be snapshotted right before so the worker never reads anything the UI is editing
+    void submit(const ImageRegion& outputRegion);
+    bool isBusy();
+
+    void requestCancel(); // doesn't wait, the worker stops at the next node boundary
+    void cancelEvaluation(); // waits for the worker to be idle, required before editing the graph
+    bool isCancelRequested() const; // long running nodes can check this to stop early
+
+    GLuint getViewerTextureId() const;
+    glm::vec2 getViewerUvMin() const; // part of the output image the viewer texture covers
+    glm::vec2 getViewerUvMax() const;
+    void updateViewerTexture(); // uploads the latest staged output, call once per frame on the main thread
+
+    bool getIsViewerDownsampled() const;
+    void setIsViewerDownsampled(bool isViewerDownsampled);
+    const ImageRegion& getViewerRegion() const;
+
+    // viewerSize is the on-screen size of viewerRegion in pixels
+    // returns true iff the output needs to be evaluated again to cover the new region
+    bool setViewerRegion(const ImageRegion& viewerRegion, glm::ivec2 viewerSize);
+
+private:
+    void workerLoop();
+
+    Texture* makeRoom(glm::ivec2 resolution, TextureType texType, TextureLayout layout, size_t numBytes); // returns an unused texture matching the request if one was freed up
+    Texture* getFreeViewSlot();
+    void sweepTextureViews(); // releases the parents of views that aren't referenced anymore
+    Texture* evictStashedResult(); // evicts the oldest stashed result and returns its texture, nullptr if nothing is stashed
+    void freeUnusedTextures(bool onlyIdleBuckets);
+    void trimTexturePool();
+
+    void hashResults();
+    void chooseCachedNodes();
+    void pruneUnneededInputs(Node* evaluatedNode);
+    void recordNodeTimings(const std::vector<Node*>& schedule);
+    bool restoreStashedResult(Pin* pin, const ImageRegion& region); // true iff a stashed result covering region was put back in the pin's cache
+
+    void planBuffers(const std::vector<Node*>& schedule);
+    void releasePlannedBuffers();
 
-    void evaluate();
+    void publishOutputTexture(const ImageRegion& outputRegion);
+    void stageOutputTexture(); // viewerMutex must be held
 };
@@ -1,6 +1,7 @@
 #include "node_ui_elements.hpp"
 
 #include "ImGui/imgui_internal.h"
+#include "ImGui/misc/cpp/imgui_stdlib.h"
 
 #include "portable_file_dialogs.h"
 
@@ -78,6 +79,20 @@ bool NodeUI::Checkbox(bool& v, const std::string& label)
     return didParameterChange;
 }
 
+bool NodeUI::TextEdit(std::string& text, float width)
+{
+    ImGui::PushID(&text);
+    ImGui::PushItemWidth(width);
+
+    ImGui::InputText("", &text);
+    bool didParameterChange = ImGui::IsItemDeactivatedAfterEdit();
+
+    ImGui::PopID();
+    ImGui::PopItemWidth();
+
+    return didParameterChange;
+}
+
 bool NodeUI::FilePicker(std::string* filePath, const std::vector<std::string>& filters)
 {
     ImGui::PushItemWidth(160);
@@ -36,6 +36,9 @@ namespace NodeUI
 
     bool Checkbox(bool& v, const std::string& label = "");
 
+    // only returns true once editing is confirmed, not for each character typed
+    bool TextEdit(std::string& text, float width = 160.f);
+
     bool FilePicker(std::string* filePath, const std::vector<std::string>& filters);
 
     bool Dropdown(int& selectedItem, const std::vector<const char*>& items);
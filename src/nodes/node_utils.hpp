@@ -1,8 +1,11 @@
 #pragma once
 
 #include "cuda_includes.hpp"
+#include "image_region.hpp"
 #include <glm/glm.hpp>
 
+#include <type_traits>
+
 inline int calculateNumBlocksPerGrid(int n, int blockSize)
 {
     return (n + blockSize - 1) / blockSize;
@@ -22,3 +25,28 @@ inline dim3 calculateNumBlocksPerGrid(const glm::ivec3& res, const dim3& blockSi
 {
     return dim3(calculateNumBlocksPerGrid(res.x, blockSize.x), calculateNumBlocksPerGrid(res.y, blockSize.y), calculateNumBlocksPerGrid(res.z, blockSize.z));
 }
+
+// kernels launched over a region offset their thread indices by region.min and return past region.max
+// always launches at least one block so empty regions don't need special handling
+inline dim3 calculateNumBlocksPerGrid(const ImageRegion& region, const dim3& blockSize)
+{
+    const glm::ivec2 size = glm::max(region.getSize(), glm::ivec2(1));
+    return dim3(calculateNumBlocksPerGrid(size.x, blockSize.x), calculateNumBlocksPerGrid(size.y, blockSize.y));
+}
+
+// calls f with std::integral_constant<..., value> for whichever of the listed values matches, e.g. to pick a kernel
+// specialized on an enum once per launch instead of switching on it per pixel
+template<auto firstValue, auto... otherValues, typename F>
+inline void dispatchValue(decltype(firstValue) value, F&& f)
+{
+    if (value == firstValue)
+    {
+        f(std::integral_constant<decltype(firstValue), firstValue>{});
+        return;
+    }
+
+    if constexpr (sizeof...(otherValues) > 0)
+    {
+        dispatchValue<otherValues...>(value, f);
+    }
+}
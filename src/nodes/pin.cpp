@@ -56,18 +56,40 @@ void Pin::propagateTexture(Texture* texture)
         edge->setTexture(texture);
     }
 
-    if (this->cachedTexture != nullptr)
+    const int level = getLevel();
+
+    if (texture != nullptr && (texture->isView() || texture->isProcedural()))
+    {
+        this->lastTextureResolutions[level] = glm::ivec2(0); // views and procedurals aren't allocated, so there's nothing to plan for them
+    }
+    else if (texture != nullptr && !texture->isUniform())
+    {
+        this->lastTextureResolutions[level] = texture->resolution;
+        this->lastTextureTypes[level] = texture->isType<TextureType::SINGLE>() ? TextureType::SINGLE : TextureType::MULTI;
+    }
+
+    Texture*& cachedTexture = this->cachedTextures[level];
+    PinCacheState& cacheState = this->cacheStates[level];
+
+    if (cachedTexture != nullptr)
     {
         printf("WARNING: calling propagateTexture() when cachedTexture != nullptr\n");
-        --this->cachedTexture->numReferences;
-        this->cachedTexture = nullptr;
+        --cachedTexture->numReferences;
+        cachedTexture = nullptr;
     }
 
-    if (this->cacheState == PinCacheState::PREPARED)
+    if (cacheState == PinCacheState::PREPARED)
     {
-        this->cachedTexture = texture;
-        ++this->cachedTexture->numReferences;
-        this->cacheState = PinCacheState::CACHED;
+        cachedTexture = texture;
+        ++cachedTexture->numReferences;
+        cacheState = PinCacheState::CACHED;
+
+        // uniform and procedural textures are valid everywhere
+        const bool isValidEverywhere = texture->isUniform() || texture->isProcedural();
+        this->cachedRegions[level] = isValidEverywhere ? ImageRegion::unbounded() : this->node->getOutputRegion();
+        this->cacheLastUsedEvaluations[level] = this->node->getNodeEvaluator()->getEvaluationIdx();
+        this->cachedResultHashes[level] = getResultHash();
+        updateCacheRegistration();
     }
 }
 
@@ -96,11 +118,43 @@ Pin& Pin::setSingleChannel()
     return *this;
 }
 
+Pin& Pin::setTextureType(TextureType textureType)
+{
+    this->textureType = textureType;
+    return *this;
+}
+
 TextureType Pin::getTextureType() const
 {
     return this->textureType;
 }
 
+uint8_t Pin::getChannelDemand() const
+{
+    return this->channelDemand;
+}
+
+void Pin::setChannelDemand(uint8_t channelDemand)
+{
+    this->channelDemand = channelDemand;
+}
+
+void Pin::addChannelDemand(uint8_t channelDemand)
+{
+    this->channelDemand |= channelDemand;
+}
+
+Pin& Pin::setVisible(bool isVisible)
+{
+    this->isVisible = isVisible;
+    return *this;
+}
+
+bool Pin::getIsVisible() const
+{
+    return this->isVisible;
+}
+
 unsigned int Pin::getColor() const
 {
     return textureType == TextureType::SINGLE ? IM_COL32(175, 175, 175, 180) : IM_COL32(53, 150, 250, 180);
@@ -111,31 +165,147 @@ unsigned int Pin::getHoveredColor() const
     return textureType == TextureType::SINGLE ? IM_COL32(175, 175, 175, 255) : IM_COL32(53, 150, 250, 255);
 }
 
+int Pin::getLevel() const
+{
+    return this->node->getNodeEvaluator()->getProxyLevel();
+}
+
 PinCacheState Pin::getCacheState() const
 {
-    return this->cacheState;
+    return this->cacheStates[getLevel()];
 }
 
 Texture* Pin::getCachedTexture() const
 {
-    return this->cachedTexture;
+    return this->cachedTextures[getLevel()];
+}
+
+Texture* Pin::getCachedTexture(int level) const
+{
+    return this->cachedTextures[level];
+}
+
+const ImageRegion& Pin::getCachedRegion() const
+{
+    return this->cachedRegions[getLevel()];
 }
 
 void Pin::prepareForCache()
 {
-    if (this->cacheState != PinCacheState::CACHED)
+    const int level = getLevel();
+
+    if (this->cachedTextures[level] != nullptr)
+    {
+        --this->cachedTextures[level]->numReferences;
+        this->cachedTextures[level] = nullptr;
+    }
+
+    this->cachedRegions[level] = {};
+    this->cachedResultHashes[level] = 0;
+    this->cacheStates[level] = PinCacheState::PREPARED;
+    updateCacheRegistration();
+}
+
+bool Pin::getLastTextureFormat(glm::ivec2& resolution, TextureType& textureType) const
+{
+    const int level = getLevel();
+    resolution = this->lastTextureResolutions[level];
+    textureType = this->lastTextureTypes[level];
+    return resolution.x != 0;
+}
+
+void Pin::touchCache()
+{
+    this->cacheLastUsedEvaluations[getLevel()] = this->node->getNodeEvaluator()->getEvaluationIdx();
+}
+
+uint64_t Pin::getResultHash() const
+{
+    const uint64_t nodeResultHash = this->node->getResultHash();
+    if (nodeResultHash == 0)
+    {
+        return 0;
+    }
+
+    const uint64_t resultHash = Hasher().add(nodeResultHash).add(this->id).get();
+    return resultHash != 0 ? resultHash : 1;
+}
+
+void Pin::restoreCache(Texture* texture, const ImageRegion& region, uint64_t resultHash)
+{
+    const int level = getLevel();
+
+    if (this->cachedTextures[level] != nullptr)
     {
-        this->cacheState = PinCacheState::PREPARED;
+        --this->cachedTextures[level]->numReferences;
     }
+
+    this->cachedTextures[level] = texture;
+    this->cachedRegions[level] = region;
+    this->cachedResultHashes[level] = resultHash;
+    this->cacheStates[level] = PinCacheState::CACHED;
+    this->cacheLastUsedEvaluations[level] = this->node->getNodeEvaluator()->getEvaluationIdx();
+    updateCacheRegistration();
+}
+
+uint64_t Pin::getCacheLastUsedEvaluation(int level) const
+{
+    return this->cacheLastUsedEvaluations[level];
+}
+
+void Pin::evictCache(int level)
+{
+    this->cacheStates[level] = PinCacheState::NO_CACHE;
+    this->cachedRegions[level] = {};
+    this->cachedResultHashes[level] = 0;
+
+    if (this->cachedTextures[level] != nullptr)
+    {
+        --this->cachedTextures[level]->numReferences;
+        this->cachedTextures[level] = nullptr;
+    }
+
+    updateCacheRegistration();
 }
 
 void Pin::deleteCache()
 {
-    this->cacheState = PinCacheState::NO_CACHE;
+    for (int level = 0; level < NUM_RESOLUTION_LEVELS; ++level)
+    {
+        evictCache(level);
+    }
+}
 
-    if (this->cachedTexture != nullptr)
+void Pin::stashCache()
+{
+    NodeEvaluator* nodeEvaluator = this->node->getNodeEvaluator();
+
+    for (int level = 0; level < NUM_RESOLUTION_LEVELS; ++level)
     {
-        --this->cachedTexture->numReferences;
-        this->cachedTexture = nullptr;
+        Texture*& cachedTexture = this->cachedTextures[level];
+        if (cachedTexture != nullptr && this->cacheStates[level] == PinCacheState::CACHED && this->cachedResultHashes[level] != 0)
+        {
+            // the stash takes over this pin's reference
+            nodeEvaluator->stashResult(this, level, this->cachedResultHashes[level], cachedTexture, this->cachedRegions[level]);
+            cachedTexture = nullptr;
+        }
+
+        evictCache(level);
     }
-}
\ No newline at end of file
+}
+
+void Pin::updateCacheRegistration()
+{
+    NodeEvaluator* nodeEvaluator = this->node->getNodeEvaluator();
+
+    for (const Texture* cachedTexture : this->cachedTextures)
+    {
+        if (cachedTexture != nullptr)
+        {
+            nodeEvaluator->registerCachedPin(this);
+            return;
+        }
+    }
+
+    nodeEvaluator->unregisterCachedPin(this);
+}
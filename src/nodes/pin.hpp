@@ -3,6 +3,7 @@
 #include "node.hpp"
 #include "node_enums.hpp"
 #include "texture.hpp"
+#include "image_region.hpp"
 
 #include <unordered_set>
 #include <string>
@@ -17,15 +18,25 @@ private:
     std::unordered_set<Edge*> edges;
 
     bool canConnect{ true };
+    bool isVisible{ true };
     TextureType textureType{ TextureType::MULTI };
+    uint8_t channelDemand{ Channels::RGBA }; // channels read by consumers in the current evaluation, see Node::getInputChannelDemand()
 
-    PinCacheState cacheState{ PinCacheState::NO_CACHE };
-    Texture* cachedTexture{ nullptr };
+    // caches are kept separately for each resolution level so proxy evaluation doesn't evict full resolution results
+    PinCacheState cacheStates[NUM_RESOLUTION_LEVELS]{};
+    Texture* cachedTextures[NUM_RESOLUTION_LEVELS]{};
+    ImageRegion cachedRegions[NUM_RESOLUTION_LEVELS]{}; // only this part of each cached texture is valid
+    uint64_t cacheLastUsedEvaluations[NUM_RESOLUTION_LEVELS]{}; // for evicting least recently used caches
+    uint64_t cachedResultHashes[NUM_RESOLUTION_LEVELS]{}; // result hash of the evaluation that filled each cache, 0 if it can't be stashed
+
+    // format of the last non-uniform texture propagated at each level, used to plan buffers ahead of evaluation
+    glm::ivec2 lastTextureResolutions[NUM_RESOLUTION_LEVELS]{};
+    TextureType lastTextureTypes[NUM_RESOLUTION_LEVELS]{};
 
 public:
     const int id;
     const PinType pinType;
-    const std::string name;
+    std::string name;
 
     Pin(int id, Node* node, PinType pinType, const std::string& name);
 
@@ -47,13 +58,41 @@ public:
     bool getCanConnect() const;
 
     Pin& setSingleChannel();
+    Pin& setTextureType(TextureType textureType);
     TextureType getTextureType() const;
 
+    // reset and accumulated by the node evaluator before each evaluation, outputs only
+    uint8_t getChannelDemand() const;
+    void setChannelDemand(uint8_t channelDemand);
+    void addChannelDemand(uint8_t channelDemand);
+
+    // hidden pins aren't drawn and have their edges removed by the GUI
+    Pin& setVisible(bool isVisible);
+    bool getIsVisible() const;
+
     unsigned int getColor() const;
     unsigned int getHoveredColor() const;
 
+    // these use the node evaluator's current resolution level
     PinCacheState getCacheState() const;
     Texture* getCachedTexture() const;
-    void prepareForCache();
-    void deleteCache();
+    const ImageRegion& getCachedRegion() const;
+    void prepareForCache(); // discards any existing cache since the node is about to be evaluated again
+
+    void touchCache(); // marks the cache as used by the current evaluation
+
+    uint64_t getResultHash() const; // of this pin in the current evaluation, 0 if it can't be reused
+    void restoreCache(Texture* texture, const ImageRegion& region, uint64_t resultHash); // takes over a stashed reference
+
+    bool getLastTextureFormat(glm::ivec2& resolution, TextureType& textureType) const; // false if nothing has been propagated yet
+
+    Texture* getCachedTexture(int level) const;
+    uint64_t getCacheLastUsedEvaluation(int level) const;
+    void evictCache(int level); // called by the node evaluator when it's low on memory
+    void deleteCache(); // deletes caches for all levels
+    void stashCache(); // like deleteCache(), but hands caches that could be valid again to the node evaluator
+
+private:
+    int getLevel() const;
+    void updateCacheRegistration();
 };
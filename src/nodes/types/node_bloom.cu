@@ -31,17 +31,17 @@ void NodeBloom::freeDeviceMemory()
     }
 }
 
-__global__ void kernCopyWithThreshold(Texture inTex, float threshold, Texture outTex)
+__global__ void kernCopyWithThreshold(Texture inTex, float threshold, Texture outTex, ImageRegion region)
 {
-    const int x = (blockIdx.x * blockDim.x) + threadIdx.x;
-    const int y = (blockIdx.y * blockDim.y) + threadIdx.y;
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
 
-    if (x >= inTex.resolution.x || y >= inTex.resolution.y)
+    if (x >= region.max.x || y >= region.max.y)
     {
         return;
     }
 
-    int idx = y * inTex.resolution.x + x;
+    const int idx = y * inTex.resolution.x + x;
     glm::vec4 inCol = inTex.getColor<TextureType::MULTI>(idx);
     glm::vec3 inRgb = glm::vec3(inCol) * inCol.a;
 
@@ -85,19 +85,19 @@ __global__ void kernFillBlurKernel(float* kernel, int kernelDiameter, float scal
     kernel[idx] = calculateKernelWeight(u, v, scale);
 }
 
-__global__ void kernAdd(Texture inTexBase, Texture inTexProcessed, float mix, Texture outTex)
+__global__ void kernAdd(Texture inTexBase, Texture inTexProcessed, float processedGain, float mix, Texture outTex, ImageRegion region)
 {
-    const int x = (blockIdx.x * blockDim.x) + threadIdx.x;
-    const int y = (blockIdx.y * blockDim.y) + threadIdx.y;
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
 
-    if (x >= inTexBase.resolution.x || y >= inTexBase.resolution.y)
+    if (x >= region.max.x || y >= region.max.y)
     {
         return;
     }
 
-    int idx = y * inTexBase.resolution.x + x;
+    const int idx = y * inTexBase.resolution.x + x;
     glm::vec3 baseRgb(inTexBase.getColor<TextureType::MULTI>(idx));
-    glm::vec3 processedCol(inTexProcessed.getColor<TextureType::MULTI>(idx));
+    glm::vec3 processedCol = glm::vec3(inTexProcessed.getColor<TextureType::MULTI>(idx)) * processedGain;
 
     glm::vec3 fullRgb(baseRgb + processedCol);
     glm::vec3 outRgb;
@@ -138,6 +138,28 @@ bool NodeBloom::drawPinExtras(const Pin* pin, int pinNumber)
     }
 }
 
+void NodeBloom::snapshotParameters()
+{
+    evalParams = constParams;
+}
+
+bool NodeBloom::hashParameters(Hasher& hasher) const
+{
+    hasher.add(evalParams.threshold).add(evalParams.size).add(evalParams.mix);
+    return true;
+}
+
+int NodeBloom::getKernelSize() const
+{
+    // each proxy level halves the kernel radius to match the image
+    return std::max(evalParams.size - nodeEvaluator->getProxyLevel(), kernelSizeMin);
+}
+
+ImageRegion NodeBloom::getInputRegion(int inputPinIdx, const ImageRegion& outputRegion) const
+{
+    return outputRegion.expand(1 << getKernelSize());
+}
+
 void NodeBloom::_evaluate()
 {
     Texture* inTex = getPinTextureOrUniformColor(inputPins[0], glm::vec4(0, 0, 0, 1));
@@ -153,45 +175,62 @@ void NodeBloom::_evaluate()
     Texture* outTex1 = nodeEvaluator->requestTexture<TextureType::MULTI>(inTex->resolution);
     Texture* outTex2 = nodeEvaluator->requestTexture<TextureType::MULTI>(inTex->resolution);
 
+    // the blur reads up to one kernel radius outside of the output region
+    const int kernelSize = getKernelSize();
+    const int kernelRadius = 1 << kernelSize;
+
+    const ImageRegion region = getEvaluationRegion(inTex->resolution);
+    const ImageRegion thresholdRegion = region.expand(kernelRadius).intersect(ImageRegion::fromResolution(inTex->resolution));
+
     const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
-    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(inTex->resolution, blockSize);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(region, blockSize);
 
-    kernCopyWithThreshold<<<blocksPerGrid, blockSize>>>(*inTex, constParams.threshold, *outTex1);
+    kernCopyWithThreshold<<<calculateNumBlocksPerGrid(thresholdRegion, blockSize), blockSize>>>(*inTex, evalParams.threshold, *outTex1, thresholdRegion);
 
-    const int kernelRadius = 1 << constParams.size;
     const int kernelDiameter = 2 * kernelRadius + 1;
     NppiSize oKernelSize = { kernelDiameter, kernelDiameter };
 
-    float*& dev_kernel = dev_bloomKernels[constParams.size - sizeMin];
+    // the kernel isn't normalized, so a smaller kernel gathers proportionally less light
+    const int fullKernelDiameter = 2 * (1 << evalParams.size) + 1;
+    const float processedGain = powf(fullKernelDiameter / (float)kernelDiameter, 2.f);
+
+    float*& dev_kernel = dev_bloomKernels[kernelSize - kernelSizeMin];
 
     if (dev_kernel == nullptr)
     {
         cudaMalloc(&dev_kernel, kernelDiameter * kernelDiameter * sizeof(float));
 
         const float scale = (1.f / 256.f) * powf(kernelDiameter, 2.38f); // last parameter is manually adjusted to get good visual results
-        kernFillBlurKernel<<<blocksPerGrid, blockSize>>>(dev_kernel, kernelDiameter, scale);
+        const dim3 kernelBlocksPerGrid = calculateNumBlocksPerGrid(glm::ivec2(kernelDiameter), blockSize);
+        kernFillBlurKernel<<<kernelBlocksPerGrid, blockSize>>>(dev_kernel, kernelDiameter, scale);
     }
 
-    const int width = outTex1->resolution.x;
-    const int height = outTex1->resolution.y;
-    NppiSize oSrcSize = { width, height };
-    NppiPoint oSrcOffset = { 0, 0 };
-
-    NppiSize oSizeROI = { width, height };
-
-    NppiPoint oAnchor = { kernelRadius, kernelRadius };
-
-    NPP_CHECK(nppiFilterBorder_32f_C4R(
-        (Npp32f*)outTex1->getDevPixels<TextureType::MULTI>(), width * 4 * sizeof(float),
-        oSrcSize, oSrcOffset,
-        (Npp32f*)outTex2->getDevPixels<TextureType::MULTI>(), width * 4 * sizeof(float),
-        oSizeROI,
-        (Npp32f*)dev_kernel, oKernelSize, oAnchor,
-        NPP_BORDER_REPLICATE
-    ));
+    if (!region.isEmpty())
+    {
+        const int width = outTex1->resolution.x;
+        const int height = outTex1->resolution.y;
+        NppiSize oSrcSize = { width, height };
+        NppiPoint oSrcOffset = { region.min.x, region.min.y };
+
+        const glm::ivec2 regionSize = region.getSize();
+        NppiSize oSizeROI = { regionSize.x, regionSize.y };
+
+        NppiPoint oAnchor = { kernelRadius, kernelRadius };
+
+        const int regionStartIdx = region.min.y * width + region.min.x;
+
+        NPP_CHECK(nppiFilterBorder_32f_C4R(
+            (Npp32f*)outTex1->getDevPixels<TextureType::MULTI>(), width * 4 * sizeof(float),
+            oSrcSize, oSrcOffset,
+            (Npp32f*)(outTex2->getDevPixels<TextureType::MULTI>() + regionStartIdx), width * 4 * sizeof(float),
+            oSizeROI,
+            (Npp32f*)dev_kernel, oKernelSize, oAnchor,
+            NPP_BORDER_REPLICATE
+        ));
+    }
     std::swap(outTex1, outTex2);
 
-    kernAdd<<<blocksPerGrid, blockSize>>>(*inTex, *outTex1, constParams.mix, *outTex2);
+    kernAdd<<<blocksPerGrid, blockSize>>>(*inTex, *outTex1, processedGain, evalParams.mix, *outTex2, region);
 
     outputPins[0].propagateTexture(outTex2);
 }
@@ -10,7 +10,9 @@ private:
     static constexpr int sizeMin = 4;
     static constexpr int sizeMax = 8;
 
-    static constexpr int numBloomKernels = sizeMax - sizeMin + 1;
+    // proxy evaluation shrinks the kernel along with the image, so smaller kernels than sizeMin are needed
+    static constexpr int kernelSizeMin = sizeMin - (NUM_RESOLUTION_LEVELS - 1);
+    static constexpr int numBloomKernels = sizeMax - kernelSizeMin + 1;
     static std::array<float*, numBloomKernels> dev_bloomKernels;
 
     struct
@@ -19,13 +21,21 @@ private:
         int size{ 5 };
         float mix{ 0.f };
     } constParams;
+    decltype(constParams) evalParams; // copy of constParams read during evaluation
 
 public:
     NodeBloom();
 
     static void freeDeviceMemory();
 
+    ImageRegion getInputRegion(int inputPinIdx, const ImageRegion& outputRegion) const override;
+
+private:
+    int getKernelSize() const; // log2 of the kernel radius at the current proxy level
+
 protected:
     bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
     void _evaluate() override;
 };
@@ -10,6 +10,15 @@ NodeBrightnessContrast::NodeBrightnessContrast()
     addPin(PinType::INPUT, "image");
     addPin(PinType::INPUT, "brightness").setNoConnect();
     addPin(PinType::INPUT, "contrast").setNoConnect();
+
+    setInPlace();
+    setReadsProceduralInputs();
+}
+
+// pointwise per channel, like exposure
+uint8_t NodeBrightnessContrast::getInputChannelDemand(int inputPinIdx) const
+{
+    return outputPins[0].getChannelDemand();
 }
 
 __host__ __device__ glm::vec4 applyBrightnessContrast(glm::vec4 col, float brightness, float contrast)
@@ -17,17 +26,19 @@ __host__ __device__ glm::vec4 applyBrightnessContrast(glm::vec4 col, float brigh
     return glm::vec4((contrast + 1.f) * (glm::vec3(col) - 0.5f) + 0.5f + brightness, col.a);
 }
 
-__global__ void kernBrightnessContrast(Texture inTex, Texture outTex, float brightness, float contrast)
+template<TextureKind inKind>
+__global__ void kernBrightnessContrast(Texture inTex, Texture outTex, float brightness, float contrast, ImageRegion region)
 {
-    const int idx = (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
 
-    if (idx >= inTex.getNumPixels())
+    if (x >= region.max.x || y >= region.max.y)
     {
         return;
     }
 
-    glm::vec4 outCol = applyBrightnessContrast(inTex.getColor<TextureType::MULTI>(idx), brightness, contrast);
-    outTex.setColor<TextureType::MULTI>(idx, outCol);
+    glm::vec4 outCol = applyBrightnessContrast(inTex.fetchColor<inKind, TextureType::MULTI>(x, y), brightness, contrast);
+    outTex.storeColor<TextureType::MULTI>(x, y, outCol);
 }
 
 bool NodeBrightnessContrast::drawPinExtras(const Pin* pin, int pinNumber)
@@ -53,26 +64,40 @@ bool NodeBrightnessContrast::drawPinExtras(const Pin* pin, int pinNumber)
     }
 }
 
+void NodeBrightnessContrast::snapshotParameters()
+{
+    evalParams = constParams;
+}
+
+bool NodeBrightnessContrast::hashParameters(Hasher& hasher) const
+{
+    hasher.add(evalParams.color).add(evalParams.brightness).add(evalParams.contrast);
+    return true;
+}
+
 void NodeBrightnessContrast::_evaluate()
 {
-    Texture* inTex = getPinTextureOrUniformColor(inputPins[0], ColorUtils::srgbToLinear(constParams.color));
+    Texture* inTex = getPinTextureOrUniformColor(inputPins[0], ColorUtils::srgbToLinear(evalParams.color));
 
     if (inTex->isUniform()) {
         Texture* outTex = nodeEvaluator->requestUniformTexture();
 
         glm::vec4 inCol = inTex->getUniformColor<TextureType::MULTI>();
-        glm::vec4 outCol = applyBrightnessContrast(inCol, constParams.brightness, constParams.contrast);
+        glm::vec4 outCol = applyBrightnessContrast(inCol, evalParams.brightness, evalParams.contrast);
         outTex->setUniformColor(outCol);
 
         outputPins[0].propagateTexture(outTex);
         return;
     }
 
-    Texture* outTex = nodeEvaluator->requestTexture<TextureType::MULTI>(inTex->resolution);
+    Texture* outTex = requestOutputTexture(inTex, TextureType::MULTI);
 
-    const dim3 blockSize(DEFAULT_BLOCK_SIZE_1D);
-    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(inTex->getNumPixels(), blockSize);
-    kernBrightnessContrast<<<blocksPerGrid, blockSize>>>(*inTex, *outTex, constParams.brightness, constParams.contrast);
+    const ImageRegion region = getEvaluationRegion(outTex->resolution);
+    const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(region, blockSize);
+    Texture::dispatchKinds([&](auto inKind) {
+        kernBrightnessContrast<decltype(inKind)::value><<<blocksPerGrid, blockSize>>>(*inTex, *outTex, evalParams.brightness, evalParams.contrast, region);
+    }, *inTex);
 
     outputPins[0].propagateTexture(outTex);
 }
@@ -11,11 +11,16 @@ private:
         float brightness{ 0.f };
         float contrast{ 0.f };
     } constParams;
+    decltype(constParams) evalParams; // copy of constParams read during evaluation
 
 public:
     NodeBrightnessContrast();
 
+    uint8_t getInputChannelDemand(int inputPinIdx) const override;
+
 protected:
     bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
     void _evaluate() override;
 };
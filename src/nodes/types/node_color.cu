@@ -20,9 +20,20 @@ bool NodeColor::drawPinExtras(const Pin* pin, int pinNumber)
     }
 }
 
+void NodeColor::snapshotParameters()
+{
+    evalParams = constParams;
+}
+
+bool NodeColor::hashParameters(Hasher& hasher) const
+{
+    hasher.add(evalParams.color);
+    return true;
+}
+
 void NodeColor::_evaluate()
 {
     Texture* outTex = nodeEvaluator->requestUniformTexture();
-    outTex->setUniformColor(ColorUtils::srgbToLinear(constParams.color));
+    outTex->setUniformColor(ColorUtils::srgbToLinear(evalParams.color));
     outputPins[0].propagateTexture(outTex);
 }
@@ -9,11 +9,14 @@ private:
     {
         glm::vec4 color{ NodeUI::defaultBackupVec4 };
     } constParams;
+    decltype(constParams) evalParams; // copy of constParams read during evaluation
 
 public:
     NodeColor();
 
 protected:
     bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
     void _evaluate() override;
 };
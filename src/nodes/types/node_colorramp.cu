@@ -2,6 +2,8 @@
 
 #include "cuda_includes.hpp"
 
+#include "thread_utils.hpp"
+
 std::vector<InterpolationName> NodeColorRamp::interpolationNames = {
     { ImGG::Interpolation::Linear, "linear" },
     { ImGG::Interpolation::Ease, "ease" },
@@ -17,11 +19,13 @@ NodeColorRamp::NodeColorRamp()
 
     addPin(PinType::INPUT, "interpolation").setNoConnect();
     addPin(PinType::INPUT, "factor").setSingleChannel();
+
+    setReadsProceduralInputs();
 }
 
 NodeColorRamp::~NodeColorRamp()
 {
-    CUDA_CHECK(cudaFree(dev_rawMarks));
+    CUDA_CHECK(cudaFree(dev_rampTable));
 }
 
 bool NodeColorRamp::drawPinBeforeExtras(const Pin* pin, int pinNumber)
@@ -76,6 +80,28 @@ bool NodeColorRamp::drawPinExtras(const Pin* pin, int pinNumber)
     }
 }
 
+void NodeColorRamp::snapshotParameters()
+{
+    evalParams = constParams;
+    evalGradient = gradientWidget.gradient();
+}
+
+void NodeColorRamp::hashGradient(Hasher& hasher) const
+{
+    hasher.add(evalGradient.interpolation_mode());
+    for (const auto& mark : evalGradient.get_marks())
+    {
+        hasher.add(mark.position.get()).add(mark.color);
+    }
+}
+
+bool NodeColorRamp::hashParameters(Hasher& hasher) const
+{
+    hashGradient(hasher);
+    hasher.add(evalParams.factor);
+    return true;
+}
+
 __host__ __device__ static glm::vec4 getRampColor(float pos, const ImGG::RawMark* marksStart, int numMarks, ImGG::Interpolation interpolationMode)
 {
     pos = glm::clamp(pos, 0.f, 1.f);
@@ -117,32 +143,69 @@ __host__ __device__ static glm::vec4 getRampColor(float pos, const ImGG::RawMark
     return ImGG::rampInterpolate(lower, upper, pos, interpolationMode);
 }
 
-__global__ void kernApplyColorRamp(Texture inTex, ImGG::RawMark* rawMarks, int numRawMarks, ImGG::Interpolation interpolationMode, Texture outTex)
+// constant interpolation takes the sample at or below pos so steps stay sharp, the others blend the two nearest samples
+template<TextureKind inKind, bool isConstant>
+__global__ void kernApplyColorRamp(Texture inTex, const glm::vec4* rampTable, int rampTableSize, Texture outTex, ImageRegion region)
 {
-    __shared__ ImGG::RawMark shared_rawMarks[IMGG_GRADIENT_MAX_MARKS];
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
 
-    if (threadIdx.x < numRawMarks)
+    if (x >= region.max.x || y >= region.max.y)
     {
-        shared_rawMarks[threadIdx.x] = rawMarks[threadIdx.x];
+        return;
     }
 
-    __syncthreads();
+    const float factor = fminf(fmaxf(inTex.fetchColor<inKind, TextureType::SINGLE>(x, y), 0.f), 1.f); // NaN reads as 0
+    const float pos = factor * (rampTableSize - 1);
+    const int lowerIdx = (int)pos;
+
+    glm::vec4 outColor;
+    if constexpr (isConstant)
+    {
+        outColor = rampTable[lowerIdx];
+    }
+    else
+    {
+        const int upperIdx = glm::min(lowerIdx + 1, rampTableSize - 1);
+        outColor = glm::mix(rampTable[lowerIdx], rampTable[upperIdx], pos - lowerIdx);
+    }
 
-    const int idx = (blockIdx.x * blockDim.x) + threadIdx.x;
+    outTex.storeColor<TextureType::MULTI>(x, y, outColor);
+}
 
-    if (idx >= inTex.getNumPixels())
+void NodeColorRamp::bakeRampTable(const std::vector<ImGG::RawMark>& rawMarks)
+{
+    Hasher hasher;
+    hashGradient(hasher);
+    if (dev_rampTable != nullptr && hasher.get() == bakedGradientHash)
     {
         return;
     }
 
-    float pos = inTex.getColor<TextureType::SINGLE>(idx);
-    glm::vec4 outColor = getRampColor(pos, shared_rawMarks, numRawMarks, interpolationMode);
-    outTex.setColor<TextureType::MULTI>(idx, outColor);
+    const ImGG::Interpolation interpolationMode = evalGradient.interpolation_mode();
+
+    std::vector<glm::vec4> host_rampTable(rampTableSize);
+    ThreadUtils::parallelFor(0, rampTableSize, [&](int sampleBegin, int sampleEnd)
+    {
+        for (int sampleIdx = sampleBegin; sampleIdx < sampleEnd; ++sampleIdx)
+        {
+            const float pos = (float)sampleIdx / (rampTableSize - 1);
+            host_rampTable[sampleIdx] = getRampColor(pos, rawMarks.data(), rawMarks.size(), interpolationMode);
+        }
+    }, 256);
+
+    if (dev_rampTable == nullptr)
+    {
+        CUDA_CHECK(cudaMalloc(&dev_rampTable, rampTableSize * sizeof(glm::vec4)));
+    }
+
+    CUDA_CHECK(cudaMemcpy(dev_rampTable, host_rampTable.data(), rampTableSize * sizeof(glm::vec4), cudaMemcpyHostToDevice));
+    bakedGradientHash = hasher.get();
 }
 
 void NodeColorRamp::_evaluate()
 {
-    const auto& gradient = gradientWidget.gradient();
+    const auto& gradient = evalGradient;
     const auto& marks = gradient.get_marks();
 
     if (marks.size() == 0)
@@ -161,7 +224,7 @@ void NodeColorRamp::_evaluate()
         rawMarks.emplace_back(pos, color);
     }
 
-    Texture* inTex = getPinTextureOrUniformColor(inputPins[1], constParams.factor);
+    Texture* inTex = getPinTextureOrUniformColor(inputPins[1], evalParams.factor);
 
     if (inTex->isUniform())
     {
@@ -171,23 +234,21 @@ void NodeColorRamp::_evaluate()
         return;
     }
 
-    if (dev_rawMarks == nullptr)
-    {
-        CUDA_CHECK(cudaMalloc(&dev_rawMarks, IMGG_GRADIENT_MAX_MARKS * sizeof(ImGG::RawMark)));
-    }
-
-    const int numRawMarks = rawMarks.size();
-    cudaMemcpy(dev_rawMarks, rawMarks.data(), numRawMarks * sizeof(ImGG::RawMark), cudaMemcpyHostToDevice); // TODO: no memcpy if parameters haven't changed?
-
-    Texture* outTex = nodeEvaluator->requestTexture<TextureType::MULTI>(inTex->resolution);
-
-    const dim3 blockSize(DEFAULT_BLOCK_SIZE_1D);
-    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(inTex->getNumPixels(), blockSize);
-    kernApplyColorRamp<<<blocksPerGrid, blockSize>>>(
-        *inTex,
-        dev_rawMarks, numRawMarks, gradient.interpolation_mode(),
-        *outTex
-    );
+    bakeRampTable(rawMarks);
+
+    Texture* outTex = requestOutputTexture(inTex->resolution, TextureType::MULTI);
+
+    const ImageRegion region = getEvaluationRegion(outTex->resolution);
+    const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(region, blockSize);
+    const bool isConstant = gradient.interpolation_mode() == ImGG::Interpolation::Constant;
+    Texture::dispatchKinds([&](auto inKind) {
+        dispatchValue<false, true>(isConstant, [&](auto isConstantValue) {
+            kernApplyColorRamp<decltype(inKind)::value, decltype(isConstantValue)::value><<<blocksPerGrid, blockSize>>>(
+                *inTex, dev_rampTable, rampTableSize, *outTex, region
+            );
+        });
+    }, *inTex);
 
     outputPins[0].propagateTexture(outTex);
 }
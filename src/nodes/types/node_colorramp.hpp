@@ -16,13 +16,19 @@ private:
     static std::vector<InterpolationName> interpolationNames;
 
     ImGG::GradientWidget gradientWidget{};
-    ImGG::RawMark* dev_rawMarks{ nullptr };
+    ImGG::Gradient evalGradient{}; // copy of the widget's gradient read during evaluation
+
+    // the gradient baked into evenly spaced samples, rebuilt only when the marks or interpolation change
+    static constexpr int rampTableSize = 4096;
+    glm::vec4* dev_rampTable{ nullptr };
+    uint64_t bakedGradientHash{ 0 };
 
     struct
     {
         InterpolationName* interpolationNamePtr{ &interpolationNames[0] };
         float factor{ 0.5f };
     } constParams;
+    decltype(constParams) evalParams; // copy of constParams read during evaluation
 
 public:
     NodeColorRamp();
@@ -31,5 +37,11 @@ public:
 protected:
     bool drawPinBeforeExtras(const Pin* pin, int pinNumber) override;
     bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
     void _evaluate() override;
+
+private:
+    void hashGradient(Hasher& hasher) const;
+    void bakeRampTable(const std::vector<ImGG::RawMark>& rawMarks);
 };
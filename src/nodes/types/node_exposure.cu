@@ -9,19 +9,30 @@ NodeExposure::NodeExposure()
 
     addPin(PinType::INPUT, "image");
     addPin(PinType::INPUT, "exposure").setNoConnect();
+
+    setInPlace();
+    setReadsProceduralInputs();
 }
 
-__global__ void kernExposure(Texture inTex, Texture outTex, float multiplier)
+// every channel is scaled on its own
+uint8_t NodeExposure::getInputChannelDemand(int inputPinIdx) const
 {
-    const int idx = (blockIdx.x * blockDim.x) + threadIdx.x;
+    return outputPins[0].getChannelDemand();
+}
 
-    if (idx >= inTex.getNumPixels())
+template<TextureKind inKind>
+__global__ void kernExposure(Texture inTex, Texture outTex, float multiplier, ImageRegion region)
+{
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
+
+    if (x >= region.max.x || y >= region.max.y)
     {
         return;
     }
 
-    glm::vec4 col = inTex.getColor<TextureType::MULTI>(idx);
-    outTex.setColor<TextureType::MULTI>(idx, glm::vec4(glm::vec3(col) * multiplier, col.a));
+    glm::vec4 col = inTex.fetchColor<inKind, TextureType::MULTI>(x, y);
+    outTex.storeColor<TextureType::MULTI>(x, y, glm::vec4(glm::vec3(col) * multiplier, col.a));
 }
 
 bool NodeExposure::drawPinExtras(const Pin* pin, int pinNumber)
@@ -44,26 +55,40 @@ bool NodeExposure::drawPinExtras(const Pin* pin, int pinNumber)
     }
 }
 
+void NodeExposure::snapshotParameters()
+{
+    evalParams = constParams;
+}
+
+bool NodeExposure::hashParameters(Hasher& hasher) const
+{
+    hasher.add(evalParams.color).add(evalParams.exposure);
+    return true;
+}
+
 void NodeExposure::_evaluate()
 {
-    Texture* inTex = getPinTextureOrUniformColor(inputPins[0], ColorUtils::srgbToLinear(constParams.color));
+    Texture* inTex = getPinTextureOrUniformColor(inputPins[0], ColorUtils::srgbToLinear(evalParams.color));
 
     if (inTex->isUniform()) {
         Texture* outTex = nodeEvaluator->requestUniformTexture();
 
         const glm::vec4 inCol = inTex->getUniformColor<TextureType::MULTI>();
-        glm::vec4 outCol = glm::vec4(glm::vec3(inCol) * powf(2.f, constParams.exposure), inCol.a);
+        glm::vec4 outCol = glm::vec4(glm::vec3(inCol) * powf(2.f, evalParams.exposure), inCol.a);
         outTex->setUniformColor(outCol);
 
         outputPins[0].propagateTexture(outTex);
         return;
     }
 
-    Texture* outTex = nodeEvaluator->requestTexture<TextureType::MULTI>(inTex->resolution);
+    Texture* outTex = requestOutputTexture(inTex, TextureType::MULTI);
 
-    const dim3 blockSize(DEFAULT_BLOCK_SIZE_1D);
-    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(inTex->getNumPixels(), blockSize);
-    kernExposure<<<blocksPerGrid, blockSize>>>(*inTex, *outTex, powf(2.f, constParams.exposure));
+    const ImageRegion region = getEvaluationRegion(outTex->resolution);
+    const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(region, blockSize);
+    Texture::dispatchKinds([&](auto inKind) {
+        kernExposure<decltype(inKind)::value><<<blocksPerGrid, blockSize>>>(*inTex, *outTex, powf(2.f, evalParams.exposure), region);
+    }, *inTex);
 
     outputPins[0].propagateTexture(outTex);
 }
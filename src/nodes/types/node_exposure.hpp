@@ -10,11 +10,16 @@ private:
         glm::vec4 color{ NodeUI::defaultBackupVec4 };
         float exposure{ 0.f };
     } constParams;
+    decltype(constParams) evalParams; // copy of constParams read during evaluation
 
 public:
     NodeExposure();
 
+    uint8_t getInputChannelDemand(int inputPinIdx) const override;
+
 protected:
     bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
     void _evaluate() override;
 };
@@ -0,0 +1,176 @@
+#include "node_expression.hpp"
+
+#include "cuda_includes.hpp"
+
+NodeExpression::NodeExpression()
+    : Node("expression")
+{
+    addPin(PinType::OUTPUT, "value").setSingleChannel();
+
+    addPin(PinType::INPUT, "a");
+    addPin(PinType::INPUT, "b");
+    addPin(PinType::INPUT, "c");
+
+    setReadsProceduralInputs();
+
+    editedFormula = constParams.formula;
+    Expression::compile(constParams.formula, constParams.program, compileError);
+    evalParams = constParams; // isInputNeeded() reads the program before the first snapshot too
+}
+
+bool NodeExpression::isInputNeeded(int inputPinIdx) const
+{
+    return (evalParams.program.inputMask & (1u << inputPinIdx)) != 0;
+}
+
+uint8_t NodeExpression::getInputChannelDemand(int inputPinIdx) const
+{
+    return evalParams.program.inputChannels[inputPinIdx];
+}
+
+bool NodeExpression::drawPinBeforeExtras(const Pin* pin, int pinNumber)
+{
+    if (pin->pinType != PinType::INPUT || pinNumber != 0)
+    {
+        return false;
+    }
+
+    bool didParameterChange = false;
+    if (NodeUI::TextEdit(editedFormula) && editedFormula != constParams.formula)
+    {
+        constParams.formula = editedFormula;
+        Expression::compile(constParams.formula, constParams.program, compileError);
+        didParameterChange = true;
+    }
+
+    if (!compileError.empty())
+    {
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "%s", compileError.c_str());
+    }
+
+    return didParameterChange;
+}
+
+bool NodeExpression::drawPinExtras(const Pin* pin, int pinNumber)
+{
+    if (pin->pinType == PinType::OUTPUT || pin->hasEdge())
+    {
+        return false;
+    }
+
+    switch (pinNumber)
+    {
+    case 0: // a
+    case 1: // b
+    case 2: // c
+        ImGui::SameLine();
+        return NodeUI::FloatEdit(constParams.inputs[pinNumber], 0.01f);
+    default:
+        throw std::runtime_error("invalid pin number");
+    }
+}
+
+void NodeExpression::snapshotParameters()
+{
+    evalParams = constParams;
+}
+
+bool NodeExpression::hashParameters(Hasher& hasher) const
+{
+    hasher.add(evalParams.formula);
+    for (float input : evalParams.inputs)
+    {
+        hasher.add(input);
+    }
+    return true;
+}
+
+// the program is a kernel parameter, so every thread reads each instruction from the same constant bank address
+template<TextureKind kindA, TextureKind kindB, TextureKind kindC>
+__global__ void kernEvaluateExpression(Texture inTexA, Texture inTexB, Texture inTexC, Expression::Program program,
+    float positionScale, Texture outTex, ImageRegion region)
+{
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
+
+    if (x >= region.max.x || y >= region.max.y)
+    {
+        return;
+    }
+
+    Expression::Variables variables;
+    variables.inputs[0] = (program.inputMask & 1) ? inTexA.fetchColorClamp<kindA, TextureType::MULTI>(x, y) : glm::vec4(0);
+    variables.inputs[1] = (program.inputMask & 2) ? inTexB.fetchColorClamp<kindB, TextureType::MULTI>(x, y) : glm::vec4(0);
+    variables.inputs[2] = (program.inputMask & 4) ? inTexC.fetchColorClamp<kindC, TextureType::MULTI>(x, y) : glm::vec4(0);
+    variables.position = glm::vec2(x, y) * positionScale;
+    variables.uv = glm::vec2(x, y) / glm::vec2(outTex.resolution);
+
+    outTex.storeColor<TextureType::SINGLE>(x, y, Expression::run(program, variables));
+}
+
+void NodeExpression::_evaluate()
+{
+    const Expression::Program& program = evalParams.program;
+
+    if (program.numInstructions == 0) // didn't compile
+    {
+        Texture* outTex = nodeEvaluator->requestUniformTexture();
+        outTex->setUniformColor(0.f);
+        outputPins[0].propagateTexture(outTex);
+        return;
+    }
+
+    Texture* inTexA = getPinTextureOrUniformColor(inputPins[0], evalParams.inputs[0]);
+    Texture* inTexB = getPinTextureOrUniformColor(inputPins[1], evalParams.inputs[1]);
+    Texture* inTexC = getPinTextureOrUniformColor(inputPins[2], evalParams.inputs[2]);
+
+    // inputs the formula doesn't read don't decide anything, they aren't evaluated either (see isInputNeeded())
+    const bool isAUniform = !(program.inputMask & 1) || inTexA->isUniform();
+    const bool isBUniform = !(program.inputMask & 2) || inTexB->isUniform();
+    const bool isCUniform = !(program.inputMask & 4) || inTexC->isUniform();
+
+    if (isAUniform && isBUniform && isCUniform && !program.readsPosition)
+    {
+        Expression::Variables variables{};
+        variables.inputs[0] = inTexA->getUniformColor<TextureType::MULTI>();
+        variables.inputs[1] = inTexB->getUniformColor<TextureType::MULTI>();
+        variables.inputs[2] = inTexC->getUniformColor<TextureType::MULTI>();
+
+        Texture* outTex = nodeEvaluator->requestUniformTexture();
+        outTex->setUniformColor(Expression::run(program, variables));
+        outputPins[0].propagateTexture(outTex);
+        return;
+    }
+
+    glm::ivec2 outRes;
+    if (!isAUniform)
+    {
+        outRes = inTexA->resolution;
+    }
+    else if (!isBUniform)
+    {
+        outRes = inTexB->resolution;
+    }
+    else if (!isCUniform)
+    {
+        outRes = inTexC->resolution;
+    }
+    else // only the position varies
+    {
+        outRes = nodeEvaluator->getScaledResolution(nodeEvaluator->getOutputResolution());
+    }
+
+    Texture* outTex = nodeEvaluator->requestTexture<TextureType::SINGLE>(outRes);
+
+    const ImageRegion region = getEvaluationRegion(outRes);
+    const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(region, blockSize);
+    const float positionScale = 1.f / nodeEvaluator->getResolutionScale(); // x and y are in full resolution pixels at every proxy level
+    Texture::dispatchKinds([&](auto kindA, auto kindB, auto kindC) {
+        kernEvaluateExpression<decltype(kindA)::value, decltype(kindB)::value, decltype(kindC)::value><<<blocksPerGrid, blockSize>>>(
+            *inTexA, *inTexB, *inTexC, program, positionScale, *outTex, region
+        );
+    }, *inTexA, *inTexB, *inTexC);
+
+    outputPins[0].propagateTexture(outTex);
+}
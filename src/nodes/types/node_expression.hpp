@@ -0,0 +1,33 @@
+#pragma once
+
+#include "nodes/node.hpp"
+
+#include "expression.hpp"
+
+class NodeExpression : public Node
+{
+private:
+    std::string editedFormula; // what's in the text box, only compiled once editing is confirmed
+    std::string compileError;
+
+    struct
+    {
+        std::string formula{ "a" };
+        Expression::Program program;
+        float inputs[Expression::numInputs]{ 0.5f, 0.5f, 0.5f }; // for unconnected inputs
+    } constParams;
+    decltype(constParams) evalParams; // copy of constParams read during evaluation
+
+public:
+    NodeExpression();
+
+    bool isInputNeeded(int inputPinIdx) const override;
+    uint8_t getInputChannelDemand(int inputPinIdx) const override;
+
+protected:
+    bool drawPinBeforeExtras(const Pin* pin, int pinNumber) override;
+    bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
+    void _evaluate() override;
+};
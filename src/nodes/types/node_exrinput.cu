@@ -0,0 +1,251 @@
+#include "node_exrinput.hpp"
+
+#include "cuda_includes.hpp"
+
+#include <map>
+
+NodeExrInput::NodeExrInput()
+    : Node("EXR input")
+{
+    for (int layerIdx = 0; layerIdx < maxNumLayers; ++layerIdx)
+    {
+        addPin(PinType::OUTPUT).setVisible(false);
+    }
+
+    addPin(PinType::INPUT, "file").setNoConnect();
+
+    setExpensive();
+    setNeedsFullImage(); // all channels are decoded in one pass anyway, so whole layers are cached
+}
+
+unsigned int NodeExrInput::getTitleBarColor() const
+{
+    return IM_COL32(7, 94, 11, 255);
+}
+
+unsigned int NodeExrInput::getTitleBarHoveredColor() const
+{
+    return IM_COL32(47, 153, 53, 255);
+}
+
+bool NodeExrInput::drawPinExtras(const Pin* pin, int pinNumber)
+{
+    if (pin->pinType == PinType::OUTPUT)
+    {
+        return false;
+    }
+
+    switch (pinNumber)
+    {
+    case 0: // file
+    {
+        ImGui::SameLine();
+        return NodeUI::FilePicker(&filePath, { "OpenEXR Files (.exr)", "*.exr" });
+    }
+    default:
+        throw std::runtime_error("invalid pin number");
+    }
+}
+
+void NodeExrInput::snapshotParameters()
+{
+    if (openedFilePath != filePath)
+    {
+        openFile();
+    }
+}
+
+bool NodeExrInput::hashParameters(Hasher& hasher) const
+{
+    hasher.add(openedFilePath);
+    return true;
+}
+
+void NodeExrInput::openFile()
+{
+    openedFilePath = filePath;
+    layers.clear();
+
+    if (reader.open(filePath))
+    {
+        buildLayers();
+    }
+
+    for (int layerIdx = 0; layerIdx < maxNumLayers; ++layerIdx)
+    {
+        Pin& outputPin = outputPins[layerIdx];
+
+        if (layerIdx >= layers.size())
+        {
+            outputPin.setVisible(false); // edges are removed by the GUI
+            continue;
+        }
+
+        const Layer& layer = layers[layerIdx];
+        outputPin.name = layer.name;
+        outputPin.setTextureType(layer.channelIdxs.size() == 1 ? TextureType::SINGLE : TextureType::MULTI);
+        outputPin.setVisible(true);
+    }
+}
+
+static int getComponentIdx(const std::string& suffix)
+{
+    if (suffix == "R" || suffix == "r" || suffix == "X" || suffix == "x" || suffix == "U" || suffix == "u") return 0;
+    if (suffix == "G" || suffix == "g" || suffix == "Y" || suffix == "y" || suffix == "V" || suffix == "v") return 1;
+    if (suffix == "B" || suffix == "b" || suffix == "Z" || suffix == "z" || suffix == "W" || suffix == "w") return 2;
+    if (suffix == "A" || suffix == "a") return 3;
+    return -1;
+}
+
+// groups channels into layers by the prefix before their last '.', e.g. "normal.X", "normal.Y", "normal.Z" -> "normal"
+// channels without a prefix form the main RGBA layer, except for anything else like "Z" which gets its own layer
+// layers with a single channel (e.g. depth) are output as single channel textures
+void NodeExrInput::buildLayers()
+{
+    std::vector<std::string> layerNames;
+    std::map<std::string, std::vector<std::pair<std::string, int>>> layerChannels; // layer name -> (suffix, channel index)
+
+    for (int channelIdx = 0; channelIdx < reader.getNumChannels(); ++channelIdx)
+    {
+        const std::string channelName = reader.getChannelName(channelIdx);
+        const size_t dotPos = channelName.find_last_of('.');
+
+        std::string layerName, suffix;
+        if (dotPos == std::string::npos)
+        {
+            const bool isMainComponent = channelName == "R" || channelName == "G" || channelName == "B" || channelName == "A";
+            layerName = isMainComponent ? "image" : channelName;
+            suffix = channelName;
+        }
+        else
+        {
+            layerName = channelName.substr(0, dotPos);
+            suffix = channelName.substr(dotPos + 1);
+        }
+
+        if (!layerChannels.contains(layerName))
+        {
+            layerNames.push_back(layerName);
+        }
+
+        layerChannels[layerName].emplace_back(suffix, channelIdx);
+    }
+
+    // keep the main layer on top, the rest are already sorted since EXR channels are stored alphabetically
+    std::stable_partition(layerNames.begin(), layerNames.end(), [](const std::string& name) { return name == "image"; });
+
+    for (const auto& layerName : layerNames)
+    {
+        if (layers.size() == maxNumLayers)
+        {
+            printf("WARNING: %s has more than %d layers, ignoring the rest\n", filePath.c_str(), maxNumLayers);
+            break;
+        }
+
+        const auto& channels = layerChannels[layerName];
+
+        Layer& layer = layers.emplace_back();
+        layer.name = layerName;
+
+        if (channels.size() == 1)
+        {
+            layer.channelIdxs = { channels[0].second };
+            continue;
+        }
+
+        layer.channelIdxs = { -1, -1, -1, -1 };
+
+        std::vector<int> unassignedChannelIdxs;
+        for (const auto& [suffix, channelIdx] : channels)
+        {
+            int componentIdx = getComponentIdx(suffix);
+            if (componentIdx != -1 && layer.channelIdxs[componentIdx] == -1)
+            {
+                layer.channelIdxs[componentIdx] = channelIdx;
+            }
+            else
+            {
+                unassignedChannelIdxs.push_back(channelIdx);
+            }
+        }
+
+        // channels with unknown names fill the remaining components in order
+        for (int channelIdx : unassignedChannelIdxs)
+        {
+            auto freeComponent = std::find(layer.channelIdxs.begin(), layer.channelIdxs.end(), -1);
+            if (freeComponent == layer.channelIdxs.end())
+            {
+                break;
+            }
+
+            *freeComponent = channelIdx;
+        }
+    }
+}
+
+void NodeExrInput::_evaluate()
+{
+    if (!reader.isOpen())
+    {
+        return;
+    }
+
+    bool isAnyLayerConnected = false;
+    for (int layerIdx = 0; layerIdx < layers.size(); ++layerIdx)
+    {
+        isAnyLayerConnected |= outputPins[layerIdx].hasEdge();
+    }
+
+    if (!isAnyLayerConnected)
+    {
+        return;
+    }
+
+    const glm::ivec2 resolution = reader.getResolution();
+    const ImageRegion region = ImageRegion::fromResolution(resolution);
+
+    // every channel is decoded in a single pass over the file, then each connected layer is copied out separately
+    if (!reader.decode(region))
+    {
+        return;
+    }
+
+    const int proxyFactor = 1 << nodeEvaluator->getProxyLevel();
+
+    HostImage host_image;
+
+    for (int layerIdx = 0; layerIdx < layers.size(); ++layerIdx)
+    {
+        Pin& outputPin = outputPins[layerIdx];
+        if (!outputPin.hasEdge())
+        {
+            continue;
+        }
+
+        const Layer& layer = layers[layerIdx];
+
+        Texture* outTex;
+        if (layer.channelIdxs.size() == 1)
+        {
+            host_image.allocate(resolution, 1);
+            reader.copyChannels(layer.channelIdxs, { 0.f }, region, false, host_image.pixels.get());
+            host_image.downsample(proxyFactor);
+
+            outTex = nodeEvaluator->requestTexture<TextureType::SINGLE>(host_image.resolution);
+            CUDA_CHECK(cudaMemcpy(outTex->getDevPixels<TextureType::SINGLE>(), host_image.pixels.get(), outTex->getNumPixels() * sizeof(float), cudaMemcpyHostToDevice));
+        }
+        else
+        {
+            host_image.allocate(resolution, 4);
+            reader.copyChannels(layer.channelIdxs, { 0.f, 0.f, 0.f, 1.f }, region, false, host_image.pixels.get());
+            host_image.downsample(proxyFactor);
+
+            outTex = nodeEvaluator->requestTexture<TextureType::MULTI>(host_image.resolution);
+            CUDA_CHECK(cudaMemcpy(outTex->getDevPixels<TextureType::MULTI>(), host_image.pixels.get(), outTex->getNumPixels() * 4 * sizeof(float), cudaMemcpyHostToDevice));
+        }
+
+        outputPin.propagateTexture(outTex);
+    }
+
+    reader.freeImage(); // output pins are cached, so the decoded channels won't be needed again until the node changes
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "nodes/node.hpp"
+#include "image_io/image_reader.hpp"
+
+class NodeExrInput : public Node
+{
+private:
+    static constexpr int maxNumLayers = 16;
+
+    struct Layer
+    {
+        std::string name;
+        std::vector<int> channelIdxs; // one entry for single channel layers, otherwise RGBA (-1 for missing components)
+    };
+
+    std::string filePath;
+    std::string openedFilePath; // the file is opened when parameters are snapshotted so pins never change mid-evaluation
+
+    ExrReader reader; // header is parsed once when the file is picked and reused for every evaluation
+    std::vector<Layer> layers;
+
+public:
+    NodeExrInput();
+
+protected:
+    unsigned int getTitleBarColor() const override;
+    unsigned int getTitleBarHoveredColor() const override;
+
+    bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
+
+private:
+    void openFile();
+    void buildLayers();
+
+protected:
+    void _evaluate() override;
+};
@@ -1,10 +1,7 @@
 #include "node_fileinput.hpp"
 
 #include "cuda_includes.hpp"
-
-#include "stb_image.h"
-#include "tinyexr.h"
-#include <filesystem>
+#include "image_io/image_reader.hpp"
 
 std::vector<const char*> NodeFileInput::colorSpaceOptions = { "linear", "sRGB" };
 
@@ -14,8 +11,11 @@ NodeFileInput::NodeFileInput()
     addPin(PinType::OUTPUT, "image");
 
     addPin(PinType::INPUT, "color space").setNoConnect();
+    addPin(PinType::INPUT, "crop origin").setNoConnect();
+    addPin(PinType::INPUT, "crop size").setNoConnect();
 
     setExpensive();
+    setNeedsFullImage(); // decoding is the expensive part, so the whole image is uploaded and cached once
 }
 
 unsigned int NodeFileInput::getTitleBarColor() const
@@ -28,6 +28,16 @@ unsigned int NodeFileInput::getTitleBarHoveredColor() const
     return IM_COL32(47, 153, 53, 255);
 }
 
+bool NodeFileInput::drawPinBeforeExtras(const Pin* pin, int pinNumber)
+{
+    if (pin->pinType == PinType::INPUT && pinNumber == 1) // crop origin
+    {
+        return NodeUI::Checkbox(constParams.crop, "crop");
+    }
+
+    return false;
+}
+
 bool NodeFileInput::drawPinExtras(const Pin* pin, int pinNumber)
 {
     ImGui::SameLine();
@@ -38,6 +48,20 @@ bool NodeFileInput::drawPinExtras(const Pin* pin, int pinNumber)
         {
         case 0: // color space
             return NodeUI::Dropdown(selectedColorSpace, colorSpaceOptions);
+        case 1: // crop origin
+        {
+            bool didParameterChange = NodeUI::IntEdit(constParams.cropOrigin.x, 1.f, 0, INT_MAX);
+            ImGui::SameLine();
+            didParameterChange |= NodeUI::IntEdit(constParams.cropOrigin.y, 1.f, 0, INT_MAX);
+            return didParameterChange && constParams.crop;
+        }
+        case 2: // crop size
+        {
+            bool didParameterChange = NodeUI::IntEdit(constParams.cropSize.x, 1.f, 1, INT_MAX);
+            ImGui::SameLine();
+            didParameterChange |= NodeUI::IntEdit(constParams.cropSize.y, 1.f, 1, INT_MAX);
+            return didParameterChange && constParams.crop;
+        }
         default:
             throw std::runtime_error("invalid pin number");
         }
@@ -65,80 +89,74 @@ bool NodeFileInput::drawPinExtras(const Pin* pin, int pinNumber)
     return false;
 }
 
-__global__ void kernSrgbToLinear(Texture tex)
+bool NodeFileInput::isFileExr() const
+{
+    return ImageReader::isExr(filePath);
+}
+
+ImageReadOptions NodeFileInput::getReadOptions() const
 {
-    const int idx = (blockIdx.x * blockDim.x) + threadIdx.x;
+    ImageReadOptions options;
+    options.srgbToLinear = selectedColorSpace == 1;
 
-    if (idx >= tex.getNumPixels())
+    if (constParams.crop)
     {
-        return;
+        options.region = { constParams.cropOrigin, constParams.cropOrigin + constParams.cropSize };
     }
 
-    tex.setColor<TextureType::MULTI>(idx, ColorUtils::srgbToLinear(tex.getColor<TextureType::MULTI>(idx)));
+    return options;
 }
 
-bool NodeFileInput::isFileExr() const
+void NodeFileInput::snapshotParameters()
 {
-    return std::filesystem::path(filePath).extension().string() == ".exr";
+    evalFilePath = filePath;
+    evalReadOptions = getReadOptions();
 }
 
-void NodeFileInput::_evaluate()
+bool NodeFileInput::hashParameters(Hasher& hasher) const
 {
-    bool isExr = isFileExr();
-
-    float* host_pixels = nullptr;
-    int width, height;
-    if (isExr)
+    if (sequenceFrame.pixels != nullptr)
     {
-        const char* err = nullptr;
-
-        int ret = LoadEXR(&host_pixels, &width, &height, filePath.c_str(), &err);
-
-        if (ret != TINYEXR_SUCCESS)
-        {
-            if (err)
-            {
-                fprintf(stderr, "ERR : %s\n", err);
-                FreeEXRErrorMessage(err);
-            }
-
-            return;
-        }
+        return false; // every frame is different and never comes back
     }
-    else
-    {
-        stbi_ldr_to_hdr_gamma(selectedColorSpace == 0 ? 1.0f : 2.2f); // 1.0f if linear, 2.2f if sRGB
 
-        int channels;
-        host_pixels = stbi_loadf(filePath.c_str(), &width, &height, &channels, 4);
-    }
-
-    if (host_pixels == nullptr)
+    hasher.add(evalFilePath).add(evalReadOptions.region).add(evalReadOptions.srgbToLinear);
+    for (const auto& channel : evalReadOptions.channels)
     {
-        return;
+        hasher.add(channel);
     }
+    return true;
+}
 
-    glm::ivec2 resolution = glm::ivec2(width, height);
-    int numPixels = width * height;
+void NodeFileInput::setSequenceFrame(HostImage&& image)
+{
+    this->sequenceFrame = std::move(image);
+}
 
-    Texture* outTex = nodeEvaluator->requestTexture<TextureType::MULTI>(resolution);
-    CUDA_CHECK(cudaMemcpy(outTex->getDevPixels<TextureType::MULTI>(), host_pixels, numPixels * 4 * sizeof(float), cudaMemcpyHostToDevice));
+void NodeFileInput::clearSequenceFrame()
+{
+    this->sequenceFrame = HostImage();
+}
 
-    if (isExr)
+void NodeFileInput::_evaluate()
+{
+    // decoding, cropping, and color space conversion all happen on the CPU so only the final pixels are uploaded
+    HostImage host_image;
+    const HostImage* image = &sequenceFrame;
+    if (sequenceFrame.pixels == nullptr)
     {
-        free(host_pixels);
-
-        if (selectedColorSpace == 1) // sRGB
+        if (!ImageReader::readImage(evalFilePath, evalReadOptions, host_image))
         {
-            const dim3 blockSize(DEFAULT_BLOCK_SIZE_1D);
-            const dim3 blocksPerGrid = calculateNumBlocksPerGrid(outTex->getNumPixels(), blockSize);
-            kernSrgbToLinear<<<blocksPerGrid, blockSize>>>(*outTex);
+            return;
         }
+
+        // proxy evaluation still decodes at full resolution, but only the downsampled pixels are uploaded
+        host_image.downsample(1 << nodeEvaluator->getProxyLevel());
+        image = &host_image;
     }
-    else
-    {
-        stbi_image_free(host_pixels);
-    }
+
+    Texture* outTex = nodeEvaluator->requestTexture<TextureType::MULTI>(image->resolution);
+    CUDA_CHECK(cudaMemcpy(outTex->getDevPixels<TextureType::MULTI>(), image->pixels.get(), outTex->getNumPixels() * 4 * sizeof(float), cudaMemcpyHostToDevice));
 
     outputPins[0].propagateTexture(outTex);
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "nodes/node.hpp"
+#include "image_io/image_reader.hpp"
 
 class NodeFileInput : public Node
 {
@@ -10,14 +11,35 @@ private:
     static std::vector<const char*> colorSpaceOptions;
     int selectedColorSpace{ 0 }; // linear
 
+    struct
+    {
+        bool crop{ false };
+        glm::ivec2 cropOrigin{ 0, 0 };
+        glm::ivec2 cropSize{ 512, 512 };
+    } constParams;
+
+    // copies of the above read during evaluation
+    std::string evalFilePath;
+    ImageReadOptions evalReadOptions;
+
+    HostImage sequenceFrame; // while processing a sequence, frames are decoded ahead of time instead of reading filePath
+
 public:
     NodeFileInput();
 
+    ImageReadOptions getReadOptions() const;
+
+    void setSequenceFrame(HostImage&& image);
+    void clearSequenceFrame();
+
 protected:
     unsigned int getTitleBarColor() const override;
     unsigned int getTitleBarHoveredColor() const override;
 
+    bool drawPinBeforeExtras(const Pin* pin, int pinNumber) override;
     bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
 
 private:
     bool isFileExr() const;
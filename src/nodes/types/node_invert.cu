@@ -8,6 +8,15 @@ NodeInvert::NodeInvert()
     addPin(PinType::OUTPUT, "image");
 
     addPin(PinType::INPUT, "image");
+
+    setInPlace();
+    setReadsProceduralInputs();
+}
+
+// channels are inverted independently and alpha passes through, so only the demanded channels are read
+uint8_t NodeInvert::getInputChannelDemand(int inputPinIdx) const
+{
+    return outputPins[0].getChannelDemand();
 }
 
 __host__ __device__ glm::vec4 invertCol(glm::vec4 col)
@@ -15,16 +24,18 @@ __host__ __device__ glm::vec4 invertCol(glm::vec4 col)
     return glm::vec4(1.f - glm::vec3(col), col.a);
 }
 
-__global__ void kernInvert(Texture inTex, Texture outTex)
+template<TextureKind inKind>
+__global__ void kernInvert(Texture inTex, Texture outTex, ImageRegion region)
 {
-    const int idx = (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
 
-    if (idx >= inTex.getNumPixels())
+    if (x >= region.max.x || y >= region.max.y)
     {
         return;
     }
 
-    outTex.setColor<TextureType::MULTI>(idx, invertCol(inTex.getColor<TextureType::MULTI>(idx)));
+    outTex.storeColor<TextureType::MULTI>(x, y, invertCol(inTex.fetchColor<inKind, TextureType::MULTI>(x, y)));
 }
 
 bool NodeInvert::drawPinExtras(const Pin* pin, int pinNumber)
@@ -44,9 +55,20 @@ bool NodeInvert::drawPinExtras(const Pin* pin, int pinNumber)
     }
 }
 
+void NodeInvert::snapshotParameters()
+{
+    evalParams = constParams;
+}
+
+bool NodeInvert::hashParameters(Hasher& hasher) const
+{
+    hasher.add(evalParams.color);
+    return true;
+}
+
 void NodeInvert::_evaluate()
 {
-    Texture* inTex = getPinTextureOrUniformColor(inputPins[0], ColorUtils::srgbToLinear(constParams.color));
+    Texture* inTex = getPinTextureOrUniformColor(inputPins[0], ColorUtils::srgbToLinear(evalParams.color));
 
     if (inTex->isUniform())
     {
@@ -56,11 +78,14 @@ void NodeInvert::_evaluate()
         return;
     }
 
-    Texture* outTex = nodeEvaluator->requestTexture<TextureType::MULTI>(inTex->resolution);
+    Texture* outTex = requestOutputTexture(inTex, TextureType::MULTI);
 
-    const dim3 blockSize(DEFAULT_BLOCK_SIZE_1D);
-    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(inTex->getNumPixels(), blockSize);
-    kernInvert<<<blocksPerGrid, blockSize>>>(*inTex, *outTex);
+    const ImageRegion region = getEvaluationRegion(outTex->resolution);
+    const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(region, blockSize);
+    Texture::dispatchKinds([&](auto inKind) {
+        kernInvert<decltype(inKind)::value><<<blocksPerGrid, blockSize>>>(*inTex, *outTex, region);
+    }, *inTex);
 
     outputPins[0].propagateTexture(outTex);
 }
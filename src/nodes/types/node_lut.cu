@@ -2,9 +2,15 @@
 
 #include "cuda_includes.hpp"
 
+#include "thread_utils.hpp"
+
+#include <charconv>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <iterator>
+
+static constexpr int minLinesPerThread = 4096;
 
 NodeLUT::NodeLUT()
     : Node("LUT")
@@ -13,6 +19,8 @@ NodeLUT::NodeLUT()
 
     addPin(PinType::INPUT, "image");
     addPin(PinType::INPUT, "LUT").setNoConnect();
+
+    setInPlace();
 }
 
 NodeLUT::~NodeLUT()
@@ -52,7 +60,7 @@ void NodeLUT::reloadFile()
 {
     freeTextureArray(); // TODO: keep array if LUT size is the same
 
-    std::ifstream file(filePath);
+    std::ifstream file(evalFilePath);
     int lutSize = 0;
 
     if (!file.is_open())
@@ -81,21 +89,59 @@ void NodeLUT::reloadFile()
 
     const int numEntries = lutSize * lutSize * lutSize;
 
+    // the rest of the file is mostly "r g b" lines, split into lines first so they can be parsed in parallel
+    const std::string entriesText(std::istreambuf_iterator<char>(file), {});
+    file.close();
+
+    std::vector<size_t> lineStarts{ 0 };
+    for (size_t pos = entriesText.find('\n'); pos != std::string::npos; pos = entriesText.find('\n', pos + 1))
+    {
+        lineStarts.push_back(pos + 1);
+    }
+    lineStarts.push_back(entriesText.size() + 1);
+
+    const int numLines = lineStarts.size() - 1;
+    std::vector<glm::vec3> lineEntries(numLines);
+    std::vector<char> isEntryLine(numLines);
+    ThreadUtils::parallelFor(0, numLines, [&](int lineBegin, int lineEnd)
+    {
+        for (int lineIdx = lineBegin; lineIdx < lineEnd; ++lineIdx)
+        {
+            const char* ptr = entriesText.data() + lineStarts[lineIdx];
+            const char* end = entriesText.data() + lineStarts[lineIdx + 1] - 1;
+
+            glm::vec3 entry;
+            int numValues = 0;
+            for (; numValues < 3; ++numValues)
+            {
+                while (ptr < end && (*ptr == ' ' || *ptr == '\t'))
+                {
+                    ++ptr;
+                }
+
+                const auto result = std::from_chars(ptr, end, entry[numValues]);
+                if (result.ec != std::errc())
+                {
+                    break;
+                }
+                ptr = result.ptr;
+            }
+
+            lineEntries[lineIdx] = entry;
+            isEntryLine[lineIdx] = numValues == 3;
+        }
+    }, minLinesPerThread);
+
     std::vector<glm::vec3> host_lut;
     host_lut.reserve(numEntries);
-
-    float r, g, b;
-    while (std::getline(file, line))
+    for (int lineIdx = 0; lineIdx < numLines; ++lineIdx)
     {
-        std::istringstream iss(line);
-        if (iss >> r >> g >> b)
+        if (isEntryLine[lineIdx])
         {
-            host_lut.push_back(glm::vec3(r, g, b));
+            host_lut.push_back(lineEntries[lineIdx]);
         }
     }
 
-    file.close();
-
     assert(host_lut.size() == numEntries);
 
     glm::vec3* dev_lut;
@@ -150,41 +196,51 @@ bool NodeLUT::drawPinExtras(const Pin* pin, int pinNumber)
 
     ImGui::SameLine();
 
-    bool didParameterChange;
     switch (pinNumber)
     {
     case 0: // image
         return false;
     case 1: // LUT
-        didParameterChange = NodeUI::FilePicker(&filePath, { "Cube LUTs (.cube)", "*.cube" });
-        break;
+        return NodeUI::FilePicker(&filePath, { "Cube LUTs (.cube)", "*.cube" });
     default:
         throw std::runtime_error("invalid pin number");
     }
+}
 
-    if (didParameterChange)
+void NodeLUT::snapshotParameters()
+{
+    if (evalFilePath != filePath)
     {
-        needsReloadFile = true;
+        evalFilePath = filePath;
+        needsReloadFile = true; // the file is read on the next evaluation
     }
-    return didParameterChange;
 }
 
-__global__ void kernApplyLUT(Texture inTex, Texture outTex, cudaTextureObject_t lutTex)
+bool NodeLUT::hashParameters(Hasher& hasher) const
 {
-    const int idx = (blockIdx.x * blockDim.x) + threadIdx.x;
+    hasher.add(evalFilePath);
+    return true;
+}
 
-    if (idx >= inTex.getNumPixels())
+__global__ void kernApplyLUT(Texture inTex, Texture outTex, cudaTextureObject_t lutTex, ImageRegion region)
+{
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
+
+    if (x >= region.max.x || y >= region.max.y)
     {
         return;
     }
 
+    const int idx = y * inTex.resolution.x + x;
+
     glm::vec4 inColLinear = inTex.getColor<TextureType::MULTI>(idx);
 
     glm::vec3 inColSrgb = ColorUtils::linearToSrgb(glm::vec3(inColLinear));
     float4 lutColSrgb = tex3D<float4>(lutTex, inColSrgb.x, inColSrgb.y, inColSrgb.z);
     glm::vec3 outColLinear = ColorUtils::srgbToLinear(glm::vec3(lutColSrgb.x, lutColSrgb.y, lutColSrgb.z));
 
-    outTex.setColor<TextureType::MULTI>(idx, glm::vec4(outColLinear, inColLinear.a));
+    outTex.storeColor<TextureType::MULTI>(x, y, glm::vec4(outColLinear, inColLinear.a));
 }
 
 void NodeLUT::_evaluate()
@@ -205,12 +261,13 @@ void NodeLUT::_evaluate()
         return;
     }
 
-    Texture* outTex = nodeEvaluator->requestTexture<TextureType::MULTI>(inTex->resolution);
+    Texture* outTex = requestOutputTexture(inTex, TextureType::MULTI);
 
-    const dim3 blockSize(DEFAULT_BLOCK_SIZE_1D);
-    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(inTex->getNumPixels(), blockSize);
+    const ImageRegion region = getEvaluationRegion(outTex->resolution);
+    const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(region, blockSize);
     kernApplyLUT<<<blocksPerGrid, blockSize>>>(
-        *inTex, *outTex, lutTexObj
+        *inTex, *outTex, lutTexObj, region
     );
 
     outputPins[0].propagateTexture(outTex);
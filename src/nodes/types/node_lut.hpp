@@ -6,6 +6,7 @@ class NodeLUT : public Node
 {
 private:
     std::string filePath;
+    std::string evalFilePath; // copy of filePath read during evaluation
 
     cudaArray_t lutArray{ nullptr };
     cudaTextureObject_t lutTexObj;
@@ -22,5 +23,7 @@ private:
 
 protected:
     bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
     void _evaluate() override;
 };
@@ -12,6 +12,9 @@ NodeMapRange::NodeMapRange()
     addPin(PinType::INPUT, "old max").setNoConnect();
     addPin(PinType::INPUT, "new min").setNoConnect();
     addPin(PinType::INPUT, "new max").setNoConnect();
+
+    setInPlace();
+    setReadsProceduralInputs();
 }
 
 bool NodeMapRange::drawPinBeforeExtras(const Pin* pin, int pinNumber)
@@ -53,6 +56,18 @@ bool NodeMapRange::drawPinExtras(const Pin* pin, int pinNumber)
     }
 }
 
+void NodeMapRange::snapshotParameters()
+{
+    evalParams = constParams;
+}
+
+bool NodeMapRange::hashParameters(Hasher& hasher) const
+{
+    hasher.add(evalParams.clamp).add(evalParams.value);
+    hasher.add(evalParams.oldMin).add(evalParams.oldMax).add(evalParams.newMin).add(evalParams.newMax);
+    return true;
+}
+
 __host__ __device__ float mapRange(float v, float oldMin, float oldMax, float newMin, float newMax, bool clamp)
 {
     float denom = oldMax - oldMin;
@@ -70,33 +85,35 @@ __host__ __device__ float mapRange(float v, float oldMin, float oldMax, float ne
     return v;
 }
 
-__global__ void kernMapRange(Texture inTex, Texture outTex, float oldMin, float oldMax, float newMin, float newMax, bool clamp)
+template<TextureKind inKind>
+__global__ void kernMapRange(Texture inTex, Texture outTex, float oldMin, float oldMax, float newMin, float newMax, bool clamp, ImageRegion region)
 {
-    const int idx = (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
 
-    if (idx >= inTex.getNumPixels())
+    if (x >= region.max.x || y >= region.max.y)
     {
         return;
     }
 
-    float outValue = mapRange(inTex.getColor<TextureType::SINGLE>(idx), oldMin, oldMax, newMin, newMax, clamp);
-    outTex.setColor<TextureType::SINGLE>(idx, outValue);
+    float outValue = mapRange(inTex.fetchColor<inKind, TextureType::SINGLE>(x, y), oldMin, oldMax, newMin, newMax, clamp);
+    outTex.storeColor<TextureType::SINGLE>(x, y, outValue);
 }
 
 void NodeMapRange::_evaluate()
 {
-    Texture* inTex = getPinTextureOrUniformColor(inputPins[0], constParams.value);
+    Texture* inTex = getPinTextureOrUniformColor(inputPins[0], evalParams.value);
 
     if (inTex->isUniform())
     {
         Texture* outTex = nodeEvaluator->requestUniformTexture();
 
-        const float inValue = constParams.value;
+        const float inValue = evalParams.value;
         float outValue = mapRange(
             inValue,
-            constParams.oldMin, constParams.oldMax,
-            constParams.newMin, constParams.newMax,
-            constParams.clamp
+            evalParams.oldMin, evalParams.oldMax,
+            evalParams.newMin, evalParams.newMax,
+            evalParams.clamp
         );
         outTex->setUniformColor(outValue);
 
@@ -104,16 +121,20 @@ void NodeMapRange::_evaluate()
         return;
     }
 
-    Texture* outTex = nodeEvaluator->requestTexture<TextureType::SINGLE>(inTex->resolution);
-
-    const dim3 blockSize(DEFAULT_BLOCK_SIZE_1D);
-    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(inTex->getNumPixels(), blockSize);
-    kernMapRange<<<blocksPerGrid, blockSize>>>(
-        *inTex, *outTex, 
-        constParams.oldMin, constParams.oldMax,
-        constParams.newMin, constParams.newMax,
-        constParams.clamp
-    );
+    Texture* outTex = requestOutputTexture(inTex, TextureType::SINGLE);
+
+    const ImageRegion region = getEvaluationRegion(outTex->resolution);
+    const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(region, blockSize);
+    Texture::dispatchKinds([&](auto inKind) {
+        kernMapRange<decltype(inKind)::value><<<blocksPerGrid, blockSize>>>(
+            *inTex, *outTex,
+            evalParams.oldMin, evalParams.oldMax,
+            evalParams.newMin, evalParams.newMax,
+            evalParams.clamp,
+            region
+        );
+    }, *inTex);
 
     outputPins[0].propagateTexture(outTex);
 }
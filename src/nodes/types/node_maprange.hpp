@@ -14,6 +14,7 @@ private:
         float newMin{ 0.f };
         float newMax{ 1.f };
     } constParams;
+    decltype(constParams) evalParams; // copy of constParams read during evaluation
 
 public:
     NodeMapRange();
@@ -21,5 +22,7 @@ public:
 protected:
     bool drawPinBeforeExtras(const Pin* pin, int pinNumber) override;
     bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
     void _evaluate() override;
 };
@@ -19,6 +19,8 @@ NodeMath::NodeMath()
 
     addPin(PinType::INPUT, "input a").setSingleChannel();
     addPin(PinType::INPUT, "input b").setSingleChannel();
+
+    setReadsProceduralInputs();
 }
 
 bool NodeMath::drawPinBeforeExtras(const Pin* pin, int pinNumber)
@@ -59,62 +61,91 @@ bool NodeMath::drawPinExtras(const Pin* pin, int pinNumber)
     }
 }
 
-__host__ __device__ float performOperation(float inputA, float inputB, Operation operation)
+void NodeMath::snapshotParameters()
+{
+    evalParams = constParams;
+}
+
+bool NodeMath::hashParameters(Hasher& hasher) const
+{
+    hasher.add(evalParams.operationNamePtr->operation).add(evalParams.inputA).add(evalParams.inputB);
+    return true;
+}
+
+template<Operation operation>
+__host__ __device__ float performOperation(float inputA, float inputB)
 {
-    switch (operation)
+    if constexpr (operation == Operation::ADD)
     {
-    case Operation::ADD:
         return inputA + inputB;
-    case Operation::SUBTRACT:
+    }
+    else if constexpr (operation == Operation::SUBTRACT)
+    {
         return inputA - inputB;
-    case Operation::MULTIPLY:
+    }
+    else if constexpr (operation == Operation::MULTIPLY)
+    {
         return inputA * inputB;
-    case Operation::DIVIDE:
-        if (inputB == 0.f)
-        {
-            return 0.f;
-        }
-        else
-        {
-            return inputA / inputB;
-        }
-    case Operation::POWER:
+    }
+    else if constexpr (operation == Operation::DIVIDE)
+    {
+        return inputB == 0.f ? 0.f : inputA / inputB;
+    }
+    else if constexpr (operation == Operation::POWER)
+    {
         return powf(inputA, inputB);
-    case Operation::MAX:
+    }
+    else if constexpr (operation == Operation::MAX)
+    {
         return fmaxf(inputA, inputB);
-    case Operation::MIN:
+    }
+    else
+    {
         return fminf(inputA, inputB);
     }
 }
 
-__global__ void kernPerformOperation(Texture inTexA, Texture inTexB, Operation operation, Texture outTex)
+// picks the specialization of f for a runtime operation, once per evaluation
+template<typename F>
+void dispatchOperation(Operation operation, F&& f)
 {
-    const int x = (blockIdx.x * blockDim.x) + threadIdx.x;
-    const int y = (blockIdx.y * blockDim.y) + threadIdx.y;
+    dispatchValue<Operation::ADD, Operation::SUBTRACT, Operation::MULTIPLY, Operation::DIVIDE,
+        Operation::POWER, Operation::MAX, Operation::MIN>(operation, f);
+}
+
+template<TextureKind kindA, TextureKind kindB, Operation operation>
+__global__ void kernPerformOperation(Texture inTexA, Texture inTexB, Texture outTex, ImageRegion region)
+{
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
 
-    if (x >= outTex.resolution.x || y >= outTex.resolution.y)
+    if (x >= region.max.x || y >= region.max.y)
     {
         return;
     }
 
-    float inputA = inTexA.getColorClamp<TextureType::SINGLE>(x, y);
-    float inputB = inTexB.getColorClamp<TextureType::SINGLE>(x, y);
+    float inputA = inTexA.fetchColorClamp<kindA, TextureType::SINGLE>(x, y);
+    float inputB = inTexB.fetchColorClamp<kindB, TextureType::SINGLE>(x, y);
 
-    outTex.setColor<TextureType::SINGLE>(x, y, performOperation(inputA, inputB, operation));
+    outTex.storeColor<TextureType::SINGLE>(x, y, performOperation<operation>(inputA, inputB));
 }
 
 void NodeMath::_evaluate()
 {
-    Texture* inTexA = getPinTextureOrUniformColor(inputPins[0], constParams.inputA);
-    Texture* inTexB = getPinTextureOrUniformColor(inputPins[1], constParams.inputB);
+    Texture* inTexA = getPinTextureOrUniformColor(inputPins[0], evalParams.inputA);
+    Texture* inTexB = getPinTextureOrUniformColor(inputPins[1], evalParams.inputB);
 
-    Operation operation = constParams.operationNamePtr->operation;
+    Operation operation = evalParams.operationNamePtr->operation;
 
     if (inTexA->isUniform() && inTexB->isUniform())
     {
         float inputA = inTexA->getUniformColor<TextureType::SINGLE>();
         float inputB = inTexB->getUniformColor<TextureType::SINGLE>();
-        float result = performOperation(inputA, inputB, operation);
+
+        float result;
+        dispatchOperation(operation, [&](auto op) {
+            result = performOperation<decltype(op)::value>(inputA, inputB);
+        });
 
         Texture* outTex = nodeEvaluator->requestUniformTexture();
         outTex->setUniformColor(result);
@@ -134,9 +165,14 @@ void NodeMath::_evaluate()
 
     Texture* outTex = nodeEvaluator->requestTexture<TextureType::SINGLE>(outRes);
 
+    const ImageRegion region = getEvaluationRegion(outRes);
     const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
-    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(outRes, blockSize);
-    kernPerformOperation<<<blocksPerGrid, blockSize>>>(*inTexA, *inTexB, operation, *outTex);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(region, blockSize);
+    Texture::dispatchKinds([&](auto kindA, auto kindB) {
+        dispatchOperation(operation, [&](auto op) {
+            kernPerformOperation<decltype(kindA)::value, decltype(kindB)::value, decltype(op)::value><<<blocksPerGrid, blockSize>>>(*inTexA, *inTexB, *outTex, region);
+        });
+    }, *inTexA, *inTexB);
 
     outputPins[0].propagateTexture(outTex);
 }
@@ -30,6 +30,7 @@ private:
         float inputA{ 0.5f };
         float inputB{ 0.5f };
     } constParams;
+    decltype(constParams) evalParams; // copy of constParams read during evaluation
 
 public:
     NodeMath();
@@ -37,5 +38,7 @@ public:
 protected:
     bool drawPinBeforeExtras(const Pin* pin, int pinNumber) override;
     bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
     void _evaluate() override;
 };
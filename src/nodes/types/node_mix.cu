@@ -10,6 +10,8 @@ NodeMix::NodeMix()
     addPin(PinType::INPUT, "factor").setSingleChannel();
     addPin(PinType::INPUT, "image 1");
     addPin(PinType::INPUT, "image 2");
+
+    setReadsProceduralInputs();
 }
 
 bool NodeMix::drawPinBeforeExtras(const Pin* pin, int pinNumber)
@@ -45,6 +47,40 @@ bool NodeMix::drawPinExtras(const Pin* pin, int pinNumber)
     }
 }
 
+void NodeMix::snapshotParameters()
+{
+    evalParams = constParams;
+}
+
+bool NodeMix::hashParameters(Hasher& hasher) const
+{
+    hasher.add(evalParams.clamp).add(evalParams.factor).add(evalParams.color1).add(evalParams.color2);
+    return true;
+}
+
+// a uniform factor of exactly 0 or 1 only reads one of the images
+bool NodeMix::isInputNeeded(int inputPinIdx) const
+{
+    float factor;
+    if (inputPinIdx == 0 || !getUniformInput(inputPins[0], evalParams.factor, factor))
+    {
+        return true;
+    }
+
+    if (evalParams.clamp)
+    {
+        factor = glm::clamp(factor, 0.f, 1.f);
+    }
+
+    return inputPinIdx == 1 ? factor != 1.f : factor != 0.f;
+}
+
+// images are mixed channel by channel, the factor is read as luminance
+uint8_t NodeMix::getInputChannelDemand(int inputPinIdx) const
+{
+    return inputPinIdx == 0 ? Node::getInputChannelDemand(inputPinIdx) : outputPins[0].getChannelDemand();
+}
+
 __host__ __device__ glm::vec4 mixCols(glm::vec4 col1, glm::vec4 col2, float factor, bool clamp)
 {
     if (clamp)
@@ -54,29 +90,30 @@ __host__ __device__ glm::vec4 mixCols(glm::vec4 col1, glm::vec4 col2, float fact
     return glm::mix(col1, col2, factor);
 }
 
-__global__ void kernMix(Texture inTex1, Texture inTex2, Texture inTexFactor, bool clamp, Texture outTex)
+template<TextureKind kind1, TextureKind kind2, TextureKind kindFactor>
+__global__ void kernMix(Texture inTex1, Texture inTex2, Texture inTexFactor, bool clamp, Texture outTex, ImageRegion region)
 {
-    const int x = (blockIdx.x * blockDim.x) + threadIdx.x;
-    const int y = (blockIdx.y * blockDim.y) + threadIdx.y;
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
 
-    if (x >= outTex.resolution.x || y >= outTex.resolution.y)
+    if (x >= region.max.x || y >= region.max.y)
     {
         return;
     }
 
-    glm::vec4 col1 = inTex1.getColorClamp<TextureType::MULTI>(x, y);
-    glm::vec4 col2 = inTex2.getColorClamp<TextureType::MULTI>(x, y);
-    float factor = inTexFactor.getColorClamp<TextureType::SINGLE>(x, y);
+    glm::vec4 col1 = inTex1.fetchColorClamp<kind1, TextureType::MULTI>(x, y);
+    glm::vec4 col2 = inTex2.fetchColorClamp<kind2, TextureType::MULTI>(x, y);
+    float factor = inTexFactor.fetchColorClamp<kindFactor, TextureType::SINGLE>(x, y);
 
-    outTex.setColor<TextureType::MULTI>(x, y, mixCols(col1, col2, factor, clamp));
+    outTex.storeColor<TextureType::MULTI>(x, y, mixCols(col1, col2, factor, clamp));
 }
 
 // should work for differing resolutions but that hasn't been tested yet
 void NodeMix::_evaluate()
 {
-    Texture* inTexFactor = getPinTextureOrUniformColor(inputPins[0], constParams.factor);
-    Texture* inTex1 = getPinTextureOrUniformColor(inputPins[1], ColorUtils::srgbToLinear(constParams.color1));
-    Texture* inTex2 = getPinTextureOrUniformColor(inputPins[2], ColorUtils::srgbToLinear(constParams.color2));
+    Texture* inTexFactor = getPinTextureOrUniformColor(inputPins[0], evalParams.factor);
+    Texture* inTex1 = getPinTextureOrUniformColor(inputPins[1], ColorUtils::srgbToLinear(evalParams.color1));
+    Texture* inTex2 = getPinTextureOrUniformColor(inputPins[2], ColorUtils::srgbToLinear(evalParams.color2));
 
     if (inTex1->isUniform() && inTex2->isUniform() && inTexFactor->isUniform())
     {
@@ -85,7 +122,7 @@ void NodeMix::_evaluate()
             inTex1->getUniformColor<TextureType::MULTI>(),
             inTex2->getUniformColor<TextureType::MULTI>(),
             inTexFactor->getUniformColor<TextureType::SINGLE>(),
-            constParams.clamp
+            evalParams.clamp
         ));
 
         outputPins[0].propagateTexture(outTex);
@@ -93,11 +130,16 @@ void NodeMix::_evaluate()
     }
 
     glm::ivec2 outRes = Texture::getFirstResolutionFromList({ inTex1, inTex2, inTexFactor });
-    Texture* outTex = nodeEvaluator->requestTexture<TextureType::MULTI>(outRes);
+    Texture* outTex = requestOutputTexture(outRes, TextureType::MULTI);
 
+    const ImageRegion region = getEvaluationRegion(outRes);
     const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
-    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(outRes, blockSize);
-    kernMix<<<blocksPerGrid, blockSize>>>(*inTex1, *inTex2, *inTexFactor, constParams.clamp, *outTex);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(region, blockSize);
+    Texture::dispatchKinds([&](auto kind1, auto kind2, auto kindFactor) {
+        kernMix<decltype(kind1)::value, decltype(kind2)::value, decltype(kindFactor)::value><<<blocksPerGrid, blockSize>>>(
+            *inTex1, *inTex2, *inTexFactor, evalParams.clamp, *outTex, region
+        );
+    }, *inTex1, *inTex2, *inTexFactor);
 
     outputPins[0].propagateTexture(outTex);
 }
@@ -12,12 +12,18 @@ private:
         glm::vec4 color1{ NodeUI::defaultBackupVec4 };
         glm::vec4 color2{ NodeUI::defaultBackupVec4 };
     } constParams;
+    decltype(constParams) evalParams; // copy of constParams read during evaluation
 
 public:
     NodeMix();
 
+    bool isInputNeeded(int inputPinIdx) const override;
+    uint8_t getInputChannelDemand(int inputPinIdx) const override;
+
 protected:
     bool drawPinBeforeExtras(const Pin* pin, int pinNumber) override;
     bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
     void _evaluate() override;
 };
@@ -2,35 +2,105 @@
 
 #include "cuda_includes.hpp"
 
-#include <glm/gtc/noise.hpp>
-
 NodeNoise::NodeNoise()
     : Node("noise")
 {
     addPin(PinType::OUTPUT, "value").setSingleChannel();
+
+    addPin(PinType::INPUT, "scale").setNoConnect();
+    addPin(PinType::INPUT, "octaves").setNoConnect();
+    addPin(PinType::INPUT, "lacunarity").setNoConnect();
+    addPin(PinType::INPUT, "gain").setNoConnect();
+    addPin(PinType::INPUT, "seed").setNoConnect();
+    addPin(PinType::INPUT, "tile size").setNoConnect();
 }
 
-__global__ void kernNoise(Texture outTex)
+bool NodeNoise::drawPinExtras(const Pin* pin, int pinNumber)
 {
-    const int x = (blockIdx.x * blockDim.x) + threadIdx.x;
-    const int y = (blockIdx.y * blockDim.y) + threadIdx.y;
+    if (pin->pinType == PinType::OUTPUT || pin->hasEdge())
+    {
+        return false;
+    }
 
-    if (x >= outTex.resolution.x || y >= outTex.resolution.y)
+    switch (pinNumber)
     {
-        return;
+    case 0: // scale
+        ImGui::SameLine();
+        return NodeUI::FloatEdit(constParams.scale, 1.f, 1.f, FLT_MAX);
+    case 1: // octaves
+        ImGui::SameLine();
+        return NodeUI::IntEdit(constParams.octaves, 0.05f, 1, maxOctaves);
+    case 2: // lacunarity
+        ImGui::SameLine();
+        return NodeUI::FloatEdit(constParams.lacunarity, 0.01f, 1.f, 8.f);
+    case 3: // gain
+        ImGui::SameLine();
+        return NodeUI::FloatEdit(constParams.gain, 0.01f, 0.f, 1.f);
+    case 4: // seed
+        ImGui::SameLine();
+        return NodeUI::IntEdit(constParams.seed, 0.2f, INT_MIN, INT_MAX);
+    case 5: // tile size
+        ImGui::SameLine();
+        return NodeUI::IntEdit(constParams.tileSize, 1.f, 0, INT_MAX);
+    default:
+        throw std::runtime_error("invalid pin number");
     }
+}
 
-    float noise = glm::simplex(glm::vec2(x, y) * 0.005f);
-    outTex.setColor<TextureType::SINGLE>(x, y, noise);
+void NodeNoise::snapshotParameters()
+{
+    evalParams = constParams;
+}
+
+bool NodeNoise::hashParameters(Hasher& hasher) const
+{
+    hasher.add(evalParams.scale).add(evalParams.octaves).add(evalParams.lacunarity).add(evalParams.gain)
+        .add(evalParams.seed).add(evalParams.tileSize);
+    return true;
 }
 
 void NodeNoise::_evaluate()
 {
-    Texture* outTex = nodeEvaluator->requestTexture<TextureType::SINGLE>();
+    NoiseParams params;
+    params.octaves = evalParams.octaves;
+    params.gain = evalParams.gain;
+    params.seed = (uint32_t)evalParams.seed;
+
+    const bool isTiling = evalParams.tileSize > 0;
+    float fullResFrequency;
+    if (isTiling)
+    {
+        // snap the cell size so a whole number of cells fits in a tile, and every octave then has to scale by a whole number too
+        params.period = glm::max((int)roundf(evalParams.tileSize / evalParams.scale), 1);
+        params.lacunarity = roundf(evalParams.lacunarity);
+        fullResFrequency = params.period / (float)evalParams.tileSize;
+
+        // finer octaves are far below a pixel by the time the period would overflow
+        int64_t finestPeriod = params.period;
+        for (int octave = 1; octave < params.octaves; ++octave)
+        {
+            finestPeriod *= (int64_t)params.lacunarity;
+            if (finestPeriod > INT_MAX)
+            {
+                params.octaves = octave;
+                break;
+            }
+        }
+    }
+    else
+    {
+        params.period = 0;
+        params.lacunarity = evalParams.lacunarity;
+        fullResFrequency = 1.f / evalParams.scale;
+    }
+    params.frequency = fullResFrequency / nodeEvaluator->getResolutionScale(); // proxy pixels cover more of the pattern
 
-    const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
-    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(outTex->resolution, blockSize);
-    kernNoise<<<blocksPerGrid, blockSize>>>(*outTex);
+    // sampled inline by pointwise consumers, so there's nothing to launch here
+    ProceduralFunction function;
+    function.type = isTiling ? ProceduralType::TILED_NOISE : ProceduralType::NOISE;
+    function.noise = params;
+    const glm::ivec2 resolution = nodeEvaluator->getScaledResolution(nodeEvaluator->getOutputResolution());
+    Texture* outTex = nodeEvaluator->requestProcedural(Texture::makeProcedural(function, resolution));
 
     outputPins[0].propagateTexture(outTex);
 }
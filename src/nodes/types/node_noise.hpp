@@ -4,9 +4,26 @@
 
 class NodeNoise : public Node
 {
+private:
+    static constexpr int maxOctaves = 12;
+
+    struct
+    {
+        float scale{ 200.f }; // size of one lattice cell in full resolution pixels
+        int octaves{ 4 };
+        float lacunarity{ 2.f };
+        float gain{ 0.5f };
+        int seed{ 0 };
+        int tileSize{ 0 }; // in full resolution pixels, 0 for no tiling
+    } constParams;
+    decltype(constParams) evalParams; // copy of constParams read during evaluation
+
 public:
     NodeNoise();
 
 protected:
+    bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
     void _evaluate() override;
 };
@@ -6,6 +6,8 @@ NodeOutput::NodeOutput()
     : Node("output")
 {
     addPin(PinType::INPUT, "image");
+
+    setReadsProceduralInputs();
 }
 
 unsigned int NodeOutput::getTitleBarColor() const
@@ -30,39 +32,33 @@ __host__ __device__ glm::vec4 hdrToLdr(glm::vec4 col)
     return glm::vec4(rgb, col.a);
 }
 
-__global__ void kernFillUniformColor(Texture outTex, glm::vec4 col)
+__global__ void kernFillUniformColor(Texture outTex, glm::vec4 col, ImageRegion region)
 {
-    const int idx = (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
 
-    if (idx >= outTex.getNumPixels())
+    if (x >= region.max.x || y >= region.max.y)
     {
         return;
     }
 
-    outTex.setColor<TextureType::MULTI>(idx, col);
+    outTex.storeColor<TextureType::MULTI>(x, y, col);
 }
 
-__global__ void kernCopyToOutTex(Texture inTex, Texture outTex)
+template<TextureKind inKind>
+__global__ void kernCopyToOutTex(Texture inTex, Texture outTex, ImageRegion region)
 {
-    const int x = (blockIdx.x * blockDim.x) + threadIdx.x;
-    const int y = (blockIdx.y * blockDim.y) + threadIdx.y;
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
 
-    if (x >= outTex.resolution.x || y >= outTex.resolution.y)
+    if (x >= region.max.x || y >= region.max.y)
     {
         return;
     }
 
-    glm::vec4 col;
-    if (x >= inTex.resolution.x || y >= inTex.resolution.y)
-    {
-        col = glm::vec4(0, 0, 0, 1);
-    }
-    else
-    {
-        col = hdrToLdr(inTex.getColor<TextureType::MULTI>(x, y));
-    }
-
-    outTex.setColor<TextureType::MULTI>(x, y, col);
+    // pixels past the input read as opaque black, which hdrToLdr() leaves as it is
+    glm::vec4 col = hdrToLdr(inTex.fetchColorClamp<inKind, TextureType::MULTI>(x, y));
+    outTex.storeColor<TextureType::MULTI>(x, y, col);
 }
 
 void NodeOutput::_evaluate()
@@ -77,19 +73,21 @@ void NodeOutput::_evaluate()
 
     Texture* outTex = nodeEvaluator->requestTexture<TextureType::MULTI>();
 
+    const ImageRegion region = getEvaluationRegion(outTex->resolution);
+    const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(region, blockSize);
+
     if (inTex->isUniform())
     {
         glm::vec4 ldrCol = hdrToLdr(inTex->getUniformColor<TextureType::MULTI>());
 
-        const dim3 blockSize(DEFAULT_BLOCK_SIZE_1D);
-        const dim3 blocksPerGrid = calculateNumBlocksPerGrid(outTex->getNumPixels(), blockSize);
-        kernFillUniformColor<<<blocksPerGrid, blockSize>>>(*outTex, ldrCol);
+        kernFillUniformColor<<<blocksPerGrid, blockSize>>>(*outTex, ldrCol, region);
     }
     else
     {
-        const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
-        const dim3 blocksPerGrid = calculateNumBlocksPerGrid(outTex->resolution, blockSize);
-        kernCopyToOutTex<<<blocksPerGrid, blockSize>>>(*inTex, *outTex);
+        Texture::dispatchKinds([&](auto inKind) {
+            kernCopyToOutTex<decltype(inKind)::value><<<blocksPerGrid, blockSize>>>(*inTex, *outTex, region);
+        }, *inTex);
     }
 
     nodeEvaluator->setOutputTexture(outTex);
@@ -3,6 +3,7 @@
 #include "cuda_includes.hpp"
 
 #include "random_utils.hpp"
+#include "thread_utils.hpp"
 #include <thrust/execution_policy.h>
 #include <thrust/sort.h>
 #include <thrust/shuffle.h>
@@ -92,6 +93,7 @@ NodePaintinator::NodePaintinator()
     addPin(PinType::INPUT, "gradient rotation").setNoConnect();
 
     setExpensive();
+    setNeedsFullImage(); // stroke placement and blurring are global
 
     // variety
     constParams.brushParamsMap[&brushTextures[0]] = {
@@ -211,6 +213,24 @@ bool NodePaintinator::drawPinExtras(const Pin* pin, int pinNumber)
     }
 }
 
+void NodePaintinator::snapshotParameters()
+{
+    evalParams = constParams;
+}
+
+bool NodePaintinator::hashParameters(Hasher& hasher) const
+{
+    hasher.add(evalParams.brushTexturePtr);
+
+    // only the selected brush's parameters are used
+    auto it = evalParams.brushParamsMap.find(evalParams.brushTexturePtr);
+    if (it != evalParams.brushParamsMap.end())
+    {
+        hasher.add(it->second);
+    }
+    return true;
+}
+
 __global__ void kernFillEmptyTexture(Texture tex, int numPixels)
 {
     const int idx = (blockIdx.x * blockDim.x) + threadIdx.x;
@@ -495,9 +515,9 @@ void NodePaintinator::_evaluate()
         return;
     }
 
-    if (!constParams.brushTexturePtr->isLoaded)
+    if (!evalParams.brushTexturePtr->isLoaded)
     {
-        constParams.brushTexturePtr->load();
+        evalParams.brushTexturePtr->load();
     }
 
     Texture* outTex = nodeEvaluator->requestTexture<TextureType::MULTI>(inTex->resolution);
@@ -527,7 +547,7 @@ void NodePaintinator::_evaluate()
     const dim3 blockSize2d(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
     const dim3 blocksPerGrid2d = calculateNumBlocksPerGrid(inTex->resolution, blockSize2d);
 
-    const auto& brushParams = constParams.getBrushParams();
+    const auto& brushParams = evalParams.getBrushParams();
 
     const bool usingGradient = (brushParams.gradientRotationFactor != 0.f);
     float* dev_gradientAngles = nullptr;
@@ -539,10 +559,20 @@ void NodePaintinator::_evaluate()
         blocksPerGrid2dSobel = calculateNumBlocksPerGrid(inTex->resolution, blockSize2dSobel);
     }
 
-    float logMinStrokeSize = logf(brushParams.minStrokeSize);
-    float logMaxStrokeSize = logf(brushParams.maxStrokeSize);
+    // stroke sizes are in pixels so they shrink along with proxy resolutions
+    const float resolutionScale = nodeEvaluator->getResolutionScale();
+    float logMinStrokeSize = logf(std::max(brushParams.minStrokeSize * resolutionScale, 1.f));
+    float logMaxStrokeSize = logf(std::max(brushParams.maxStrokeSize * resolutionScale, 1.f));
+    bool wasCancelled = false;
     for (int layerIdx = 0; layerIdx < numLayers; ++layerIdx)
     {
+        // painting can take a while, so an obsolete evaluation stops at the next layer instead of finishing the node
+        if (nodeEvaluator->isCancelRequested())
+        {
+            wasCancelled = true;
+            break;
+        }
+
         // =========================
         // MAKE REFERENCE IMAGE
         // =========================
@@ -621,54 +651,66 @@ void NodePaintinator::_evaluate()
         }
         int halfGridSize = gridSize / 2;
 
-        std::vector<PaintStroke> host_strokes;
-        for (int cellY = 0; cellY < height + halfGridSize; cellY += gridSize)
+        // rows of cells are scanned in parallel and joined in order, so the strokes come out the same as a serial scan
+        const int numCellRows = (height + halfGridSize + gridSize - 1) / gridSize;
+        std::vector<std::vector<PaintStroke>> cellRowStrokes(numCellRows);
+        ThreadUtils::parallelFor(0, numCellRows, [&](int cellRowBegin, int cellRowEnd)
         {
-            for (int cellX = 0; cellX < width + halfGridSize; cellX += gridSize)
+            for (int cellRow = cellRowBegin; cellRow < cellRowEnd; ++cellRow)
             {
-                int xMin = std::max(cellX - halfGridSize, 0);
-                int xMax = std::min(cellX + halfGridSize, width);
-                int yMin = std::max(cellY - halfGridSize, 0);
-                int yMax = std::min(cellY + halfGridSize, height);
+                const int cellY = cellRow * gridSize;
+                for (int cellX = 0; cellX < width + halfGridSize; cellX += gridSize)
+                {
+                    int xMin = std::max(cellX - halfGridSize, 0);
+                    int xMax = std::min(cellX + halfGridSize, width);
+                    int yMin = std::max(cellY - halfGridSize, 0);
+                    int yMax = std::min(cellY + halfGridSize, height);
 
-                int numGridPixels = (xMax - xMin) * (yMax - yMin);
+                    int numGridPixels = (xMax - xMin) * (yMax - yMin);
 
-                // unsure if this is necessary
-                if (numGridPixels == 0)
-                {
-                    continue;
-                }
+                    // unsure if this is necessary
+                    if (numGridPixels == 0)
+                    {
+                        continue;
+                    }
 
-                float totalError = 0.f;
-                float maxError = -FLT_MAX;
-                glm::ivec2 maxErrorPos;
-                for (int y = yMin; y < yMax; ++y)
-                {
-                    for (int x = xMin; x < xMax; ++x)
+                    float totalError = 0.f;
+                    float maxError = -FLT_MAX;
+                    glm::ivec2 maxErrorPos;
+                    for (int y = yMin; y < yMax; ++y)
                     {
-                        float error = host_colorDiff[y * width + x];
-                        totalError += error;
-                        if (error > maxError)
+                        for (int x = xMin; x < xMax; ++x)
                         {
-                            maxError = error;
-                            maxErrorPos = glm::ivec2(x, y);
+                            float error = host_colorDiff[y * width + x];
+                            totalError += error;
+                            if (error > maxError)
+                            {
+                                maxError = error;
+                                maxErrorPos = glm::ivec2(x, y);
+                            }
                         }
                     }
-                }
 
-                float areaError = totalError / numGridPixels;
-                if (areaError < brushParams.newStrokeThreshold)
-                {
-                    continue;
-                }
+                    float areaError = totalError / numGridPixels;
+                    if (areaError < brushParams.newStrokeThreshold)
+                    {
+                        continue;
+                    }
 
-                PaintStroke newStroke;
-                newStroke.pos = maxErrorPos;
-                newStroke.color.x = 1.f / (strokeSize * constParams.brushTexturePtr->scale.x);
-                newStroke.color.y = 1.f / (strokeSize * constParams.brushTexturePtr->scale.y);
-                // transform, color, and cornerUv are set by kernPrepareStrokes
-                host_strokes.push_back(newStroke);
+                    PaintStroke newStroke;
+                    newStroke.pos = maxErrorPos;
+                    newStroke.color.x = 1.f / (strokeSize * evalParams.brushTexturePtr->scale.x);
+                    newStroke.color.y = 1.f / (strokeSize * evalParams.brushTexturePtr->scale.y);
+                    // transform, color, and cornerUv are set by kernPrepareStrokes
+                    cellRowStrokes[cellRow].push_back(newStroke);
+                }
             }
+        });
+
+        std::vector<PaintStroke> host_strokes;
+        for (const auto& strokes : cellRowStrokes)
+        {
+            host_strokes.insert(host_strokes.end(), strokes.begin(), strokes.end());
         }
 
         const int numStrokes = host_strokes.size();
@@ -690,7 +732,7 @@ void NodePaintinator::_evaluate()
         );
 
         kernPaint<<<blocksPerGrid2d, blockSize2d>>>(
-            *outTex, dev_strokes, numStrokes, constParams.brushTexturePtr->lutTexObj, brushParams.brushAlpha
+            *outTex, dev_strokes, numStrokes, evalParams.brushTexturePtr->lutTexObj, brushParams.brushAlpha
         );
     }
 
@@ -702,5 +744,10 @@ void NodePaintinator::_evaluate()
         CUDA_CHECK(cudaFree(dev_gradientAngles));
     }
 
+    if (wasCancelled)
+    {
+        return; // the pin is left uncached so the next evaluation paints from scratch
+    }
+
     outputPins[0].propagateTexture(outTex);
 }
@@ -52,6 +52,7 @@ private:
             return brushParamsMap[brushTexturePtr];
         }
     } constParams;
+    decltype(constParams) evalParams; // copy of constParams read during evaluation
 
     static std::vector<BrushTexture> brushTextures;
 
@@ -70,5 +71,7 @@ protected:
 
     bool drawPinBeforeExtras(const Pin* pin, int pinNumber) override;
     bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
     void _evaluate() override;
 };
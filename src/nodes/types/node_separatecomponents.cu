@@ -22,6 +22,22 @@ NodeSeparateComponents<componentsType>::NodeSeparateComponents(const std::string
     addPin(PinType::INPUT, "image");
 }
 
+// RGB components only need the channels they're views of, HSV needs all three for any of its components
+template<ComponentsType componentsType>
+uint8_t NodeSeparateComponents<componentsType>::getInputChannelDemand(int inputPinIdx) const
+{
+    uint8_t demand = 0;
+    for (int compIdx = 0; compIdx < 3; ++compIdx)
+    {
+        if (outputPins[compIdx].getChannelDemand() != 0)
+        {
+            demand |= componentsType == ComponentsType::RGB ? (uint8_t)(Channels::R << compIdx) : Channels::RGB;
+        }
+    }
+
+    return demand;
+}
+
 template<ComponentsType componentsType>
 bool NodeSeparateComponents<componentsType>::drawPinExtras(const Pin* pin, int pinNumber)
 {
@@ -40,6 +56,19 @@ bool NodeSeparateComponents<componentsType>::drawPinExtras(const Pin* pin, int p
     }
 }
 
+template<ComponentsType componentsType>
+void NodeSeparateComponents<componentsType>::snapshotParameters()
+{
+    evalParams = constParams;
+}
+
+template<ComponentsType componentsType>
+bool NodeSeparateComponents<componentsType>::hashParameters(Hasher& hasher) const
+{
+    hasher.add(evalParams.color);
+    return true;
+}
+
 template<ComponentsType componentsType>
 __host__ __device__ glm::vec3 separateComponents(glm::vec3 color)
 {
@@ -54,15 +83,18 @@ __host__ __device__ glm::vec3 separateComponents(glm::vec3 color)
 }
 
 template<ComponentsType componentsType>
-__global__ void kernSeparateComponents(Texture inTex, Texture outTex1, Texture outTex2, Texture outTex3)
+__global__ void kernSeparateComponents(Texture inTex, Texture outTex1, Texture outTex2, Texture outTex3, ImageRegion region)
 {
-    const int idx = (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
 
-    if (idx >= inTex.getNumPixels())
+    if (x >= region.max.x || y >= region.max.y)
     {
         return;
     }
 
+    const int idx = y * inTex.resolution.x + x;
+
     glm::vec3 inColor = glm::vec3(inTex.getColor<TextureType::MULTI>(idx));
     glm::vec3 components = separateComponents<componentsType>(inColor);
 
@@ -83,7 +115,7 @@ __global__ void kernSeparateComponents(Texture inTex, Texture outTex1, Texture o
 template<ComponentsType componentsType>
 void NodeSeparateComponents<componentsType>::_evaluate()
 {
-    Texture* inTex = getPinTextureOrUniformColor(inputPins[0], ColorUtils::srgbToLinear(constParams.color));
+    Texture* inTex = getPinTextureOrUniformColor(inputPins[0], ColorUtils::srgbToLinear(evalParams.color));
 
     if (inTex->isUniform())
     {
@@ -106,27 +138,64 @@ void NodeSeparateComponents<componentsType>::_evaluate()
         return;
     }
 
+    // RGB components are just the input's channels, so they're handed out as views instead of being copied
+    if constexpr (componentsType == ComponentsType::RGB)
+    {
+        for (int compIdx = 0; compIdx < 3; ++compIdx)
+        {
+            Pin& outputPin = outputPins[compIdx];
+            if (!outputPin.hasEdge())
+            {
+                continue;
+            }
+
+            // a single channel input is its own R, G, and B
+            Texture* outTex = inTex->isType<TextureType::SINGLE>() ? inTex : nodeEvaluator->requestView(inTex->getChannelView(compIdx));
+            outputPin.propagateTexture(outTex);
+        }
+
+        return;
+    }
+
+    int numConnectedOutputs = 0;
+    for (int compIdx = 0; compIdx < 3; ++compIdx)
+    {
+        numConnectedOutputs += outputPins[compIdx].hasEdge() ? 1 : 0;
+    }
+
+    // with more than one output, a single planar texture replaces a texture per component and each component is still contiguous
+    Texture* planarTex = nullptr;
+    if (numConnectedOutputs > 1)
+    {
+        planarTex = nodeEvaluator->requestTexture<TextureType::MULTI, TextureLayout::PLANAR>(inTex->resolution);
+    }
+
     Texture emptyTexture = Texture();
     Texture* outTextures[3];
     for (int compIdx = 0; compIdx < 3; ++compIdx)
     {
         Pin& outputPin = outputPins[compIdx];
-        if (outputPin.hasEdge())
+        if (!outputPin.hasEdge())
         {
-            Texture* outTex = nodeEvaluator->requestTexture<TextureType::SINGLE>(inTex->resolution);
-            outTextures[compIdx] = outTex;
+            outTextures[compIdx] = &emptyTexture;
+        }
+        else if (planarTex != nullptr)
+        {
+            outTextures[compIdx] = nodeEvaluator->requestView(planarTex->getChannelView(compIdx));
         }
         else
         {
-            outTextures[compIdx] = &emptyTexture;
+            outTextures[compIdx] = nodeEvaluator->requestTexture<TextureType::SINGLE>(inTex->resolution);
         }
     }
 
-    const dim3 blockSize(DEFAULT_BLOCK_SIZE_1D);
-    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(inTex->getNumPixels(), blockSize);
+    const ImageRegion region = getEvaluationRegion(inTex->resolution);
+    const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(region, blockSize);
     kernSeparateComponents<componentsType><<<blocksPerGrid, blockSize>>>(
         *inTex,
-        *outTextures[0], *outTextures[1], *outTextures[2]
+        *outTextures[0], *outTextures[1], *outTextures[2],
+        region
     );
 
     for (int compIdx = 0; compIdx < 3; ++compIdx)
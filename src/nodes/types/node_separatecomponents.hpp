@@ -15,11 +15,16 @@ private:
     {
         glm::vec4 color{ NodeUI::defaultBackupVec4 };
     } constParams;
+    decltype(constParams) evalParams; // copy of constParams read during evaluation
 
 public:
     NodeSeparateComponents(const std::string& name);
 
+    uint8_t getInputChannelDemand(int inputPinIdx) const override;
+
 protected:
     bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
     void _evaluate() override;
 };
@@ -11,6 +11,9 @@ NodeToneMapping::NodeToneMapping()
 
     addPin(PinType::INPUT, "image");
     addPin(PinType::INPUT, "tone mapping").setNoConnect();
+
+    setInPlace();
+    setReadsProceduralInputs();
 }
 
 unsigned int NodeToneMapping::getTitleBarColor() const
@@ -42,47 +45,66 @@ bool NodeToneMapping::drawPinExtras(const Pin* pin, int pinNumber)
     }
 }
 
-__host__ __device__ glm::vec4 applyToneMapping(glm::vec4 col, int toneMapping)
+void NodeToneMapping::snapshotParameters()
+{
+    evalToneMapping = selectedToneMapping;
+}
+
+bool NodeToneMapping::hashParameters(Hasher& hasher) const
+{
+    hasher.add(evalToneMapping);
+    return true;
+}
+
+template<int toneMapping>
+__host__ __device__ glm::vec4 applyToneMapping(glm::vec4 col)
 {
     glm::vec3 rgb = glm::max(glm::vec3(col), 0.f);
 
-    switch (toneMapping)
+    if constexpr (toneMapping == 1)
     {
-    case 0:
-        break;
-    case 1:
         rgb = ColorUtils::AgX(rgb, 0);
-        break;
-    case 2:
+    }
+    else if constexpr (toneMapping == 2)
+    {
         rgb = ColorUtils::AgX(rgb, 1);
-        break;
-    case 3:
+    }
+    else if constexpr (toneMapping == 3)
+    {
         rgb = ColorUtils::AgX(rgb, 2);
-        break;
-    case 4:
+    }
+    else if constexpr (toneMapping == 4)
+    {
         rgb = ColorUtils::reinhard(rgb);
-        break;
-    case 5:
+    }
+    else if constexpr (toneMapping == 5)
+    {
         rgb = ColorUtils::ACESFilm(rgb);
-        break;
     }
 
     return glm::vec4(rgb, col.a);
 }
 
-__global__ void kernApplyToneMapping(Texture inTex, int toneMapping, Texture outTex)
+// indices into toneMappingOptions
+template<typename F>
+void dispatchToneMapping(int toneMapping, F&& f)
+{
+    dispatchValue<0, 1, 2, 3, 4, 5>(toneMapping, f);
+}
+
+template<TextureKind inKind, int toneMapping>
+__global__ void kernApplyToneMapping(Texture inTex, Texture outTex, ImageRegion region)
 {
-    const int x = (blockIdx.x * blockDim.x) + threadIdx.x;
-    const int y = (blockIdx.y * blockDim.y) + threadIdx.y;
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
 
-    if (x >= outTex.resolution.x || y >= outTex.resolution.y)
+    if (x >= region.max.x || y >= region.max.y)
     {
         return;
     }
 
-    const int idx = y * inTex.resolution.x + x;
-    glm::vec4 outCol = applyToneMapping(inTex.getColor<TextureType::MULTI>(idx), toneMapping);
-    outTex.setColor<TextureType::MULTI>(idx, outCol);
+    glm::vec4 outCol = applyToneMapping<toneMapping>(inTex.fetchColor<inKind, TextureType::MULTI>(x, y));
+    outTex.storeColor<TextureType::MULTI>(x, y, outCol);
 }
 
 void NodeToneMapping::_evaluate()
@@ -92,16 +114,23 @@ void NodeToneMapping::_evaluate()
     if (inTex->isUniform())
     {
         Texture* outTex = nodeEvaluator->requestUniformTexture();
-        outTex->setUniformColor(applyToneMapping(inTex->getUniformColor<TextureType::MULTI>(), selectedToneMapping));
+        dispatchToneMapping(evalToneMapping, [&](auto toneMapping) {
+            outTex->setUniformColor(applyToneMapping<decltype(toneMapping)::value>(inTex->getUniformColor<TextureType::MULTI>()));
+        });
         outputPins[0].propagateTexture(outTex);
         return;
     }
 
-    Texture* outTex = nodeEvaluator->requestTexture<TextureType::MULTI>(inTex->resolution);
+    Texture* outTex = requestOutputTexture(inTex, TextureType::MULTI);
 
+    const ImageRegion region = getEvaluationRegion(outTex->resolution);
     const dim3 blockSize(DEFAULT_BLOCK_SIZE_2D_X, DEFAULT_BLOCK_SIZE_2D_Y);
-    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(inTex->resolution, blockSize);
-    kernApplyToneMapping<<<blocksPerGrid, blockSize>>>(*inTex, selectedToneMapping, *outTex);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(region, blockSize);
+    Texture::dispatchKinds([&](auto inKind) {
+        dispatchToneMapping(evalToneMapping, [&](auto toneMapping) {
+            kernApplyToneMapping<decltype(inKind)::value, decltype(toneMapping)::value><<<blocksPerGrid, blockSize>>>(*inTex, *outTex, region);
+        });
+    }, *inTex);
 
     outputPins[0].propagateTexture(outTex);
 }
@@ -7,6 +7,7 @@ class NodeToneMapping : public Node
 private:
     static std::vector<const char*> toneMappingOptions;
     int selectedToneMapping{ 1 }; // AgX
+    int evalToneMapping{ 1 }; // copy of selectedToneMapping read during evaluation
 
 public:
     NodeToneMapping();
@@ -16,5 +17,7 @@ protected:
     unsigned int getTitleBarHoveredColor() const override;
 
     bool drawPinExtras(const Pin* pin, int pinNumber) override;
+    void snapshotParameters() override;
+    bool hashParameters(Hasher& hasher) const override;
     void _evaluate() override;
 };
@@ -0,0 +1,186 @@
+#include "viewer_staging.hpp"
+
+#include "node_utils.hpp"
+
+#define STAGING_BLOCK_SIZE_2D 16
+#define MAX_DOWNSAMPLE_TAPS 4 // per axis, larger footprints are strided
+
+// inTex is a crop of the visible region, so it's read through (x, y) accessors only
+__global__ void kernDownsampleToLdr(Texture inTex, glm::ivec2 outRes, uchar4* outPixels)
+{
+    const int x = (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = (blockIdx.y * blockDim.y) + threadIdx.y;
+
+    if (x >= outRes.x || y >= outRes.y)
+    {
+        return;
+    }
+
+    // source footprint of this output pixel
+    const glm::vec2 scale = glm::vec2(inTex.resolution) / glm::vec2(outRes);
+    const glm::ivec2 footprintMin = glm::ivec2(glm::vec2(x, y) * scale);
+    const glm::ivec2 footprintMax = glm::clamp(glm::ivec2(glm::vec2(x + 1, y + 1) * scale), footprintMin + 1, inTex.resolution);
+    const glm::ivec2 step = glm::max((footprintMax - footprintMin) / MAX_DOWNSAMPLE_TAPS, glm::ivec2(1));
+
+    glm::vec4 sum(0.f);
+    int numSamples = 0;
+    for (int sy = footprintMin.y; sy < footprintMax.y; sy += step.y)
+    {
+        for (int sx = footprintMin.x; sx < footprintMax.x; sx += step.x)
+        {
+            sum += inTex.getColor<TextureType::MULTI>(sx, sy);
+            ++numSamples;
+        }
+    }
+
+    const glm::vec4 col = glm::clamp(sum / (float)numSamples, 0.f, 1.f) * 255.99f;
+    outPixels[y * outRes.x + x] = make_uchar4(col.r, col.g, col.b, col.a);
+}
+
+void ViewerStaging::init()
+{
+    glActiveTexture(GL_TEXTURE0);
+    glGenTextures(1, &viewerTex);
+    glBindTexture(GL_TEXTURE_2D, viewerTex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+
+    for (auto& buffer : buffers)
+    {
+        CUDA_CHECK(cudaEventCreateWithFlags(&buffer.readyEvent, cudaEventDisableTiming));
+    }
+}
+
+void ViewerStaging::free()
+{
+    for (auto& buffer : buffers)
+    {
+        if (buffer.host_pixels != nullptr)
+        {
+            CUDA_CHECK(cudaFreeHost(buffer.host_pixels));
+            buffer.host_pixels = nullptr;
+        }
+
+        CUDA_CHECK(cudaEventDestroy(buffer.readyEvent));
+    }
+
+    CUDA_CHECK(cudaFree(dev_ldrPixels));
+    dev_ldrPixels = nullptr;
+}
+
+GLuint ViewerStaging::getTextureId() const
+{
+    return this->viewerTex;
+}
+
+glm::vec2 ViewerStaging::getUvMin() const
+{
+    return this->viewerTexUvMin;
+}
+
+glm::vec2 ViewerStaging::getUvMax() const
+{
+    return this->viewerTexUvMax;
+}
+
+void ViewerStaging::stage(Texture* tex, const ImageRegion& region, glm::ivec2 ldrResolution)
+{
+    if (region.isEmpty())
+    {
+        return;
+    }
+
+    const glm::ivec2 regionSize = region.getSize();
+    const bool isLdr = ldrResolution.x > 0 && ldrResolution.y > 0;
+    const glm::ivec2 resolution = isLdr ? glm::clamp(ldrResolution, glm::ivec2(1), regionSize) : regionSize;
+    const size_t sizeBytes = (size_t)resolution.x * resolution.y * (isLdr ? sizeof(uchar4) : sizeof(glm::vec4));
+
+    const Texture regionTex = tex->getCropView(region);
+
+    StagingBuffer& buffer = buffers[writeIdx];
+
+    // the buffer may still be the source of an earlier copy that was never uploaded
+    CUDA_CHECK(cudaEventSynchronize(buffer.readyEvent));
+
+    if (buffer.capacityBytes < sizeBytes)
+    {
+        if (buffer.host_pixels != nullptr)
+        {
+            CUDA_CHECK(cudaFreeHost(buffer.host_pixels));
+        }
+
+        CUDA_CHECK(cudaMallocHost(&buffer.host_pixels, sizeBytes));
+        buffer.capacityBytes = sizeBytes;
+    }
+
+    if (isLdr)
+    {
+        if (ldrCapacityBytes < sizeBytes)
+        {
+            CUDA_CHECK(cudaFree(dev_ldrPixels));
+            CUDA_CHECK(cudaMalloc(&dev_ldrPixels, sizeBytes));
+            ldrCapacityBytes = sizeBytes;
+        }
+
+        const dim3 blockSize(STAGING_BLOCK_SIZE_2D, STAGING_BLOCK_SIZE_2D);
+        const dim3 blocksPerGrid = calculateNumBlocksPerGrid(resolution, blockSize);
+        kernDownsampleToLdr<<<blocksPerGrid, blockSize>>>(regionTex, resolution, static_cast<uchar4*>(dev_ldrPixels));
+
+        CUDA_CHECK(cudaMemcpyAsync(buffer.host_pixels, dev_ldrPixels, sizeBytes, cudaMemcpyDeviceToHost));
+    }
+    else
+    {
+        CUDA_CHECK(cudaMemcpy2DAsync(
+            buffer.host_pixels, regionSize.x * sizeof(glm::vec4),
+            regionTex.getDevPixels<TextureType::MULTI>(), regionTex.getRowPitchBytes(),
+            regionSize.x * sizeof(glm::vec4), regionSize.y,
+            cudaMemcpyDeviceToHost
+        ));
+    }
+
+    CUDA_CHECK(cudaEventRecord(buffer.readyEvent));
+
+    buffer.resolution = resolution;
+    buffer.isLdr = isLdr;
+    buffer.uvMin = glm::vec2(region.min) / glm::vec2(tex->resolution);
+    buffer.uvMax = glm::vec2(region.max) / glm::vec2(tex->resolution);
+
+    pendingIdx = writeIdx;
+    writeIdx = 1 - writeIdx;
+}
+
+void ViewerStaging::upload()
+{
+    if (pendingIdx == -1)
+    {
+        return;
+    }
+
+    const StagingBuffer& buffer = buffers[pendingIdx];
+    pendingIdx = -1;
+
+    CUDA_CHECK(cudaEventSynchronize(buffer.readyEvent));
+
+    const GLenum pixelType = buffer.isLdr ? GL_UNSIGNED_BYTE : GL_FLOAT;
+
+    viewerTexUvMin = buffer.uvMin;
+    viewerTexUvMax = buffer.uvMax;
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, viewerTex);
+
+    if (buffer.resolution != viewerTexResolution || buffer.isLdr != isViewerTexLdr)
+    {
+        const GLint internalFormat = buffer.isLdr ? GL_RGBA8 : GL_RGBA32F;
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, buffer.resolution.x, buffer.resolution.y, 0, GL_RGBA, pixelType, buffer.host_pixels);
+
+        viewerTexResolution = buffer.resolution;
+        isViewerTexLdr = buffer.isLdr;
+    }
+    else
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, buffer.resolution.x, buffer.resolution.y, GL_RGBA, pixelType, buffer.host_pixels);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "texture.hpp"
+#include "image_region.hpp"
+
+#include "cuda_includes.hpp"
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+
+// copies the output texture into the viewer's OpenGL texture through persistent pinned buffers
+// - two staging buffers are alternated so a new frame can be copied while the previous one is still waiting to be uploaded
+// - the viewer texture is only reallocated when its size or format changes, otherwise it's updated in place
+// - optionally, the output is downsampled on the GPU to the on-screen size and stored as 8-bit before copying
+class ViewerStaging
+{
+private:
+    struct StagingBuffer
+    {
+        void* host_pixels{ nullptr };
+        size_t capacityBytes{ 0 };
+        cudaEvent_t readyEvent{};
+
+        glm::ivec2 resolution{ 0, 0 };
+        bool isLdr{ false };
+        glm::vec2 uvMin{ 0.f }, uvMax{ 1.f };
+    };
+
+    StagingBuffer buffers[2];
+    int writeIdx{ 0 };
+    int pendingIdx{ -1 }; // buffer holding the newest frame that hasn't been uploaded yet
+
+    void* dev_ldrPixels{ nullptr };
+    size_t ldrCapacityBytes{ 0 };
+
+    GLuint viewerTex{ 0 };
+    glm::ivec2 viewerTexResolution{ 0, 0 };
+    bool isViewerTexLdr{ false };
+    glm::vec2 viewerTexUvMin{ 0.f }, viewerTexUvMax{ 1.f }; // part of the output image the viewer texture shows
+
+public:
+    void init();
+    void free();
+
+    GLuint getTextureId() const;
+    glm::vec2 getUvMin() const;
+    glm::vec2 getUvMax() const;
+
+    // enqueues a copy of region of tex into the next staging buffer without waiting for it
+    // if ldrResolution is nonzero, the copy is box filtered down to that resolution (never up) and stored as 8-bit RGBA
+    void stage(Texture* tex, const ImageRegion& region, glm::ivec2 ldrResolution);
+
+    // uploads the newest staged frame, if any, to the viewer texture
+    // must be called from the thread that owns the OpenGL context
+    void upload();
+};
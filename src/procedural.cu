@@ -0,0 +1,34 @@
+#include "procedural.hpp"
+
+#include "texture.hpp"
+#include "nodes/node_utils.hpp"
+
+#define MATERIALIZE_BLOCK_SIZE_2D 16
+
+template<TextureType type>
+__global__ void kernMaterialize(Texture procTex, Texture outTex, ImageRegion region)
+{
+    const int x = region.min.x + (blockIdx.x * blockDim.x) + threadIdx.x;
+    const int y = region.min.y + (blockIdx.y * blockDim.y) + threadIdx.y;
+
+    if (x >= region.max.x || y >= region.max.y)
+    {
+        return;
+    }
+
+    outTex.storeColor<type>(x, y, procTex.fetchColor<TextureKind::PROCEDURAL, type>(x, y));
+}
+
+void Procedural::materialize(const Texture& procTex, Texture& outTex, const ImageRegion& region)
+{
+    const dim3 blockSize(MATERIALIZE_BLOCK_SIZE_2D, MATERIALIZE_BLOCK_SIZE_2D);
+    const dim3 blocksPerGrid = calculateNumBlocksPerGrid(region, blockSize);
+    if (procTex.getProceduralTextureType() == TextureType::SINGLE)
+    {
+        kernMaterialize<TextureType::SINGLE><<<blocksPerGrid, blockSize>>>(procTex, outTex, region);
+    }
+    else
+    {
+        kernMaterialize<TextureType::MULTI><<<blocksPerGrid, blockSize>>>(procTex, outTex, region);
+    }
+}
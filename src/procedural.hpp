@@ -0,0 +1,130 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include "cuda_includes.hpp"
+
+#include "image_region.hpp"
+
+#include <cstdint>
+
+struct Texture;
+
+// procedural textures are functions of the pixel position instead of buffers, pointwise kernels sample them inline through
+// Texture::fetchColor() and anything else gets them materialized (see Node::setReadsProceduralInputs())
+enum class ProceduralType
+{
+    NONE, UV_GRADIENT, NOISE, TILED_NOISE
+};
+
+struct NoiseParams
+{
+    float frequency; // lattice cells per pixel at the texture's resolution for the first octave
+    int octaves;
+    float lacunarity; // a whole number when tiling
+    float gain;
+    uint32_t seed;
+    int period; // lattice cells per tile for the first octave, only read when tiling
+};
+
+struct ProceduralFunction
+{
+    ProceduralType type{ ProceduralType::NONE };
+    NoiseParams noise{};
+};
+
+namespace Procedural
+{
+    // lowbias32 finalizer over the lattice point and seed, cheap enough to not need a permutation table
+    __host__ __device__ inline uint32_t hashLattice(int x, int y, uint32_t seed)
+    {
+        uint32_t h = seed * 0x9e3779b9u ^ (uint32_t)x * 0x85ebca6bu ^ (uint32_t)y * 0xc2b2ae35u;
+        h ^= h >> 16;
+        h *= 0x7feb352du;
+        h ^= h >> 15;
+        h *= 0x846ca68bu;
+        h ^= h >> 16;
+        return h;
+    }
+
+    // one of 8 directions, diagonals and axes all have length sqrt(2)
+    __host__ __device__ inline float gradientDot(uint32_t h, float dx, float dy)
+    {
+        const float sx = (h & 1) ? -1.f : 1.f;
+        const float sy = (h & 2) ? -1.f : 1.f;
+        const float diagonal = sx * dx + sy * dy;
+        const float axis = (h & 8) ? sx * dx : sy * dy;
+        return (h & 4) ? axis * 1.41421356f : diagonal;
+    }
+
+    __host__ __device__ inline float fade(float t)
+    {
+        return t * t * t * (t * (t * 6.f - 15.f) + 10.f);
+    }
+
+    __host__ __device__ inline int wrapLattice(int i, int period)
+    {
+        const int m = i % period;
+        return m < 0 ? m + period : m;
+    }
+
+    // gradient noise in roughly [-1, 1], lattice coordinates wrap every period cells if isTiling
+    template<bool isTiling>
+    __host__ __device__ inline float gradientNoise(glm::vec2 p, uint32_t seed, int period)
+    {
+        const glm::vec2 cell = glm::floor(p);
+        const glm::vec2 f = p - cell;
+
+        int x0 = (int)cell.x;
+        int y0 = (int)cell.y;
+        int x1 = x0 + 1;
+        int y1 = y0 + 1;
+        if constexpr (isTiling)
+        {
+            x0 = wrapLattice(x0, period);
+            y0 = wrapLattice(y0, period);
+            x1 = wrapLattice(x1, period);
+            y1 = wrapLattice(y1, period);
+        }
+
+        const float n00 = gradientDot(hashLattice(x0, y0, seed), f.x, f.y);
+        const float n10 = gradientDot(hashLattice(x1, y0, seed), f.x - 1.f, f.y);
+        const float n01 = gradientDot(hashLattice(x0, y1, seed), f.x, f.y - 1.f);
+        const float n11 = gradientDot(hashLattice(x1, y1, seed), f.x - 1.f, f.y - 1.f);
+
+        const float u = fade(f.x);
+        const float v = fade(f.y);
+        return glm::mix(glm::mix(n00, n10, u), glm::mix(n01, n11, u), v);
+    }
+
+    template<bool isTiling>
+    __host__ __device__ inline float fbm(int x, int y, const NoiseParams& params)
+    {
+        glm::vec2 p = glm::vec2(x, y) * params.frequency;
+        int period = params.period;
+        uint32_t seed = params.seed;
+        float amplitude = 1.f;
+        float totalAmplitude = 0.f;
+        float noise = 0.f;
+        for (int octave = 0; octave < params.octaves; ++octave)
+        {
+            noise += gradientNoise<isTiling>(p, seed, period) * amplitude;
+            totalAmplitude += amplitude;
+
+            p *= params.lacunarity;
+            period *= (int)params.lacunarity;
+            seed += 0x68e31da4u; // decorrelate octaves so they don't line up at the origin
+            amplitude *= params.gain;
+        }
+
+        // normalize so the output range doesn't depend on octaves and gain
+        return noise / totalAmplitude;
+    }
+
+    __host__ __device__ inline glm::vec4 uvGradient(int x, int y, glm::ivec2 resolution)
+    {
+        return glm::vec4(glm::vec2(x, y) / glm::vec2(resolution), 0, 1);
+    }
+
+    // writes region of a procedural texture into outTex, which has to be a dense interleaved texture of the same resolution
+    void materialize(const Texture& procTex, Texture& outTex, const ImageRegion& region);
+}
@@ -6,5 +6,6 @@
 
 #define TINYEXR_USE_MINIZ 0
 #define TINYEXR_USE_STB_ZLIB 1
+#define TINYEXR_USE_THREAD 1
 #define TINYEXR_IMPLEMENTATION
 #include "tinyexr.h"
\ No newline at end of file
@@ -4,8 +4,13 @@
 #include "cuda_includes.hpp"
 
 #include "color_utils.hpp"
+#include "image_region.hpp"
+#include "procedural.hpp"
 
+#include <cassert>
+#include <cstdint>
 #include <functional>
+#include <type_traits>
 
 struct ResolutionHash
 {
@@ -20,6 +25,30 @@ enum class TextureType
     SINGLE, MULTI
 };
 
+// planar MULTI textures keep each channel contiguous, so channel views of them are dense
+// only reachable through getColor() and setColor(), anything reading raw pointers expects interleaved pixels
+enum class TextureLayout
+{
+    INTERLEAVED, PLANAR
+};
+
+// what a kernel needs to know about a texture to read it without branching per pixel, see Texture::dispatchKinds()
+enum class TextureKind
+{
+    UNIFORM, SINGLE, MULTI, PLANAR, PROCEDURAL
+};
+
+// bit masks of the channels read from a texture, see Node::getInputChannelDemand()
+namespace Channels
+{
+    static constexpr uint8_t R = 1;
+    static constexpr uint8_t G = 2;
+    static constexpr uint8_t B = 4;
+    static constexpr uint8_t A = 8;
+    static constexpr uint8_t RGB = R | G | B;
+    static constexpr uint8_t RGBA = RGB | A;
+}
+
 struct Texture
 {
 public:
@@ -36,30 +65,166 @@ public:
 private:
     float* dev_pixelsSingle{ nullptr };
     glm::vec4* dev_pixelsMulti{ nullptr };
+    float* dev_pixelsPlanar{ nullptr }; // MULTI with TextureLayout::PLANAR
     glm::vec4 uniformColor{ 0, 0, 0, 1 };
+    ProceduralFunction procedural{}; // set instead of any array, see makeProcedural()
+
+    // in elements of whichever array is set, dense textures have pixelStride = 1 and rowPitch = resolution.x
+    // channel views of interleaved textures step over the other channels and crop views keep their parent's rows
+    int pixelStride{ 1 };
+    int rowPitch{ 0 };
+    int planePitch{ 0 }; // floats between the planes of a planar texture
+
+    // SINGLE textures standing in for a MULTI output that's only read in one channel keep just that channel
+    // set by Node::requestOutputTexture(), -1 otherwise
+    int narrowedChannel{ -1 };
+
+    Texture* viewParent{ nullptr }; // owner of the memory a view points into
 
 public:
     glm::ivec2 resolution{ 0, 0 };
     int numReferences{ 0 };
 
-    template<TextureType type>
+    template<TextureType type, TextureLayout layout = TextureLayout::INTERLEAVED>
     __host__ inline void malloc(glm::ivec2 resolution)
     {
         this->resolution = resolution;
+        this->pixelStride = 1;
+        this->rowPitch = resolution.x;
+
+        const size_t numPixels = (size_t)resolution.x * resolution.y;
         if constexpr (type == TextureType::SINGLE)
         {
-            CUDA_CHECK(cudaMalloc(&dev_pixelsSingle, resolution.x * resolution.y * sizeof(float)));
+            CUDA_CHECK(cudaMalloc(&dev_pixelsSingle, numPixels * sizeof(float)));
+        }
+        else if constexpr (layout == TextureLayout::PLANAR)
+        {
+            this->planePitch = numPixels;
+            CUDA_CHECK(cudaMalloc(&dev_pixelsPlanar, numPixels * 4 * sizeof(float)));
         }
         else
         {
-            CUDA_CHECK(cudaMalloc(&dev_pixelsMulti, resolution.x * resolution.y * sizeof(glm::vec4)));
+            CUDA_CHECK(cudaMalloc(&dev_pixelsMulti, numPixels * sizeof(glm::vec4)));
         }
     }
 
     __host__ inline void free()
     {
+        if (isView()) // the memory belongs to the parent
+        {
+            return;
+        }
+
         CUDA_CHECK(cudaFree(dev_pixelsSingle));
         CUDA_CHECK(cudaFree(dev_pixelsMulti));
+        CUDA_CHECK(cudaFree(dev_pixelsPlanar));
+    }
+
+    __host__ __device__ inline bool isView() const
+    {
+        return viewParent != nullptr;
+    }
+
+    __host__ inline Texture* getViewParent() const
+    {
+        return viewParent;
+    }
+
+    __host__ __device__ inline TextureLayout getLayout() const
+    {
+        return dev_pixelsPlanar != nullptr ? TextureLayout::PLANAR : TextureLayout::INTERLEAVED;
+    }
+
+    __host__ inline void setNarrowedChannel(int channel)
+    {
+        narrowedChannel = channel;
+    }
+
+    // a function of the pixel position at the given resolution instead of a buffer
+    // to propagate one, wrap it with NodeEvaluator::requestProcedural()
+    __host__ static inline Texture makeProcedural(const ProceduralFunction& function, glm::ivec2 resolution)
+    {
+        Texture tex;
+        tex.resolution = resolution;
+        tex.rowPitch = resolution.x;
+        tex.procedural = function;
+        return tex;
+    }
+
+    __host__ __device__ inline bool isProcedural() const
+    {
+        return procedural.type != ProceduralType::NONE;
+    }
+
+    // of the buffer a procedural texture is materialized into
+    __host__ inline TextureType getProceduralTextureType() const
+    {
+        return procedural.type == ProceduralType::UV_GRADIENT ? TextureType::MULTI : TextureType::SINGLE;
+    }
+
+    // views are lightweight and can be passed to kernels as they are
+    // to propagate one, wrap it with NodeEvaluator::requestView() so the parent stays alive while it's referenced
+
+    // single channel of a MULTI texture without copying it, channel is 0 to 3 for RGBA
+    __host__ inline Texture getChannelView(int channel) const
+    {
+        Texture view;
+        view.resolution = this->resolution;
+        view.viewParent = this->isView() ? this->viewParent : const_cast<Texture*>(this);
+
+        if (dev_pixelsPlanar != nullptr)
+        {
+            view.dev_pixelsSingle = dev_pixelsPlanar + (size_t)channel * planePitch;
+            view.pixelStride = this->pixelStride;
+            view.rowPitch = this->rowPitch;
+        }
+        else
+        {
+            view.dev_pixelsSingle = reinterpret_cast<float*>(dev_pixelsMulti) + channel;
+            view.pixelStride = this->pixelStride * 4;
+            view.rowPitch = this->rowPitch * 4;
+        }
+
+        return view;
+    }
+
+    // part of a texture without copying it, region has to be within the texture
+    // rows of a crop aren't contiguous, so it can only be read through the (x, y) accessors and can't be propagated
+    // to other nodes, which may index it linearly (see hasContiguousRows())
+    __host__ inline Texture getCropView(const ImageRegion& region) const
+    {
+        Texture view = *this;
+        view.numReferences = 0;
+        view.resolution = region.getSize();
+        view.viewParent = this->isView() ? this->viewParent : const_cast<Texture*>(this);
+
+        const size_t offset = (size_t)region.min.y * rowPitch + (size_t)region.min.x * pixelStride;
+        if (dev_pixelsSingle != nullptr)
+        {
+            view.dev_pixelsSingle += offset;
+        }
+        else if (dev_pixelsMulti != nullptr)
+        {
+            view.dev_pixelsMulti += offset;
+        }
+        else
+        {
+            view.dev_pixelsPlanar += offset;
+        }
+
+        return view;
+    }
+
+    // false only for crop views narrower than their parent
+    __host__ __device__ inline bool hasContiguousRows() const
+    {
+        return rowPitch == resolution.x * pixelStride;
+    }
+
+    // distance between rows in bytes, for copies that have to respect a crop's parent rows
+    __host__ inline size_t getRowPitchBytes() const
+    {
+        return (size_t)rowPitch * (dev_pixelsMulti != nullptr ? sizeof(glm::vec4) : sizeof(float));
     }
 
     __host__ __device__ inline int getNumPixels()
@@ -67,6 +232,28 @@ public:
         return resolution.x * resolution.y;
     }
 
+    template<TextureType type>
+    __host__ static inline size_t getNumBytes(glm::ivec2 resolution)
+    {
+        return (size_t)resolution.x * resolution.y * (type == TextureType::SINGLE ? sizeof(float) : sizeof(glm::vec4));
+    }
+
+    __host__ inline size_t getNumBytes() const
+    {
+        if (isView())
+        {
+            return 0;
+        }
+
+        if (dev_pixelsSingle != nullptr)
+        {
+            return getNumBytes<TextureType::SINGLE>(resolution);
+        }
+
+        return dev_pixelsMulti != nullptr || dev_pixelsPlanar != nullptr ? getNumBytes<TextureType::MULTI>(resolution) : 0;
+    }
+
+    // dense interleaved textures only, check isView() and getLayout() first if the texture isn't one this node requested
     template<TextureType type>
     __host__ __device__ auto getDevPixels() const
     {
@@ -89,7 +276,7 @@ public:
         }
         else
         {
-            return dev_pixelsMulti != nullptr;
+            return dev_pixelsMulti != nullptr || dev_pixelsPlanar != nullptr;
         }
     }
 
@@ -133,36 +320,93 @@ private:
         }
     }
 
-public:
+    // elementIdx is an offset into whichever array is set, in that array's elements
     template<TextureType type>
-    __device__ inline auto getColor(int idx)
+    __device__ inline auto readElement(size_t elementIdx)
     {
         if (dev_pixelsSingle != nullptr)
         {
-            return convertTo<type>(dev_pixelsSingle[idx]);
+            return convertTo<type>(dev_pixelsSingle[elementIdx]);
+        }
+        else if (dev_pixelsMulti != nullptr)
+        {
+            return convertTo<type>(dev_pixelsMulti[elementIdx]);
         }
         else
         {
-            return convertTo<type>(dev_pixelsMulti[idx]);
+            const float* planes = dev_pixelsPlanar + elementIdx;
+            return convertTo<type>(glm::vec4(planes[0], planes[planePitch], planes[2 * planePitch], planes[3 * planePitch]));
         }
     }
 
+    template<TextureType type>
+    __device__ inline void writeElement(size_t elementIdx, auto col)
+    {
+        if constexpr (type == TextureType::SINGLE)
+        {
+            dev_pixelsSingle[elementIdx] = convertTo<type>(col);
+        }
+        else
+        {
+            const glm::vec4 multiCol = convertTo<type>(col);
+            if (dev_pixelsMulti != nullptr)
+            {
+                dev_pixelsMulti[elementIdx] = multiCol;
+            }
+            else
+            {
+                float* planes = dev_pixelsPlanar + elementIdx;
+                planes[0] = multiCol.r;
+                planes[planePitch] = multiCol.g;
+                planes[2 * planePitch] = multiCol.b;
+                planes[3 * planePitch] = multiCol.a;
+            }
+        }
+    }
+
+    // the switch is the same for every thread, so it doesn't diverge
+    template<TextureType type>
+    __device__ inline auto sampleProcedural(int x, int y)
+    {
+        switch (procedural.type)
+        {
+        case ProceduralType::UV_GRADIENT:
+            return convertTo<type>(Procedural::uvGradient(x, y, resolution));
+        case ProceduralType::NOISE:
+            return convertTo<type>(Procedural::fbm<false>(x, y, procedural.noise));
+        case ProceduralType::TILED_NOISE:
+            return convertTo<type>(Procedural::fbm<true>(x, y, procedural.noise));
+        default:
+            return convertTo<type>(uniformColor);
+        }
+    }
+
+public:
+    // linear indices assume contiguous rows, which holds for everything except crop views
+    template<TextureType type>
+    __device__ inline auto getColor(int idx)
+    {
+        assert(hasContiguousRows());
+        return readElement<type>((size_t)idx * pixelStride);
+    }
+
     template<TextureType type>
     __device__ inline auto getColor(int x, int y)
     {
-        return getColor<type>(y * resolution.x + x);
+        return readElement<type>((size_t)y * rowPitch + (size_t)x * pixelStride);
     }
 
     template<TextureType type>
     __device__ inline void setColor(int idx, auto col)
     {
-        getDevPixels<type>()[idx] = convertTo<type>(col);
+        assert(hasContiguousRows());
+        writeElement<type>((size_t)idx * pixelStride, col);
     }
 
     template<TextureType type>
     __device__ inline void setColor(int x, int y, auto col)
     {
-        setColor<type>(y * resolution.x + x, col);
+        writeElement<type>((size_t)y * rowPitch + (size_t)x * pixelStride, col);
     }
 
     template<TextureType type>
@@ -194,5 +438,128 @@ public:
         return getColor<type>(x, y);
     }
 
+    __host__ __device__ inline TextureKind getKind() const
+    {
+        if (resolution.x == 0)
+        {
+            return TextureKind::UNIFORM;
+        }
+        else if (isProcedural())
+        {
+            return TextureKind::PROCEDURAL;
+        }
+        else if (dev_pixelsSingle != nullptr)
+        {
+            return TextureKind::SINGLE;
+        }
+        else if (dev_pixelsMulti != nullptr)
+        {
+            return TextureKind::MULTI;
+        }
+        else
+        {
+            return TextureKind::PLANAR;
+        }
+    }
+
+    // same as getColor() but with the storage resolved at compile time, so the only per pixel work is the load itself
+    template<TextureKind kind, TextureType type>
+    __device__ inline auto fetchColor(int x, int y)
+    {
+        const size_t elementIdx = (size_t)y * rowPitch + (size_t)x * pixelStride;
+        if constexpr (kind == TextureKind::UNIFORM)
+        {
+            return convertTo<type>(uniformColor);
+        }
+        else if constexpr (kind == TextureKind::SINGLE)
+        {
+            return convertTo<type>(dev_pixelsSingle[elementIdx]);
+        }
+        else if constexpr (kind == TextureKind::MULTI)
+        {
+            return convertTo<type>(dev_pixelsMulti[elementIdx]);
+        }
+        else if constexpr (kind == TextureKind::PROCEDURAL)
+        {
+            return sampleProcedural<type>(x, y);
+        }
+        else
+        {
+            const float* planes = dev_pixelsPlanar + elementIdx;
+            return convertTo<type>(glm::vec4(planes[0], planes[planePitch], planes[2 * planePitch], planes[3 * planePitch]));
+        }
+    }
+
+    // same as getColorClamp(), the load is clamped to the texture and its result selected against backup instead of branching around it
+    template<TextureKind kind, TextureType type>
+    __device__ inline auto fetchColorClamp(int x, int y, glm::vec4 backup = glm::vec4(0, 0, 0, 1))
+    {
+        if constexpr (kind == TextureKind::UNIFORM)
+        {
+            return convertTo<type>(uniformColor);
+        }
+        else
+        {
+            const bool isInside = x < resolution.x && y < resolution.y;
+            const auto col = fetchColor<kind, type>(glm::min(x, resolution.x - 1), glm::min(y, resolution.y - 1));
+            return isInside ? col : convertTo<type>(backup);
+        }
+    }
+
+    // for textures a node requested itself, which are always dense and interleaved (see Node::requestOutputTexture())
+    template<TextureType type>
+    __device__ inline void storeColor(int x, int y, auto col)
+    {
+        const size_t elementIdx = (size_t)y * rowPitch + x;
+        if constexpr (type == TextureType::SINGLE)
+        {
+            dev_pixelsSingle[elementIdx] = convertTo<type>(col);
+        }
+        else if (dev_pixelsMulti != nullptr)
+        {
+            dev_pixelsMulti[elementIdx] = convertTo<type>(col);
+        }
+        else // narrowed, the same for every thread of a launch
+        {
+            dev_pixelsSingle[elementIdx] = convertTo<type>(col)[narrowedChannel];
+        }
+    }
+
+    // calls f with one std::integral_constant<TextureKind, ...> per texture, in order
+    // kernels templated on those kinds are instantiated for every combination, so keep the number of textures small
+    template<typename F>
+    __host__ static inline void dispatchKinds(F&& f)
+    {
+        f();
+    }
+
+    template<typename F, typename... Rest>
+    __host__ static inline void dispatchKinds(F&& f, const Texture& tex, const Rest&... rest)
+    {
+        const auto next = [&](auto kind)
+        {
+            dispatchKinds([&](auto... kinds) { f(kind, kinds...); }, rest...);
+        };
+
+        switch (tex.getKind())
+        {
+        case TextureKind::UNIFORM:
+            next(std::integral_constant<TextureKind, TextureKind::UNIFORM>{});
+            break;
+        case TextureKind::SINGLE:
+            next(std::integral_constant<TextureKind, TextureKind::SINGLE>{});
+            break;
+        case TextureKind::MULTI:
+            next(std::integral_constant<TextureKind, TextureKind::MULTI>{});
+            break;
+        case TextureKind::PLANAR:
+            next(std::integral_constant<TextureKind, TextureKind::PLANAR>{});
+            break;
+        case TextureKind::PROCEDURAL:
+            next(std::integral_constant<TextureKind, TextureKind::PROCEDURAL>{});
+            break;
+        }
+    }
+
     static glm::ivec2 getFirstResolutionFromList(std::initializer_list<Texture*> textures);
 };
@@ -0,0 +1,473 @@
+#include "thread_utils.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace ThreadUtils
+{
+    struct Task
+    {
+        std::function<void()> func;
+
+        std::atomic<int> numPendingDependencies{ 0 };
+        std::atomic<bool> isDone{ false };
+
+        std::mutex mutex; // guards dependents and the transition to done
+        std::vector<TaskHandle> dependents;
+    };
+
+    // each worker pushes and pops at the back of its own queue and steals from the front of the others'
+    // that keeps a worker on the work it just split off (still in cache) while thieves take the oldest, largest pieces
+    class ThreadPool
+    {
+    private:
+        struct WorkerQueue
+        {
+            std::mutex mutex;
+            std::deque<TaskHandle> tasks;
+        };
+
+        static thread_local int workerIdx; // -1 on threads outside the pool
+
+        const int numThreads;
+        std::vector<std::unique_ptr<WorkerQueue>> queues; // one per worker, then one shared by outside threads
+        std::vector<std::thread> workers;
+
+        // sleeping workers and waiting threads all block on this, woken whenever a task is queued or finishes
+        std::mutex stateMutex;
+        std::condition_variable stateChanged;
+        int numQueuedTasks{ 0 };
+        bool isStopping{ false };
+
+    public:
+        ThreadPool(const PoolConfig& config)
+            : numThreads(config.numThreads > 0 ? config.numThreads : std::max((int)std::thread::hardware_concurrency(), 1))
+        {
+            // the thread waiting on a loop works on it too, so it counts as one of the threads
+            const int numWorkers = std::max(numThreads - 1, 1);
+
+            for (int i = 0; i < numWorkers + 1; ++i)
+            {
+                queues.push_back(std::make_unique<WorkerQueue>());
+            }
+
+            for (int i = 0; i < numWorkers; ++i)
+            {
+                workers.emplace_back([this, i, config]
+                {
+                    workerIdx = i;
+                    if (config.pinThreads)
+                    {
+                        pinToCore(i + 1);
+                    }
+                    workerLoop();
+                });
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                isStopping = true;
+            }
+            stateChanged.notify_all();
+
+            for (auto& worker : workers)
+            {
+                worker.join();
+            }
+        }
+
+        int getNumThreads() const
+        {
+            return numThreads;
+        }
+
+        void push(TaskHandle task)
+        {
+            WorkerQueue& queue = *queues[workerIdx >= 0 ? workerIdx : queues.size() - 1];
+            {
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.tasks.push_back(std::move(task));
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                ++numQueuedTasks;
+            }
+            stateChanged.notify_all();
+        }
+
+        // runs one queued task if there is one, returns false otherwise
+        bool tryRunTask()
+        {
+            TaskHandle task = pop();
+            if (task == nullptr)
+            {
+                return false;
+            }
+
+            task->func();
+            task->func = nullptr; // releases captures now rather than when the last handle goes away
+            finish(task);
+            return true;
+        }
+
+        void waitUntil(const std::function<bool()>& isDone)
+        {
+            while (!isDone())
+            {
+                if (tryRunTask())
+                {
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(stateMutex);
+                stateChanged.wait(lock, [&] { return numQueuedTasks > 0 || isDone(); });
+            }
+        }
+
+    private:
+        static void pinToCore(int core)
+        {
+            const int numCores = std::max((int)std::thread::hardware_concurrency(), 1);
+            core %= numCores;
+#ifdef _WIN32
+            if (core < 64)
+            {
+                SetThreadAffinityMask(GetCurrentThread(), 1ull << core);
+            }
+#elif defined(__linux__)
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            CPU_SET(core, &cpuSet);
+            pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#endif
+        }
+
+        TaskHandle pop()
+        {
+            const int numQueues = queues.size();
+            const int ownIdx = workerIdx >= 0 ? workerIdx : numQueues - 1;
+
+            for (int i = 0; i < numQueues; ++i)
+            {
+                const int queueIdx = (ownIdx + i) % numQueues;
+                const bool isOwnQueue = i == 0;
+
+                WorkerQueue& queue = *queues[queueIdx];
+                std::unique_lock<std::mutex> lock(queue.mutex);
+                if (queue.tasks.empty())
+                {
+                    continue;
+                }
+
+                TaskHandle task;
+                if (isOwnQueue)
+                {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                }
+                else
+                {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+                lock.unlock();
+
+                std::lock_guard<std::mutex> stateLock(stateMutex);
+                --numQueuedTasks;
+                return task;
+            }
+
+            return nullptr;
+        }
+
+        void finish(const TaskHandle& task)
+        {
+            std::vector<TaskHandle> dependents;
+            {
+                std::lock_guard<std::mutex> lock(task->mutex);
+                task->isDone = true;
+                dependents.swap(task->dependents);
+            }
+
+            for (auto& dependent : dependents)
+            {
+                if (--dependent->numPendingDependencies == 0)
+                {
+                    push(std::move(dependent));
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(stateMutex); // so a waiter can't miss this between checking and sleeping
+            }
+            stateChanged.notify_all();
+        }
+
+        void workerLoop()
+        {
+            while (true)
+            {
+                if (tryRunTask())
+                {
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(stateMutex);
+                stateChanged.wait(lock, [&] { return numQueuedTasks > 0 || isStopping; });
+                if (isStopping && numQueuedTasks == 0)
+                {
+                    return;
+                }
+            }
+        }
+    };
+
+    thread_local int ThreadPool::workerIdx = -1;
+
+    // ==================================================================
+    // CONFIGURATION
+    // ==================================================================
+
+    static std::mutex configMutex;
+    static PoolConfig poolConfig;
+    static bool isPoolCreated = false;
+
+    static PoolConfig readEnvironmentConfig()
+    {
+        PoolConfig config;
+
+        if (const char* numThreads = std::getenv("SDOAJALIZER_NUM_THREADS"))
+        {
+            config.numThreads = std::max(std::atoi(numThreads), 0);
+        }
+
+        if (const char* pinThreads = std::getenv("SDOAJALIZER_PIN_THREADS"))
+        {
+            config.pinThreads = std::atoi(pinThreads) != 0;
+        }
+
+        return config;
+    }
+
+    static ThreadPool& getPool()
+    {
+        static ThreadPool pool([]
+        {
+            std::lock_guard<std::mutex> lock(configMutex);
+            if (!isPoolCreated)
+            {
+                poolConfig = readEnvironmentConfig();
+            }
+            isPoolCreated = true;
+            return poolConfig;
+        }());
+        return pool;
+    }
+
+    void configure(const PoolConfig& config)
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        if (isPoolCreated)
+        {
+            printf("WARNING: thread pool is already running, ignoring new configuration\n");
+            return;
+        }
+
+        poolConfig = config;
+        isPoolCreated = true; // environment variables don't override an explicit configuration
+    }
+
+    int getNumThreads()
+    {
+        return getPool().getNumThreads();
+    }
+
+    // ==================================================================
+    // TASKS
+    // ==================================================================
+
+    TaskHandle submit(std::function<void()> func, const std::vector<TaskHandle>& dependencies)
+    {
+        auto task = std::make_shared<Task>();
+        task->func = std::move(func);
+
+        // one extra count so the task can't start while dependencies are still being added
+        task->numPendingDependencies = (int)dependencies.size() + 1;
+        for (const auto& dependency : dependencies)
+        {
+            std::lock_guard<std::mutex> lock(dependency->mutex);
+            if (dependency->isDone)
+            {
+                --task->numPendingDependencies;
+            }
+            else
+            {
+                dependency->dependents.push_back(task);
+            }
+        }
+
+        if (--task->numPendingDependencies == 0)
+        {
+            getPool().push(task);
+        }
+
+        return task;
+    }
+
+    void wait(const TaskHandle& task)
+    {
+        getPool().waitUntil([&] { return task->isDone.load(); });
+    }
+
+    // ==================================================================
+    // LOOPS
+    // ==================================================================
+
+    // shared with helper tasks that may only start after the loop has returned, so it can't live on the caller's stack
+    struct LoopState
+    {
+        std::atomic<int> nextRangeIdx{ 0 };
+        std::atomic<int> numFinishedRanges{ 0 };
+    };
+
+    static constexpr int rangesPerThread = 4;
+
+    void parallelFor(int begin, int end, const std::function<void(int, int)>& func, int minRangeSize)
+    {
+        const int count = end - begin;
+        if (count <= 0)
+        {
+            return;
+        }
+
+        ThreadPool& pool = getPool();
+        const int numThreads = pool.getNumThreads();
+        const int numRanges = std::clamp(count / std::max(minRangeSize, 1), 1, numThreads * rangesPerThread);
+        if (numRanges == 1 || numThreads == 1)
+        {
+            func(begin, end);
+            return;
+        }
+
+        auto state = std::make_shared<LoopState>();
+        const std::function<void(int, int)>* funcPtr = &func;
+
+        // every thread, the caller included, keeps claiming ranges until none are left
+        // a helper that starts after that finds nothing to do and never touches func, which may be gone by then
+        const auto runRanges = [state, funcPtr, begin, count, numRanges]
+        {
+            int rangeIdx;
+            while ((rangeIdx = state->nextRangeIdx++) < numRanges)
+            {
+                const int rangeBegin = begin + (int)(((long long)count * rangeIdx) / numRanges);
+                const int rangeEnd = begin + (int)(((long long)count * (rangeIdx + 1)) / numRanges);
+                (*funcPtr)(rangeBegin, rangeEnd);
+                ++state->numFinishedRanges;
+            }
+        };
+
+        const int numHelpers = std::min(numRanges, numThreads) - 1;
+        for (int i = 0; i < numHelpers; ++i)
+        {
+            submit(runRanges);
+        }
+
+        runRanges();
+        pool.waitUntil([&] { return state->numFinishedRanges.load() == numRanges; });
+    }
+
+    void parallelForTiles(const ImageRegion& region, glm::ivec2 tileSize, const std::function<void(const ImageRegion&)>& func)
+    {
+        if (region.isEmpty())
+        {
+            return;
+        }
+
+        tileSize = glm::max(tileSize, glm::ivec2(1));
+        const glm::ivec2 numTiles = (region.getSize() + tileSize - 1) / tileSize;
+
+        parallelFor(0, numTiles.x * numTiles.y, [&](int tileBegin, int tileEnd)
+        {
+            for (int tileIdx = tileBegin; tileIdx < tileEnd; ++tileIdx)
+            {
+                const glm::ivec2 tileMin = region.min + glm::ivec2(tileIdx % numTiles.x, tileIdx / numTiles.x) * tileSize;
+                func(ImageRegion{ tileMin, glm::min(tileMin + tileSize, region.max) });
+            }
+        });
+    }
+
+    // ==================================================================
+    // SCRATCH MEMORY
+    // ==================================================================
+
+    static constexpr size_t scratchAlignment = 64; // cache line, also enough for any SIMD type
+    static constexpr size_t minScratchBlockSize = 1 << 20;
+
+    static size_t getAlignedOffset(const std::byte* base, size_t offset)
+    {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(base) + offset;
+        return offset + (scratchAlignment - address % scratchAlignment) % scratchAlignment;
+    }
+
+    void* ScratchArena::allocateBytes(size_t numBytes)
+    {
+        while (this->blockIdx < this->blocks.size())
+        {
+            Block& block = this->blocks[this->blockIdx];
+            const size_t alignedOffset = getAlignedOffset(block.data.get(), this->offset);
+            if (alignedOffset + numBytes <= block.size)
+            {
+                this->offset = alignedOffset + numBytes;
+                return block.data.get() + alignedOffset;
+            }
+
+            ++this->blockIdx;
+            this->offset = 0;
+        }
+
+        // blocks are never moved or freed, so earlier allocations in the same scope stay valid
+        const size_t blockSize = std::max(minScratchBlockSize, numBytes + scratchAlignment);
+        auto data = std::make_unique<std::byte[]>(blockSize);
+        const size_t alignedOffset = getAlignedOffset(data.get(), 0);
+        this->blocks.push_back({ std::move(data), blockSize });
+        this->blockIdx = this->blocks.size() - 1;
+        this->offset = alignedOffset + numBytes;
+        return this->blocks.back().data.get() + alignedOffset;
+    }
+
+    ScratchArena::Scope::Scope(ScratchArena& arena)
+        : arena(arena), blockIdx(arena.blockIdx), offset(arena.offset)
+    {}
+
+    ScratchArena::Scope::~Scope()
+    {
+        this->arena.blockIdx = this->blockIdx;
+        this->arena.offset = this->offset;
+    }
+
+    ScratchArena& getScratchArena()
+    {
+        thread_local ScratchArena arena;
+        return arena;
+    }
+}
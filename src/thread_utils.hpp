@@ -0,0 +1,98 @@
+#pragma once
+
+#include "image_region.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// one work-stealing pool shared by every host loop, so nested and concurrent loops don't oversubscribe the CPU
+// sized from SDOAJALIZER_NUM_THREADS (default: all hardware threads) and pinned to cores if SDOAJALIZER_PIN_THREADS=1
+namespace ThreadUtils
+{
+    struct PoolConfig
+    {
+        int numThreads{ 0 }; // including whichever thread is waiting on the work, 0 for all hardware threads
+        bool pinThreads{ false }; // worker i runs only on core i + 1, core 0 is left to the calling thread
+    };
+
+    // has to be called before anything uses the pool, later calls are ignored with a warning
+    void configure(const PoolConfig& config);
+
+    int getNumThreads();
+
+    // ==================================================================
+    // TASKS
+    // ==================================================================
+
+    struct Task;
+    using TaskHandle = std::shared_ptr<Task>;
+
+    // runs func once every dependency has finished, dependencies that already finished are fine
+    TaskHandle submit(std::function<void()> func, const std::vector<TaskHandle>& dependencies = {});
+
+    // runs other queued tasks while waiting, so it's safe to call from inside a task
+    void wait(const TaskHandle& task);
+
+    // ==================================================================
+    // LOOPS
+    // ==================================================================
+
+    // splits [begin, end) into ranges and calls func(rangeBegin, rangeEnd) for each, returning once all of them are done
+    // ranges smaller than minRangeSize aren't worth a thread, so small inputs run on the calling thread
+    // there are a few ranges per thread so idle threads can steal the rest of a busy thread's share
+    void parallelFor(int begin, int end, const std::function<void(int, int)>& func, int minRangeSize = 1);
+
+    // calls func once per tile of region, tiles at the right and bottom edges are clipped
+    void parallelForTiles(const ImageRegion& region, glm::ivec2 tileSize, const std::function<void(const ImageRegion&)>& func);
+
+    // ==================================================================
+    // SCRATCH MEMORY
+    // ==================================================================
+
+    // per thread bump allocator for temporary buffers inside loop bodies, so they don't hit the heap every range
+    // memory is uninitialized and only valid until the enclosing Scope ends
+    class ScratchArena
+    {
+    private:
+        struct Block
+        {
+            std::unique_ptr<std::byte[]> data;
+            size_t size;
+        };
+
+        std::vector<Block> blocks;
+        size_t blockIdx{ 0 };
+        size_t offset{ 0 };
+
+        void* allocateBytes(size_t numBytes);
+
+    public:
+        class Scope
+        {
+        private:
+            ScratchArena& arena;
+            const size_t blockIdx;
+            const size_t offset;
+
+        public:
+            Scope(ScratchArena& arena);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+        };
+
+        template<typename T>
+        T* allocate(size_t count)
+        {
+            return static_cast<T*>(allocateBytes(count * sizeof(T)));
+        }
+    };
+
+    ScratchArena& getScratchArena(); // the calling thread's
+}
@@ -0,0 +1,137 @@
+#include "thread_utils.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "FAILED: %s (%s:%d)\n", #condition, __FILE__, __LINE__); \
+            return false; \
+        } \
+    } while (false)
+
+// a diamond a -> (b, c) -> d, repeated so an ordering bug has a chance to show up
+static bool testDependencyOrdering()
+{
+    for (int iteration = 0; iteration < 200; ++iteration)
+    {
+        std::mutex mutex;
+        std::vector<char> order;
+        const auto record = [&](char name)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(name);
+        };
+
+        auto a = ThreadUtils::submit([&] { record('a'); });
+        auto b = ThreadUtils::submit([&] { record('b'); }, { a });
+        auto c = ThreadUtils::submit([&] { record('c'); }, { a });
+        auto d = ThreadUtils::submit([&] { record('d'); }, { b, c });
+        ThreadUtils::wait(d);
+
+        CHECK(order.size() == 4);
+        CHECK(order.front() == 'a');
+        CHECK(order.back() == 'd');
+    }
+
+    return true;
+}
+
+static bool testFinishedDependency()
+{
+    auto first = ThreadUtils::submit([] {});
+    ThreadUtils::wait(first);
+
+    bool didRun = false;
+    auto second = ThreadUtils::submit([&] { didRun = true; }, { first });
+    ThreadUtils::wait(second);
+
+    CHECK(didRun);
+    return true;
+}
+
+// tasks that wait on other tasks and run loops of their own, which only finishes if waiting threads keep working
+static bool testNestedWaits()
+{
+    constexpr int numOuterTasks = 16;
+    constexpr int numInnerTasks = 8;
+
+    std::atomic<int> numInnerRuns{ 0 };
+    std::atomic<long long> loopSum{ 0 };
+
+    std::vector<ThreadUtils::TaskHandle> outerTasks;
+    for (int outerIdx = 0; outerIdx < numOuterTasks; ++outerIdx)
+    {
+        outerTasks.push_back(ThreadUtils::submit([&]
+        {
+            std::vector<ThreadUtils::TaskHandle> innerTasks;
+            for (int innerIdx = 0; innerIdx < numInnerTasks; ++innerIdx)
+            {
+                innerTasks.push_back(ThreadUtils::submit([&] { ++numInnerRuns; }));
+            }
+
+            for (const auto& innerTask : innerTasks)
+            {
+                ThreadUtils::wait(innerTask);
+            }
+
+            ThreadUtils::parallelFor(0, 1000, [&](int begin, int end)
+            {
+                long long sum = 0;
+                for (int i = begin; i < end; ++i)
+                {
+                    sum += i;
+                }
+                loopSum += sum;
+            });
+        }));
+    }
+
+    for (const auto& outerTask : outerTasks)
+    {
+        ThreadUtils::wait(outerTask);
+    }
+
+    CHECK(numInnerRuns == numOuterTasks * numInnerTasks);
+    CHECK(loopSum == numOuterTasks * 499500ll);
+    return true;
+}
+
+static bool testTiles()
+{
+    const ImageRegion region{ glm::ivec2(3, 5), glm::ivec2(103, 70) };
+    const glm::ivec2 size = region.getSize();
+
+    std::vector<std::atomic<int>> coverage(size.x * size.y);
+    ThreadUtils::parallelForTiles(region, glm::ivec2(16, 16), [&](const ImageRegion& tile)
+    {
+        for (int y = tile.min.y; y < tile.max.y; ++y)
+        {
+            for (int x = tile.min.x; x < tile.max.x; ++x)
+            {
+                ++coverage[(y - region.min.y) * size.x + (x - region.min.x)];
+            }
+        }
+    });
+
+    for (const auto& count : coverage)
+    {
+        CHECK(count == 1);
+    }
+
+    return true;
+}
+
+int main()
+{
+    ThreadUtils::configure({ 4, false }); // enough threads to interleave even on single core machines
+
+    const bool didPass = testDependencyOrdering() && testFinishedDependency() && testNestedWaits() && testTiles();
+    printf(didPass ? "all thread utils tests passed\n" : "thread utils tests failed\n");
+    return didPass ? 0 : 1;
+}